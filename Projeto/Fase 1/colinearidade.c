@@ -0,0 +1,451 @@
+/***
+ * @file colinearidade.c
+ * @brief Deteção das linhas com três ou mais antenas da mesma frequência: para cada antena, as direções
+ *        para as restantes são reduzidas pelo mdc e agrupadas numa tabela de dispersão, o que dá O(k²)
+ *        esperado por frequência em vez de O(k³). As frequências são repartidas por várias threads.
+ * @author David Costa
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "struct.h"
+#include "colinearidade.h"
+
+#define DIRECAO_VAZIA UINT64_MAX
+
+// Tabela de direções de uma âncora; as entradas de âncoras anteriores são reconhecidas pela geração
+typedef struct TabelaDirecoes
+{
+    uint64_t *chaves;
+    unsigned *geracao;
+    int *contagem;
+    bool *anterior;             // A direção tem uma antena de índice menor do que a âncora
+    int *linha;                 // Linha criada para a direção (-1 se ainda nenhuma)
+    size_t capacidade;
+    unsigned geracaoAtual;
+} TabelaDirecoes;
+
+// Resultados de uma thread, juntados no fim
+typedef struct ResultadosLocais
+{
+    LinhaColinear *linhas;
+    size_t numLinhas, capacidadeLinhas;
+    int *x, *y;
+    size_t numMembros, capacidadeMembros;
+    int *projecao;              // Posição de cada membro ao longo da direção, para os ordenar
+} ResultadosLocais;
+
+typedef struct EstadoColinear
+{
+    const GruposFrequencia *grupos;
+    int ordem[NUM_FREQUENCIAS]; // Frequências da maior para a menor, para equilibrar as threads
+    int numFrequencias;
+    int seguinte;
+    bool erro;
+    ContextoMemoria *contexto;  // Contexto de memória de quem chama, usado também pelas threads
+} EstadoColinear;
+
+typedef struct TrabalhoColinear
+{
+    EstadoColinear *estado;
+    ResultadosLocais res;
+} TrabalhoColinear;
+
+static int mdc(int a, int b)
+{
+    a = abs(a);
+    b = abs(b);
+    while (b != 0)
+    {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Direção de (dx, dy) reduzida e com sinal fixo, para os dois sentidos da mesma linha coincidirem
+static uint64_t chaveDirecao(int dx, int dy, int *rdx, int *rdy)
+{
+    int d = mdc(dx, dy);
+    dx /= d;
+    dy /= d;
+    if (dx < 0 || (dx == 0 && dy < 0))
+    {
+        dx = -dx;
+        dy = -dy;
+    }
+    *rdx = dx;
+    *rdy = dy;
+    return ((uint64_t)(uint32_t)dx << 32) | (uint32_t)dy;
+}
+
+static size_t procurarDirecao(TabelaDirecoes *t, uint64_t chave)
+{
+    uint64_t d = chave * 0x9E3779B97F4A7C15ULL;
+    size_t i = (size_t)(d >> 32) & (t->capacidade - 1);
+    while (t->geracao[i] == t->geracaoAtual && t->chaves[i] != chave)
+    {
+        i = (i + 1) & (t->capacidade - 1);
+    }
+    if (t->geracao[i] != t->geracaoAtual)
+    {
+        t->geracao[i] = t->geracaoAtual;
+        t->chaves[i] = chave;
+        t->contagem[i] = 0;
+        t->anterior[i] = false;
+        t->linha[i] = -1;
+    }
+    return i;
+}
+
+static bool garantirMembros(ResultadosLocais *r, size_t extra)
+{
+    if (r->numMembros + extra <= r->capacidadeMembros)
+    {
+        return true;
+    }
+    size_t nova = r->capacidadeMembros ? r->capacidadeMembros : 256;
+    while (nova < r->numMembros + extra)
+        nova *= 2;
+    int *x = (int *)realocarMemoria(r->x, nova * sizeof(int));
+    if (x == NULL)
+        return false;
+    r->x = x;
+    int *y = (int *)realocarMemoria(r->y, nova * sizeof(int));
+    if (y == NULL)
+        return false;
+    r->y = y;
+    int *p = (int *)realocarMemoria(r->projecao, nova * sizeof(int));
+    if (p == NULL)
+        return false;
+    r->projecao = p;
+    r->capacidadeMembros = nova;
+    return true;
+}
+
+static bool novaLinha(ResultadosLocais *r, char freq, int dx, int dy, size_t inicio, size_t numMembros)
+{
+    if (r->numLinhas == r->capacidadeLinhas)
+    {
+        size_t nova = r->capacidadeLinhas ? r->capacidadeLinhas * 2 : 64;
+        LinhaColinear *l = (LinhaColinear *)realocarMemoria(r->linhas, nova * sizeof(LinhaColinear));
+        if (l == NULL)
+            return false;
+        r->linhas = l;
+        r->capacidadeLinhas = nova;
+    }
+    LinhaColinear *l = &r->linhas[r->numLinhas++];
+    l->freq = freq;
+    l->dx = dx;
+    l->dy = dy;
+    l->inicio = inicio;
+    l->numMembros = numMembros;
+    return true;
+}
+
+// Ordena os membros de uma linha pela posição ao longo da direção (as linhas são curtas: inserção)
+static void ordenarMembros(ResultadosLocais *r, const LinhaColinear *l)
+{
+    for (size_t a = l->inicio + 1; a < l->inicio + l->numMembros; a++)
+    {
+        int x = r->x[a], y = r->y[a], p = r->projecao[a];
+        size_t b = a;
+        while (b > l->inicio && r->projecao[b - 1] > p)
+        {
+            r->x[b] = r->x[b - 1];
+            r->y[b] = r->y[b - 1];
+            r->projecao[b] = r->projecao[b - 1];
+            b--;
+        }
+        r->x[b] = x;
+        r->y[b] = y;
+        r->projecao[b] = p;
+    }
+}
+
+// Cada linha é encontrada a partir do seu membro de menor índice: as direções que levam a uma antena
+// anterior à âncora pertencem a linhas já registadas
+static bool linhasFrequencia(const GruposFrequencia *g, int f, TabelaDirecoes *t, int *direcaoDe, ResultadosLocais *r)
+{
+    size_t inicio = g->inicio[f], k = g->inicio[f + 1] - inicio;
+    const int *xs = g->x + inicio, *ys = g->y + inicio;
+
+    for (size_t i = 0; i + 2 < k; i++)
+    {
+        if (++t->geracaoAtual == 0)
+        {
+            memset(t->geracao, 0, t->capacidade * sizeof(unsigned));
+            t->geracaoAtual = 1;
+        }
+
+        int dx, dy;
+        for (size_t j = 0; j < k; j++)
+        {
+            direcaoDe[j] = -1;
+            if (j == i || (xs[j] == xs[i] && ys[j] == ys[i]))
+                continue;
+            size_t s = procurarDirecao(t, chaveDirecao(xs[j] - xs[i], ys[j] - ys[i], &dx, &dy));
+            direcaoDe[j] = (int)s;
+            t->contagem[s]++;
+            if (j < i)
+                t->anterior[s] = true;
+        }
+
+        for (size_t j = i + 1; j < k; j++)
+        {
+            int s = direcaoDe[j];
+            if (s < 0 || t->contagem[s] < 2 || t->anterior[s])
+                continue;
+
+            if (t->linha[s] < 0)
+            {
+                // Primeira antena desta direção: reserva o espaço da linha toda e coloca a âncora
+                size_t membros = (size_t)t->contagem[s] + 1;
+                chaveDirecao(xs[j] - xs[i], ys[j] - ys[i], &dx, &dy);
+                if (!garantirMembros(r, membros) || !novaLinha(r, (char)f, dx, dy, r->numMembros, 1))
+                    return false;
+                t->linha[s] = (int)(r->numLinhas - 1);
+                r->x[r->numMembros] = xs[i];
+                r->y[r->numMembros] = ys[i];
+                r->projecao[r->numMembros] = 0;
+                r->numMembros += membros;
+            }
+
+            LinhaColinear *l = &r->linhas[t->linha[s]];
+            size_t p = l->inicio + l->numMembros++;
+            r->x[p] = xs[j];
+            r->y[p] = ys[j];
+            r->projecao[p] = (l->dx != 0) ? (xs[j] - xs[i]) / l->dx : (ys[j] - ys[i]) / l->dy;
+            if (l->numMembros == (size_t)t->contagem[s] + 1)
+                ordenarMembros(r, l);
+        }
+    }
+    return true;
+}
+
+static void *trabalharColinear(void *arg)
+{
+    TrabalhoColinear *tr = (TrabalhoColinear *)arg;
+    EstadoColinear *e = tr->estado;
+    const GruposFrequencia *g = e->grupos;
+    usarContextoMemoria(e->contexto);
+
+    size_t maior = 0;
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        if (g->inicio[f + 1] - g->inicio[f] > maior)
+            maior = g->inicio[f + 1] - g->inicio[f];
+    }
+
+    // Tabela com pelo menos o dobro das direções possíveis de uma âncora
+    TabelaDirecoes t;
+    memset(&t, 0, sizeof(t));
+    t.capacidade = 16;
+    while (t.capacidade < 2 * maior)
+        t.capacidade *= 2;
+    t.chaves = (uint64_t *)reservarMemoria(t.capacidade * sizeof(uint64_t));
+    t.geracao = (unsigned *)reservarMemoriaZerada(t.capacidade, sizeof(unsigned));
+    t.contagem = (int *)reservarMemoria(t.capacidade * sizeof(int));
+    t.anterior = (bool *)reservarMemoria(t.capacidade * sizeof(bool));
+    t.linha = (int *)reservarMemoria(t.capacidade * sizeof(int));
+    int *direcaoDe = (int *)reservarMemoria((maior + 1) * sizeof(int));
+    bool ok = t.chaves && t.geracao && t.contagem && t.anterior && t.linha && direcaoDe;
+
+    for (;;)
+    {
+        int i = __atomic_fetch_add(&e->seguinte, 1, __ATOMIC_RELAXED);
+        if (!ok || i >= e->numFrequencias)
+            break;
+        ok = linhasFrequencia(g, e->ordem[i], &t, direcaoDe, &tr->res);
+    }
+    if (!ok)
+    {
+        __atomic_store_n(&e->erro, true, __ATOMIC_RELAXED);
+    }
+
+    libertarMemoria(t.chaves);
+    libertarMemoria(t.geracao);
+    libertarMemoria(t.contagem);
+    libertarMemoria(t.anterior);
+    libertarMemoria(t.linha);
+    libertarMemoria(direcaoDe);
+    return NULL;
+}
+
+// Linha com a posição do primeiro membro, para a ordenação final não depender de estado global
+typedef struct LinhaOrdenar
+{
+    LinhaColinear linha;
+    int x, y;
+} LinhaOrdenar;
+
+// Linhas mais fortes primeiro; em caso de empate, por frequência e pelo primeiro membro
+static int compararLinhas(const void *a, const void *b)
+{
+    const LinhaOrdenar *oa = (const LinhaOrdenar *)a, *ob = (const LinhaOrdenar *)b;
+    const LinhaColinear *la = &oa->linha, *lb = &ob->linha;
+    if (la->numMembros != lb->numMembros)
+        return la->numMembros > lb->numMembros ? -1 : 1;
+    if (la->freq != lb->freq)
+        return la->freq < lb->freq ? -1 : 1;
+    if (oa->x != ob->x)
+        return oa->x < ob->x ? -1 : 1;
+    if (oa->y != ob->y)
+        return oa->y < ob->y ? -1 : 1;
+    if (la->dx != lb->dx)
+        return la->dx < lb->dx ? -1 : 1;
+    return (la->dy > lb->dy) - (la->dy < lb->dy);
+}
+
+bool analisarColinearidade(Antena *h, int numThreads, AnaliseColinear *res)
+{
+    if (res == NULL || numThreads <= 0)
+    {
+        return false;
+    }
+    memset(res, 0, sizeof(*res));
+
+    GruposFrequencia g;
+    if (!agruparPorFrequencia(h, &g))
+    {
+        return false;
+    }
+
+    EstadoColinear e;
+    memset(&e, 0, sizeof(e));
+    e.grupos = &g;
+    e.contexto = contextoMemoriaAtual();
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        if (g.inicio[f + 1] - g.inicio[f] >= 3)
+            e.ordem[e.numFrequencias++] = f;
+    }
+    for (int a = 1; a < e.numFrequencias; a++)
+    {
+        int f = e.ordem[a], b = a;
+        size_t k = g.inicio[f + 1] - g.inicio[f];
+        while (b > 0 && g.inicio[e.ordem[b - 1] + 1] - g.inicio[e.ordem[b - 1]] < k)
+        {
+            e.ordem[b] = e.ordem[b - 1];
+            b--;
+        }
+        e.ordem[b] = f;
+    }
+
+    if (numThreads > e.numFrequencias)
+        numThreads = e.numFrequencias > 0 ? e.numFrequencias : 1;
+    TrabalhoColinear *trabalhos = (TrabalhoColinear *)reservarMemoriaZerada((size_t)numThreads, sizeof(TrabalhoColinear));
+    pthread_t *threads = (pthread_t *)reservarMemoria((size_t)numThreads * sizeof(pthread_t));
+    bool ok = trabalhos && threads;
+
+    int criadas = 1;
+    if (ok)
+    {
+        for (int t = 0; t < numThreads; t++)
+            trabalhos[t].estado = &e;
+        for (int t = 1; t < numThreads; t++)
+        {
+            if (pthread_create(&threads[t], NULL, trabalharColinear, &trabalhos[t]) != 0)
+                break;
+            criadas++;
+        }
+        trabalharColinear(&trabalhos[0]);
+        for (int t = 1; t < criadas; t++)
+            pthread_join(threads[t], NULL);
+        ok = !e.erro;
+    }
+
+    // Junta os resultados das threads e ordena as linhas
+    size_t linhas = 0, membros = 0;
+    for (int t = 0; ok && t < criadas; t++)
+    {
+        linhas += trabalhos[t].res.numLinhas;
+        membros += trabalhos[t].res.numMembros;
+    }
+    if (ok)
+    {
+        res->linhas = (LinhaColinear *)reservarMemoria((linhas + 1) * sizeof(LinhaColinear));
+        res->x = (int *)reservarMemoria((membros + 1) * sizeof(int));
+        res->y = (int *)reservarMemoria((membros + 1) * sizeof(int));
+        ok = res->linhas && res->x && res->y;
+    }
+    for (int t = 0; ok && t < criadas; t++)
+    {
+        ResultadosLocais *r = &trabalhos[t].res;
+        for (size_t l = 0; l < r->numLinhas; l++)
+        {
+            LinhaColinear *nova = &res->linhas[res->numLinhas++];
+            *nova = r->linhas[l];
+            nova->inicio = res->numMembros + r->linhas[l].inicio;
+        }
+        if (r->numMembros > 0)
+        {
+            memcpy(res->x + res->numMembros, r->x, r->numMembros * sizeof(int));
+            memcpy(res->y + res->numMembros, r->y, r->numMembros * sizeof(int));
+            res->numMembros += r->numMembros;
+        }
+    }
+    LinhaOrdenar *ordenar = ok ? (LinhaOrdenar *)reservarMemoria((res->numLinhas + 1) * sizeof(LinhaOrdenar)) : NULL;
+    ok = ok && ordenar != NULL;
+    if (ok)
+    {
+        for (size_t l = 0; l < res->numLinhas; l++)
+        {
+            ordenar[l].linha = res->linhas[l];
+            ordenar[l].x = res->x[res->linhas[l].inicio];
+            ordenar[l].y = res->y[res->linhas[l].inicio];
+        }
+        qsort(ordenar, res->numLinhas, sizeof(LinhaOrdenar), compararLinhas);
+        for (size_t l = 0; l < res->numLinhas; l++)
+            res->linhas[l] = ordenar[l].linha;
+    }
+    libertarMemoria(ordenar);
+
+    for (int t = 0; trabalhos && t < numThreads; t++)
+    {
+        libertarMemoria(trabalhos[t].res.linhas);
+        libertarMemoria(trabalhos[t].res.x);
+        libertarMemoria(trabalhos[t].res.y);
+        libertarMemoria(trabalhos[t].res.projecao);
+    }
+    libertarMemoria(trabalhos);
+    libertarMemoria(threads);
+    libertarGrupos(&g);
+    if (!ok)
+    {
+        libertarColinearidade(res);
+    }
+    return ok;
+}
+
+bool imprimirLinhasColineares(FILE *f, const AnaliseColinear *res)
+{
+    if (f == NULL || res == NULL)
+    {
+        return false;
+    }
+    for (size_t l = 0; l < res->numLinhas; l++)
+    {
+        const LinhaColinear *linha = &res->linhas[l];
+        fprintf(f, "%c %zu (%d,%d):", linha->freq, linha->numMembros, linha->dx, linha->dy);
+        for (size_t m = linha->inicio; m < linha->inicio + linha->numMembros; m++)
+        {
+            fprintf(f, " %d,%d", res->x[m], res->y[m]);
+        }
+        fputc('\n', f);
+    }
+    return !ferror(f);
+}
+
+void libertarColinearidade(AnaliseColinear *res)
+{
+    if (res == NULL)
+    {
+        return;
+    }
+    libertarMemoria(res->linhas);
+    libertarMemoria(res->x);
+    libertarMemoria(res->y);
+    memset(res, 0, sizeof(*res));
+}
@@ -0,0 +1,37 @@
+/***
+ * @file colinearidade.h
+ * @brief Linhas com três ou mais antenas da mesma frequência (corredores de interferência)
+ * @author David Costa
+ */
+#ifndef COLINEARIDADE_H
+#define COLINEARIDADE_H
+#include "struct.h"
+
+/***
+ * @brief Linha com três ou mais antenas da mesma frequência
+ * @param dx Direção da linha reduzida pelo mdc (dx > 0, ou dx == 0 e dy > 0)
+ * @param inicio Os membros ocupam as posições inicio a inicio+numMembros-1 de AnaliseColinear, por ordem ao longo da direção
+ */
+typedef struct LinhaColinear {
+    char freq;
+    int dx, dy;
+    size_t inicio, numMembros;
+} LinhaColinear;
+
+/***
+ * @brief Resultado da análise: linhas, da mais forte (mais antenas) para a mais fraca, e os seus membros
+ */
+typedef struct AnaliseColinear {
+    LinhaColinear *linhas;
+    size_t numLinhas;
+    int *x, *y;             // Coordenadas dos membros de todas as linhas
+    size_t numMembros;
+} AnaliseColinear;
+
+#endif
+
+bool analisarColinearidade(Antena *h, int numThreads, AnaliseColinear *res);
+
+bool imprimirLinhasColineares(FILE *f, const AnaliseColinear *res);
+
+void libertarColinearidade(AnaliseColinear *res);
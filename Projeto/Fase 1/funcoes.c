@@ -3,33 +3,463 @@
  * @brief Implementação das funções para manipulação de antenas
  * @author David Costa
  */
+#define _POSIX_C_SOURCE 200809L // fileno e fsync do diário de edições com -std=c11
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include "struct.h"
 
+// Reserva de memória: todas as reservas da biblioteca passam pelo contexto atual, que conta os bytes
+// vivos e o pico. Cada bloco leva um cabeçalho com o contexto que o reservou e o seu tamanho, para
+// ser devolvido ao mesmo contexto mesmo que entretanto outro passe a ser o atual.
+// O contexto atual é de cada thread; os contadores são atualizados atomicamente, pelo que um mesmo
+// contexto pode ser usado (e um bloco libertado) a partir de várias threads.
+typedef union CabecalhoBloco
+{
+    struct
+    {
+        ContextoMemoria *contexto;
+        size_t tamanho;
+    } info;
+    max_align_t alinhamento;
+} CabecalhoBloco;
+
+static void *reservarSistema(size_t tamanho, void *dados)
+{
+    (void)dados;
+    return malloc(tamanho);
+}
+
+static void libertarSistema(void *p, size_t tamanho, void *dados)
+{
+    (void)tamanho;
+    (void)dados;
+    free(p);
+}
+
+static ContextoMemoria contextoSistema = { reservarSistema, libertarSistema, NULL, 0, 0, 0, 0, 0, 0 };
+static _Thread_local ContextoMemoria *contextoAtual = &contextoSistema;
+
+void iniciarContextoMemoria(ContextoMemoria *ctx, void *(*reservar)(size_t tamanho, void *dados),
+                            void (*libertar)(void *p, size_t tamanho, void *dados), void *dados, size_t limite)
+{
+    memset(ctx, 0, sizeof(ContextoMemoria));
+    ctx->reservar = reservar ? reservar : reservarSistema;
+    ctx->libertar = (reservar && libertar) ? libertar : libertarSistema;
+    ctx->dados = dados;
+    ctx->limite = limite;
+}
+
+ContextoMemoria *usarContextoMemoria(ContextoMemoria *ctx)
+{
+    ContextoMemoria *anterior = contextoAtual;
+    contextoAtual = (ctx != NULL) ? ctx : &contextoSistema;
+    return anterior;
+}
+
+ContextoMemoria *contextoMemoriaAtual(void)
+{
+    return contextoAtual;
+}
+
+bool relatorioMemoria(FILE *f, const ContextoMemoria *ctx)
+{
+    if (ctx == NULL)
+    {
+        ctx = contextoAtual;
+    }
+
+    size_t blocos = ctx->reservas - ctx->libertacoes;
+    if (f != NULL)
+    {
+        fprintf(f, "Memoria: %zu bytes vivos em %zu blocos, pico de %zu bytes, %zu reservas, %zu falhas\n",
+                ctx->vivos, blocos, ctx->pico, ctx->reservas, ctx->falhas);
+        if (blocos > 0)
+        {
+            fprintf(f, "Fuga de memoria: %zu blocos (%zu bytes) por libertar\n", blocos, ctx->vivos);
+        }
+    }
+    return blocos == 0;
+}
+
+void *reservarMemoria(size_t tamanho)
+{
+    ContextoMemoria *ctx = contextoAtual;
+
+    // Um limite definido funciona como orçamento: a reserva falha em vez de o ultrapassar. Os bytes
+    // são contados antes de reservar, para que threads concorrentes não passem juntas o limite
+    size_t vivos = __atomic_load_n(&ctx->vivos, __ATOMIC_RELAXED);
+    do
+    {
+        if (tamanho > SIZE_MAX - sizeof(CabecalhoBloco) ||
+            (ctx->limite != 0 && (tamanho > ctx->limite || vivos > ctx->limite - tamanho)))
+        {
+            __atomic_fetch_add(&ctx->falhas, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&ctx->vivos, &vivos, vivos + tamanho, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    CabecalhoBloco *c = (CabecalhoBloco *)ctx->reservar(sizeof(CabecalhoBloco) + tamanho, ctx->dados);
+    if (c == NULL)
+    {
+        __atomic_fetch_sub(&ctx->vivos, tamanho, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&ctx->falhas, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    c->info.contexto = ctx;
+    c->info.tamanho = tamanho;
+    __atomic_fetch_add(&ctx->reservas, 1, __ATOMIC_RELAXED);
+    vivos += tamanho;
+    size_t pico = __atomic_load_n(&ctx->pico, __ATOMIC_RELAXED);
+    while (vivos > pico && !__atomic_compare_exchange_n(&ctx->pico, &pico, vivos, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+    return c + 1;
+}
+
+void *reservarMemoriaZerada(size_t n, size_t tamanho)
+{
+    if (tamanho != 0 && n > SIZE_MAX / tamanho)
+    {
+        __atomic_fetch_add(&contextoAtual->falhas, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    void *p = reservarMemoria(n * tamanho);
+    if (p != NULL)
+    {
+        memset(p, 0, n * tamanho);
+    }
+    return p;
+}
+
+void libertarMemoria(void *p)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+
+    CabecalhoBloco *c = (CabecalhoBloco *)p - 1;
+    ContextoMemoria *ctx = c->info.contexto;
+    __atomic_fetch_sub(&ctx->vivos, c->info.tamanho, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ctx->libertacoes, 1, __ATOMIC_RELAXED);
+    ctx->libertar(c, sizeof(CabecalhoBloco) + c->info.tamanho, ctx->dados);
+}
+
+// Como realloc, mas por cima de reservarMemoria: os alocadores dos contextos só reservam e libertam
+void *realocarMemoria(void *p, size_t tamanho)
+{
+    if (p == NULL)
+    {
+        return reservarMemoria(tamanho);
+    }
+
+    size_t anterior = ((CabecalhoBloco *)p - 1)->info.tamanho;
+    if (tamanho <= anterior)
+    {
+        return p;
+    }
+
+    void *novo = reservarMemoria(tamanho);
+    if (novo != NULL)
+    {
+        memcpy(novo, p, anterior);
+        libertarMemoria(p);
+    }
+    return novo;
+}
+
+// Chave de ordenação: (x, y) empacotados de forma a que a ordem dos inteiros sem sinal
+// coincida com a ordem lexicográfica das coordenadas com sinal
+static uint64_t chaveCoordenadas(int x, int y)
+{
+    return ((uint64_t)((uint32_t)x ^ 0x80000000u) << 32) | ((uint32_t)y ^ 0x80000000u);
+}
+
+static uint64_t chaveAntena(const void *no) { return chaveCoordenadas(((const Antena *)no)->x, ((const Antena *)no)->y); }
+static void *proxAntena(const void *no) { return ((const Antena *)no)->prox; }
+static void ligarAntena(void *no, void *prox) { ((Antena *)no)->prox = (Antena *)prox; }
+static ElosIndice *elosAntena(void *no) { return &((Antena *)no)->elos; }
+
+static uint64_t chaveEfeito(const void *no) { return chaveCoordenadas(((const RedeAntenas *)no)->x, ((const RedeAntenas *)no)->y); }
+static void *proxEfeito(const void *no) { return ((const RedeAntenas *)no)->prox; }
+static void ligarEfeito(void *no, void *prox) { ((RedeAntenas *)no)->prox = (RedeAntenas *)prox; }
+static ElosIndice *elosEfeito(void *no) { return &((RedeAntenas *)no)->elos; }
+
+static const OperacoesIndice opsAntena = { chaveAntena, proxAntena, ligarAntena, elosAntena };
+static const OperacoesIndice opsEfeito = { chaveEfeito, proxEfeito, ligarEfeito, elosEfeito };
+
+static IndiceOrdenado *criarIndice(const OperacoesIndice *ops)
+{
+    IndiceOrdenado *ind = (IndiceOrdenado *)reservarMemoriaZerada(1, sizeof(IndiceOrdenado));
+    if (!ind)
+    {
+        return NULL;
+    }
+    ind->nivel = 1;
+    ind->semente = 0x9E3779B9u;
+    ind->ops = ops;
+    return ind;
+}
+
+// Altura de uma nova torre: cada nível extra tem probabilidade 1/4
+static int alturaAleatoria(IndiceOrdenado *ind)
+{
+    uint32_t r = ind->semente;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    ind->semente = r;
+
+    int altura = 1;
+    while (altura < NIVEL_MAX_INDICE && (r & 3) == 0)
+    {
+        altura++;
+        r >>= 2;
+    }
+    return altura;
+}
+
+// Nodo seguinte ao nível i (no == NULL representa a cabeça do índice)
+static void *seguinteNivel(const IndiceOrdenado *ind, void *no, int i)
+{
+    if (no == NULL)
+        return ind->cabeca[i];
+    if (i == 0)
+        return ind->ops->obterProx(no);
+    return ind->ops->elos(no)->saltos[i - 1];
+}
+
+static void ligarNivel(IndiceOrdenado *ind, void *no, int i, void *destino)
+{
+    if (no == NULL)
+        ind->cabeca[i] = destino;
+    else if (i == 0)
+        ind->ops->definirProx(no, destino);
+    else
+        ind->ops->elos(no)->saltos[i - 1] = destino;
+}
+
+// Reserva a torre de um nodo; se não houver memória o nodo fica apenas no nível 0
+static int prepararTorre(IndiceOrdenado *ind, void *no)
+{
+    ElosIndice *elos = ind->ops->elos(no);
+    int altura = alturaAleatoria(ind);
+
+    elos->indice = ind;
+    elos->saltos = NULL;
+    if (altura > 1)
+    {
+        elos->saltos = (void **)reservarMemoriaZerada(altura - 1, sizeof(void *));
+        if (!elos->saltos)
+        {
+            altura = 1;
+        }
+    }
+    return altura;
+}
+
+static void largarTorre(IndiceOrdenado *ind, void *no)
+{
+    ElosIndice *elos = ind->ops->elos(no);
+    libertarMemoria(elos->saltos);
+    elos->saltos = NULL;
+    elos->indice = NULL;
+}
+
+// Preenche anteriores[i] com o último nodo de cada nível cuja chave é menor que a procurada
+static void procurarAnteriores(IndiceOrdenado *ind, uint64_t chave, void *anteriores[NIVEL_MAX_INDICE])
+{
+    void *atual = NULL;
+    void *seg;
+
+    for (int i = ind->nivel - 1; i >= 0; i--)
+    {
+        while ((seg = seguinteNivel(ind, atual, i)) != NULL && ind->ops->chave(seg) < chave)
+        {
+            atual = seg;
+        }
+        anteriores[i] = atual;
+    }
+}
+
+static void indiceInserir(IndiceOrdenado *ind, void *no)
+{
+    void *anteriores[NIVEL_MAX_INDICE];
+    procurarAnteriores(ind, ind->ops->chave(no), anteriores);
+
+    int altura = prepararTorre(ind, no);
+    for (int i = ind->nivel; i < altura; i++)
+    {
+        anteriores[i] = NULL;
+    }
+    if (altura > ind->nivel)
+    {
+        ind->nivel = altura;
+    }
+
+    for (int i = 0; i < altura; i++)
+    {
+        ligarNivel(ind, no, i, seguinteNivel(ind, anteriores[i], i));
+        ligarNivel(ind, anteriores[i], i, no);
+    }
+    ind->tamanho++;
+}
+
+static void *indiceProcurar(IndiceOrdenado *ind, uint64_t chave)
+{
+    void *anteriores[NIVEL_MAX_INDICE];
+    procurarAnteriores(ind, chave, anteriores);
+
+    void *alvo = seguinteNivel(ind, anteriores[0], 0);
+    if (alvo == NULL || ind->ops->chave(alvo) != chave)
+    {
+        return NULL;
+    }
+    return alvo;
+}
+
+// Retira da lista e do índice o primeiro nodo com a chave dada (o nodo não é libertado)
+static void *indiceRemover(IndiceOrdenado *ind, uint64_t chave)
+{
+    void *anteriores[NIVEL_MAX_INDICE];
+    procurarAnteriores(ind, chave, anteriores);
+
+    void *alvo = seguinteNivel(ind, anteriores[0], 0);
+    if (alvo == NULL || ind->ops->chave(alvo) != chave)
+    {
+        return NULL;
+    }
+
+    // As torres são contíguas a partir do nível 0, por isso basta parar no primeiro nível sem o alvo
+    for (int i = 0; i < ind->nivel && seguinteNivel(ind, anteriores[i], i) == alvo; i++)
+    {
+        ligarNivel(ind, anteriores[i], i, seguinteNivel(ind, alvo, i));
+    }
+    while (ind->nivel > 1 && ind->cabeca[ind->nivel - 1] == NULL)
+    {
+        ind->nivel--;
+    }
+
+    largarTorre(ind, alvo);
+    ind->tamanho--;
+    return alvo;
+}
+
+// Ordenação estável (merge sort) de uma lista ligada pela chave dos nodos
+static void *ordenarLista(const OperacoesIndice *ops, void *lista, size_t n)
+{
+    if (n <= 1)
+    {
+        if (lista)
+            ops->definirProx(lista, NULL);
+        return lista;
+    }
+
+    size_t metade = n / 2;
+    void *meio = lista;
+    for (size_t i = 0; i < metade; i++)
+    {
+        meio = ops->obterProx(meio);
+    }
+
+    void *a = ordenarLista(ops, lista, metade);
+    void *b = ordenarLista(ops, meio, n - metade);
+
+    void *h = NULL, *cauda = NULL;
+    while (a != NULL || b != NULL)
+    {
+        void *menor;
+        if (b == NULL || (a != NULL && ops->chave(a) <= ops->chave(b)))
+        {
+            menor = a;
+            a = ops->obterProx(a);
+        }
+        else
+        {
+            menor = b;
+            b = ops->obterProx(b);
+        }
+
+        if (cauda == NULL)
+            h = menor;
+        else
+            ops->definirProx(cauda, menor);
+        cauda = menor;
+    }
+    ops->definirProx(cauda, NULL);
+    return h;
+}
+
+// Ordena uma lista sem índice e constrói o índice em tempo linear sobre a lista ordenada
+static void *indexarLista(const OperacoesIndice *ops, void *lista)
+{
+    size_t n = 0;
+    for (void *aux = lista; aux != NULL; aux = ops->obterProx(aux))
+    {
+        n++;
+    }
+    lista = ordenarLista(ops, lista, n);
+
+    IndiceOrdenado *ind = criarIndice(ops);
+    if (!ind)
+    {
+        return lista; // A lista fica ordenada, mas sem índice
+    }
+
+    void *ultimos[NIVEL_MAX_INDICE] = { NULL };
+    void *aux = lista;
+    while (aux != NULL)
+    {
+        void *seg = ops->obterProx(aux);
+        int altura = prepararTorre(ind, aux);
+        if (altura > ind->nivel)
+        {
+            ind->nivel = altura;
+        }
+        for (int i = 1; i < altura; i++)
+        {
+            ligarNivel(ind, ultimos[i], i, aux);
+            ultimos[i] = aux;
+        }
+        aux = seg;
+    }
+    ind->cabeca[0] = lista;
+    ind->tamanho = n;
+    return lista;
+}
+
 Antena *criarAntena(char freq, int x, int y)
 {
-    Antena *nova = (Antena *)malloc(sizeof(Antena));
+    Antena *nova = (Antena *)reservarMemoria(sizeof(Antena));
     if (!nova)
     {
-        printf("Erro de alocacao de memoria!\n");
-        exit(1);
+        return NULL; // Sem memória: quem chama decide o que fazer
     }
     nova->freq = freq;
     nova->x = x;
     nova->y = y;
     nova->prox = NULL; // Inicializa o ponteiro para NULL
+    nova->elos.indice = NULL;
+    nova->elos.saltos = NULL;
     return nova;
 }
 
 Antena* carregarAntenas(char* nomeFicheiro) {
-    char c;
+    return carregarAntenasMapa(nomeFicheiro, NULL);
+}
+
+Antena* carregarAntenasMapa(char* nomeFicheiro, LimitesMapa* limites) {
+    int c;
     Antena* h = NULL;
     Antena* aux;
 
     int x = 0;
     int y = 0;
+    int colunas = 0;
 
     //Abre o ficheiro em modo de leitura
     FILE *f = fopen(nomeFicheiro, "r");
@@ -43,16 +473,19 @@ Antena* carregarAntenas(char* nomeFicheiro) {
     while ((c = fgetc(f))!=EOF) {
             //Se o caractere for uma letra, cria uma antena nova
             if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
-                aux = (Antena*)malloc(sizeof(Antena));
+                aux = (Antena*)reservarMemoria(sizeof(Antena));
                 if (aux == NULL) {
                     fclose(f);
-                    return NULL;    //Se o ficheiro não alocar espaço devolve NULL depois de fechar o ficheiro
+                    libertarAntenas(h);
+                    return NULL;    //Se o ficheiro não alocar espaço devolve NULL depois de fechar o ficheiro e libertar o que já leu
                 }
 
                 aux->freq = c;
                 aux->x = x;
                 aux->y = y;
                 aux->prox = h;
+                aux->elos.indice = NULL;
+                aux->elos.saltos = NULL;
                 h = aux;
             }
 
@@ -60,15 +493,24 @@ Antena* carregarAntenas(char* nomeFicheiro) {
             if (c == '\n') {
                 x++;
                 y=0;
-            } else {
+            } else if (c != '\r') {
                 y++;
+                if (y > colunas) {
+                    colunas = y;
+                }
             }
         }  
     fclose(f);
+
+    //Os limites da matriz ficam conhecidos no fim da leitura (a última linha pode não terminar em '\n')
+    if (limites != NULL) {
+        limites->linhas = (y > 0) ? x + 1 : x;
+        limites->colunas = colunas;
+    }
     return h;   //Devolve a lista completa depois de fechar o ficheiro
 }
 
-Antena *inserirAntena(Antena *h, Antena *nova)
+static Antena *inserirAntenaLinear(Antena *h, Antena *nova)
 {
     // Se a lista estiver vazia ou se a nova antena for menor que a primeira
     if (h == NULL || (nova->x < h->x || (nova->x == h->x && nova->y < h->y)))
@@ -91,8 +533,69 @@ Antena *inserirAntena(Antena *h, Antena *nova)
     return h; // Retorna o início da lista
 }
 
+Antena *indexarAntenas(Antena *h)
+{
+    if (h == NULL || h->elos.indice != NULL)
+    {
+        return h; // Lista vazia ou já indexada
+    }
+    return (Antena *)indexarLista(&opsAntena, h);
+}
+
+Antena *inserirAntena(Antena *h, Antena *nova)
+{
+    if (nova == NULL)
+    {
+        return h;
+    }
+
+    // Uma lista sem índice (por exemplo, vinda de carregarAntenas) é indexada uma única vez
+    h = indexarAntenas(h);
+    IndiceOrdenado *ind = (h != NULL) ? h->elos.indice : criarIndice(&opsAntena);
+
+    // Sem memória para o índice mantém-se a inserção ordenada por percurso linear
+    if (ind == NULL)
+    {
+        return inserirAntenaLinear(h, nova);
+    }
+
+    indiceInserir(ind, nova);
+    return (Antena *)ind->cabeca[0]; // Retorna o início da lista
+}
+
+Antena *procurarAntena(Antena *h, int x, int y)
+{
+    if (h != NULL && h->elos.indice != NULL)
+    {
+        return (Antena *)indiceProcurar(h->elos.indice, chaveCoordenadas(x, y));
+    }
+
+    while (h != NULL && (h->x != x || h->y != y))
+    {
+        h = h->prox;
+    }
+    return h;
+}
+
 Antena *removerAntena(Antena *h, int x, int y, bool *res)
 {
+    // Lista indexada: a antena é encontrada e desligada em O(log n)
+    if (h != NULL && h->elos.indice != NULL)
+    {
+        IndiceOrdenado *ind = h->elos.indice;
+        Antena *alvo = (Antena *)indiceRemover(ind, chaveCoordenadas(x, y));
+
+        *res = (alvo != NULL);
+        libertarMemoria(alvo);
+
+        h = (Antena *)ind->cabeca[0];
+        if (h == NULL)
+        {
+            libertarMemoria(ind); // O índice desaparece com o último elemento
+        }
+        return h;
+    }
+
     Antena *atual = h, *anterior = NULL;
 
     // Percorre a lista para encontrar a antena a remover
@@ -121,11 +624,26 @@ Antena *removerAntena(Antena *h, int x, int y, bool *res)
         anterior->prox = atual->prox; // Remove a antena da lista
     }
 
-    free(atual); // Libera a memória da antena removida
+    libertarMemoria(atual); // Libera a memória da antena removida
 
     return h; // Retorna o início da lista atualizado
 }
 
+void libertarAntenas(Antena *h)
+{
+    // O índice é partilhado por todos os nodos e sai no fim, com a lista
+    IndiceOrdenado *ind = (h != NULL) ? h->elos.indice : NULL;
+
+    while (h != NULL)
+    {
+        Antena *seguinte = h->prox;
+        libertarMemoria(h->elos.saltos);
+        libertarMemoria(h);
+        h = seguinte;
+    }
+    libertarMemoria(ind);
+}
+
 bool imprimirAntenas(Antena *h)
 {
     if (h == NULL)
@@ -141,14 +659,8 @@ bool imprimirAntenas(Antena *h)
     return true;
 }
 
-bool gravarAntenasBinario(char *nomeFicheiro, Antena *h)
+static void escreverAntenasBinario(FILE *f, Antena *h)
 {
-    FILE *f = fopen(nomeFicheiro, "wb");
-    if (!f)
-    {
-        return false;
-    }
-
     while (h != NULL)
     {
         fwrite(&h->freq, sizeof(char), 1, f);
@@ -156,26 +668,86 @@ bool gravarAntenasBinario(char *nomeFicheiro, Antena *h)
         fwrite(&h->y, sizeof(int), 1, f);
         h = h->prox;
     }
+}
+
+bool gravarAntenasBinario(char *nomeFicheiro, Antena *h)
+{
+    FILE *f = fopen(nomeFicheiro, "wb");
+    if (!f)
+    {
+        return false;
+    }
+
+    escreverAntenasBinario(f, h);
 
     fclose(f);
     return true;
 }
 
-RedeAntenas *criarEfeitoNefasto(int x, int y)
+// Lê um ficheiro de gravarAntenasBinario para *lista. Devolve false se não conseguir ler
+// (um ficheiro inexistente só é aceite, como lista vazia, se podeNaoExistir)
+static bool lerAntenasBinario(const char *nomeFicheiro, Antena **lista, bool podeNaoExistir)
 {
-    RedeAntenas *novo = (RedeAntenas *)malloc(sizeof(RedeAntenas));
-    if (!novo)
+    *lista = NULL;
+    FILE *f = fopen(nomeFicheiro, "rb");
+    if (!f)
     {
-        exit(1);
+        return podeNaoExistir;
     }
-    novo->x = x;
-    novo->y = y;
-    novo->prox = NULL; // Inicializa o ponteiro para NULL
-    return novo;
-}
 
-RedeAntenas *inserirEfeitoNefasto(RedeAntenas *h, RedeAntenas *novo)
-{
+    // Os registos vêm pela ordem da lista gravada, por isso são ligados pela ordem e indexados no fim
+    Antena *h = NULL, *ultima = NULL;
+    char freq;
+    int x, y;
+    bool ok = true;
+    while (fread(&freq, sizeof(char), 1, f) == 1)
+    {
+        Antena *nova = NULL;
+        if (fread(&x, sizeof(int), 1, f) != 1 || fread(&y, sizeof(int), 1, f) != 1 || (nova = criarAntena(freq, x, y)) == NULL)
+        {
+            ok = false;
+            break;
+        }
+        if (ultima == NULL)
+            h = nova;
+        else
+            ultima->prox = nova;
+        ultima = nova;
+    }
+    fclose(f);
+
+    if (!ok)
+    {
+        libertarAntenas(h);
+        return false;
+    }
+    *lista = indexarAntenas(h);
+    return true;
+}
+
+Antena *carregarAntenasBinario(char *nomeFicheiro)
+{
+    Antena *h;
+    return lerAntenasBinario(nomeFicheiro, &h, false) ? h : NULL;
+}
+
+RedeAntenas *criarEfeitoNefasto(int x, int y)
+{
+    RedeAntenas *novo = (RedeAntenas *)reservarMemoria(sizeof(RedeAntenas));
+    if (!novo)
+    {
+        return NULL;
+    }
+    novo->x = x;
+    novo->y = y;
+    novo->prox = NULL; // Inicializa o ponteiro para NULL
+    novo->elos.indice = NULL;
+    novo->elos.saltos = NULL;
+    return novo;
+}
+
+static RedeAntenas *inserirEfeitoLinear(RedeAntenas *h, RedeAntenas *novo)
+{
     // Se a lista estiver vazia ou se o novo efeito for menor que o primeiro
     if (h == NULL || (novo->x < h->x || (novo->x == h->x && novo->y < h->y)))
     {
@@ -197,38 +769,477 @@ RedeAntenas *inserirEfeitoNefasto(RedeAntenas *h, RedeAntenas *novo)
     return h;
 }
 
+RedeAntenas *indexarEfeitos(RedeAntenas *h)
+{
+    if (h == NULL || h->elos.indice != NULL)
+    {
+        return h;
+    }
+    return (RedeAntenas *)indexarLista(&opsEfeito, h);
+}
+
+RedeAntenas *inserirEfeitoNefasto(RedeAntenas *h, RedeAntenas *novo)
+{
+    if (novo == NULL)
+    {
+        return h;
+    }
+
+    h = indexarEfeitos(h);
+    IndiceOrdenado *ind = (h != NULL) ? h->elos.indice : criarIndice(&opsEfeito);
+    if (ind == NULL)
+    {
+        return inserirEfeitoLinear(h, novo);
+    }
+
+    indiceInserir(ind, novo);
+    return (RedeAntenas *)ind->cabeca[0];
+}
+
+void libertarEfeitos(RedeAntenas *h)
+{
+    IndiceOrdenado *ind = (h != NULL) ? h->elos.indice : NULL;
+
+    while (h != NULL)
+    {
+        RedeAntenas *seguinte = h->prox;
+        libertarMemoria(h->elos.saltos);
+        libertarMemoria(h);
+        h = seguinte;
+    }
+    libertarMemoria(ind);
+}
+
+static size_t contarAntenas(Antena *h)
+{
+    size_t n = 0;
+    for (Antena *a = h; a != NULL; a = a->prox)
+    {
+        n++;
+    }
+    return n;
+}
+
+// Agrupa as antenas nos vetores g->x e g->y já reservados, com lugar para todas
+static void agruparEm(Antena *h, GruposFrequencia *g)
+{
+    size_t contagem[NUM_FREQUENCIAS] = { 0 };
+    for (Antena *a = h; a != NULL; a = a->prox)
+    {
+        contagem[(unsigned char)a->freq % NUM_FREQUENCIAS]++;
+    }
+
+    // Ordenação por contagem: cada frequência fica num intervalo contíguo, pela ordem da lista
+    g->inicio[0] = 0;
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        g->inicio[f + 1] = g->inicio[f] + contagem[f];
+    }
+
+    size_t posicao[NUM_FREQUENCIAS];
+    memcpy(posicao, g->inicio, sizeof(posicao));
+    for (Antena *a = h; a != NULL; a = a->prox)
+    {
+        size_t i = posicao[(unsigned char)a->freq % NUM_FREQUENCIAS]++;
+        g->x[i] = a->x;
+        g->y[i] = a->y;
+    }
+}
+
+bool agruparPorFrequencia(Antena *h, GruposFrequencia *g)
+{
+    size_t n = contarAntenas(h);
+    g->x = (int *)reservarMemoria((n + 1) * sizeof(int));
+    g->y = (int *)reservarMemoria((n + 1) * sizeof(int));
+    if (!g->x || !g->y)
+    {
+        libertarGrupos(g);
+        return false;
+    }
+
+    agruparEm(h, g);
+    return true;
+}
+
+void libertarGrupos(GruposFrequencia *g)
+{
+    libertarMemoria(g->x);
+    libertarMemoria(g->y);
+    g->x = NULL;
+    g->y = NULL;
+}
+
+// Palavras de um mapa de bits com uma posição por célula da matriz
+static size_t palavrasMapa(LimitesMapa limites)
+{
+    if (limites.linhas <= 0 || limites.colunas <= 0)
+    {
+        return 0;
+    }
+    return ((size_t)limites.linhas * (size_t)limites.colunas + 63) / 64;
+}
+
+size_t palavrasMapaEfeitos(Antena *h, LimitesMapa limites, ModoContagem modo)
+{
+    size_t palavras = palavrasMapa(limites);
+    if (palavras == 0)
+    {
+        return 0;
+    }
+
+    // A contagem por frequência usa um segundo mapa para as posições da frequência atual; no fim
+    // ficam as coordenadas das antenas agrupadas por frequência (dois int, uma palavra, por antena)
+    size_t mapas = (modo == CONTAGEM_POR_FREQUENCIA) ? 2 * palavras : palavras;
+    return mapas + contarAntenas(h);
+}
+
+// Marca uma posição (índice linha * colunas + coluna) no mapa de bits; devolve true se estava por marcar
+static inline bool marcarIndice(uint64_t *mapa, size_t i)
+{
+    uint64_t bit = (uint64_t)1 << (i & 63);
+    if (mapa[i >> 6] & bit)
+    {
+        return false;
+    }
+    mapa[i >> 6] |= bit;
+    return true;
+}
+
+bool efeitoNoMapa(const uint64_t *mapa, LimitesMapa limites, int x, int y)
+{
+    if (mapa == NULL || x < 0 || x >= limites.linhas || y < 0 || y >= limites.colunas)
+    {
+        return false;
+    }
+
+    size_t i = (size_t)x * (size_t)limites.colunas + (size_t)y;
+    return (mapa[i >> 6] >> (i & 63)) & 1;
+}
+
+// Núcleo dos pares: para a antena a e um bloco de até PARES_POR_BLOCO antenas b da mesma frequência,
+// calcula os pontos 2a - b e 2b - a que caem dentro da matriz e escreve em saida o índice de cada um.
+// Devolve quantos índices escreveu (no máximo 2 * n).
+typedef int (*NucleoPares)(int ax, int ay, const int *bx, const int *by, int n, LimitesMapa limites, size_t *saida);
+
+static int nucleoParesEscalar(int ax, int ay, const int *bx, const int *by, int n, LimitesMapa limites, size_t *saida)
+{
+    int k = 0;
+
+    for (int j = 0; j < n; j++)
+    {
+        if (bx[j] == ax && by[j] == ay)
+            continue;
+
+        int pontos[2][2] = { { 2 * ax - bx[j], 2 * ay - by[j] }, { 2 * bx[j] - ax, 2 * by[j] - ay } };
+        for (int p = 0; p < 2; p++)
+        {
+            int x = pontos[p][0], y = pontos[p][1];
+            if (x >= 0 && x < limites.linhas && y >= 0 && y < limites.colunas)
+            {
+                saida[k++] = (size_t)x * (size_t)limites.colunas + (size_t)y;
+            }
+        }
+    }
+    return k;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NUCLEO_AVX2
+
+// Escreve em saida os índices das faixas ativas na máscara (uma por bit)
+static inline int recolherFaixas(unsigned mascara, const int32_t *indices, size_t *saida)
+{
+    int k = 0;
+    while (mascara)
+    {
+        saida[k++] = (size_t)(uint32_t)indices[__builtin_ctz(mascara)];
+        mascara &= mascara - 1;
+    }
+    return k;
+}
+
+// Versão AVX2: 8 antenas do bloco de cada vez, com o recorte aos limites feito por máscaras.
+// Os índices são calculados a 32 bits, por isso só é usada em matrizes com menos de 2^31 posições.
+__attribute__((target("avx2")))
+static int nucleoParesAVX2(int ax, int ay, const int *bx, const int *by, int n, LimitesMapa limites, size_t *saida)
+{
+    const __m256i vax = _mm256_set1_epi32(ax), vay = _mm256_set1_epi32(ay);
+    const __m256i dobroAx = _mm256_set1_epi32(2 * ax), dobroAy = _mm256_set1_epi32(2 * ay);
+    const __m256i linhas = _mm256_set1_epi32(limites.linhas), colunas = _mm256_set1_epi32(limites.colunas);
+    const __m256i menosUm = _mm256_set1_epi32(-1);
+    int32_t indices[8];
+    int k = 0, j = 0;
+
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256i vbx = _mm256_loadu_si256((const __m256i *)(bx + j));
+        __m256i vby = _mm256_loadu_si256((const __m256i *)(by + j));
+        __m256i mesmaPosicao = _mm256_and_si256(_mm256_cmpeq_epi32(vbx, vax), _mm256_cmpeq_epi32(vby, vay));
+
+        __m256i px[2] = { _mm256_sub_epi32(dobroAx, vbx), _mm256_sub_epi32(_mm256_add_epi32(vbx, vbx), vax) };
+        __m256i py[2] = { _mm256_sub_epi32(dobroAy, vby), _mm256_sub_epi32(_mm256_add_epi32(vby, vby), vay) };
+
+        for (int p = 0; p < 2; p++)
+        {
+            // 0 <= x < linhas e 0 <= y < colunas
+            __m256i dentro = _mm256_and_si256(
+                _mm256_and_si256(_mm256_cmpgt_epi32(px[p], menosUm), _mm256_cmpgt_epi32(linhas, px[p])),
+                _mm256_and_si256(_mm256_cmpgt_epi32(py[p], menosUm), _mm256_cmpgt_epi32(colunas, py[p])));
+            dentro = _mm256_andnot_si256(mesmaPosicao, dentro);
+
+            unsigned mascara = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(dentro));
+            if (mascara)
+            {
+                _mm256_storeu_si256((__m256i *)indices, _mm256_add_epi32(_mm256_mullo_epi32(px[p], colunas), py[p]));
+                k += recolherFaixas(mascara, indices, saida + k);
+            }
+        }
+    }
+
+    return k + nucleoParesEscalar(ax, ay, bx + j, by + j, n - j, limites, saida + k);
+}
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define NUCLEO_NEON
+
+// Versão NEON: 4 antenas do bloco de cada vez (o NEON faz parte de todas as CPUs ARMv8)
+static int nucleoParesNEON(int ax, int ay, const int *bx, const int *by, int n, LimitesMapa limites, size_t *saida)
+{
+    const int32x4_t vax = vdupq_n_s32(ax), vay = vdupq_n_s32(ay);
+    const int32x4_t dobroAx = vdupq_n_s32(2 * ax), dobroAy = vdupq_n_s32(2 * ay);
+    const uint32x4_t linhas = vdupq_n_u32((uint32_t)limites.linhas), colunas = vdupq_n_u32((uint32_t)limites.colunas);
+    const int32x4_t colunasS = vdupq_n_s32(limites.colunas);
+    int32_t indices[4];
+    uint32_t faixas[4];
+    int k = 0, j = 0;
+
+    for (; j + 4 <= n; j += 4)
+    {
+        int32x4_t vbx = vld1q_s32(bx + j), vby = vld1q_s32(by + j);
+        uint32x4_t mesmaPosicao = vandq_u32(vceqq_s32(vbx, vax), vceqq_s32(vby, vay));
+
+        int32x4_t px[2] = { vsubq_s32(dobroAx, vbx), vsubq_s32(vaddq_s32(vbx, vbx), vax) };
+        int32x4_t py[2] = { vsubq_s32(dobroAy, vby), vsubq_s32(vaddq_s32(vby, vby), vay) };
+
+        for (int p = 0; p < 2; p++)
+        {
+            // Comparação sem sinal: valores negativos passam a enormes e ficam fora
+            uint32x4_t dentro = vandq_u32(vcltq_u32(vreinterpretq_u32_s32(px[p]), linhas),
+                                          vcltq_u32(vreinterpretq_u32_s32(py[p]), colunas));
+            dentro = vbicq_u32(dentro, mesmaPosicao);
+            if (vmaxvq_u32(dentro) == 0)
+                continue;
+
+            vst1q_s32(indices, vmlaq_s32(py[p], px[p], colunasS));
+            vst1q_u32(faixas, dentro);
+            for (int l = 0; l < 4; l++)
+            {
+                if (faixas[l])
+                    saida[k++] = (size_t)(uint32_t)indices[l];
+            }
+        }
+    }
+
+    return k + nucleoParesEscalar(ax, ay, bx + j, by + j, n - j, limites, saida + k);
+}
+#endif
+
+// Escolhe o núcleo uma vez, conforme o processador em que o programa está a correr. Pode ser chamada
+// por várias threads ao mesmo tempo: todas escolhem o mesmo núcleo, e a escrita e a leitura atómicas
+// garantem que nenhuma vê um ponteiro a meio
+static NucleoPares nucleoPares(LimitesMapa limites)
+{
+    static NucleoPares escolhido = NULL;
+
+    if ((size_t)limites.linhas * (size_t)limites.colunas > (size_t)INT32_MAX)
+    {
+        return nucleoParesEscalar; // Os núcleos vetoriais calculam índices a 32 bits
+    }
+
+    NucleoPares nucleo = __atomic_load_n(&escolhido, __ATOMIC_ACQUIRE);
+    if (nucleo == NULL)
+    {
+        nucleo = nucleoParesEscalar;
+#if defined(NUCLEO_AVX2)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            nucleo = nucleoParesAVX2;
+#elif defined(NUCLEO_NEON)
+        nucleo = nucleoParesNEON;
+#endif
+        __atomic_store_n(&escolhido, nucleo, __ATOMIC_RELEASE);
+    }
+    return nucleo;
+}
+
+// Índices dos pontos com efeito entre a antena (ax, ay) e cada uma das n antenas (bx, by), calculados pelo
+// núcleo escolhido para este processador. saida tem de ter espaço para 2 * n índices
+int efeitosAntena(int ax, int ay, const int *bx, const int *by, int n, LimitesMapa limites, size_t *saida)
+{
+    return nucleoPares(limites)(ax, ay, bx, by, n, limites, saida);
+}
+
+// Percorre cada par de antenas da frequência freq (-1 para todas) uma única vez, marca os efeitos em mapa
+// e devolve quantas posições eram novas lá. Com frequencia, cada efeito é primeiro marcado nesse mapa e
+// só as posições novas nele contam para porFrequencia e seguem para mapa; no fim limpa-se apenas o
+// intervalo de palavras tocado, deixando-o de novo vazio para a frequência seguinte
+static size_t percorrerPares(const GruposFrequencia *g, int freq, LimitesMapa limites, uint64_t *mapa,
+                             uint64_t *frequencia, size_t *porFrequencia)
+{
+    NucleoPares nucleo = nucleoPares(limites);
+    size_t indices[2 * PARES_POR_BLOCO];
+    size_t novos = 0;
+    size_t menor = SIZE_MAX, maior = 0;
+    int primeira = (freq < 0) ? 0 : freq;
+    int ultima = (freq < 0) ? NUM_FREQUENCIAS - 1 : freq;
+
+    for (int f = primeira; f <= ultima; f++)
+    {
+        size_t fim = g->inicio[f + 1];
+
+        for (size_t i = g->inicio[f]; i < fim; i++)
+        {
+            for (size_t j = i + 1; j < fim; j += PARES_POR_BLOCO)
+            {
+                int n = (fim - j < PARES_POR_BLOCO) ? (int)(fim - j) : PARES_POR_BLOCO;
+                int k = nucleo(g->x[i], g->y[i], g->x + j, g->y + j, n, limites, indices);
+
+                for (int t = 0; t < k; t++)
+                {
+                    if (frequencia == NULL)
+                    {
+                        novos += marcarIndice(mapa, indices[t]);
+                    }
+                    else if (marcarIndice(frequencia, indices[t]))
+                    {
+                        (*porFrequencia)++;
+                        novos += marcarIndice(mapa, indices[t]);
+                        menor = (indices[t] < menor) ? indices[t] : menor;
+                        maior = (indices[t] > maior) ? indices[t] : maior;
+                    }
+                }
+            }
+        }
+    }
+
+    if (frequencia != NULL && menor <= maior)
+    {
+        memset(frequencia + (menor >> 6), 0, ((maior >> 6) - (menor >> 6) + 1) * sizeof(uint64_t));
+    }
+    return novos;
+}
+
+bool contarEfeitosNefastos(Antena *h, LimitesMapa limites, ModoContagem modo, uint64_t *mapa, ContagemEfeitos *res)
+{
+    size_t palavras = palavrasMapa(limites);
+    if (mapa == NULL || res == NULL || palavras == 0)
+    {
+        return false;
+    }
+
+    // As antenas são agrupadas na parte final do mapa, reservada por palavrasMapaEfeitos: nada é reservado aqui
+    GruposFrequencia g;
+    g.x = (int *)(mapa + ((modo == CONTAGEM_POR_FREQUENCIA) ? 2 * palavras : palavras));
+    g.y = g.x + contarAntenas(h);
+    agruparEm(h, &g);
+
+    memset(res, 0, sizeof(ContagemEfeitos));
+    memset(mapa, 0, palavras * sizeof(uint64_t));
+
+    if (modo == CONTAGEM_TOTAL)
+    {
+        res->total = percorrerPares(&g, -1, limites, mapa, NULL, NULL);
+        return true;
+    }
+
+    // Cada frequência é marcada num mapa próprio e no global na mesma passagem pelos pares
+    uint64_t *mapaFrequencia = mapa + palavras;
+    memset(mapaFrequencia, 0, palavras * sizeof(uint64_t));
+
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        if (g.inicio[f + 1] - g.inicio[f] < 2)
+            continue;
+
+        res->total += percorrerPares(&g, f, limites, mapa, mapaFrequencia, &res->porFrequencia[f]);
+    }
+    return true;
+}
+
 RedeAntenas *calcularEfeitosNefastos(Antena *h)
 {
     RedeAntenas *efeitos = NULL;
-    Antena *a1, *a2;
+    GruposFrequencia g;
+
+    if (!agruparPorFrequencia(h, &g))
+    {
+        return NULL;
+    }
+
+    // Os efeitos não têm restrição de matriz, mas caem todos na caixa [2·min - max, 2·max - min] de cada
+    // coordenada: com as antenas deslocadas para dentro dela, o núcleo dos pares não deixa nenhum de fora
+    size_t n = g.inicio[NUM_FREQUENCIAS];
+    int minX = INT32_MAX, maxX = INT32_MIN, minY = INT32_MAX, maxY = INT32_MIN;
+    for (size_t i = 0; i < n; i++)
+    {
+        minX = (g.x[i] < minX) ? g.x[i] : minX;
+        maxX = (g.x[i] > maxX) ? g.x[i] : maxX;
+        minY = (g.y[i] < minY) ? g.y[i] : minY;
+        maxY = (g.y[i] > maxY) ? g.y[i] : maxY;
+    }
+    int64_t origemX = 2 * (int64_t)minX - maxX, origemY = 2 * (int64_t)minY - maxY;
+    int64_t linhas = 3 * ((int64_t)maxX - minX) + 1, colunas = 3 * ((int64_t)maxY - minY) + 1;
+    if (n > 0 && (linhas > INT32_MAX || colunas > INT32_MAX))
+    {
+        libertarGrupos(&g); // Antenas tão afastadas que os efeitos nem cabem num int
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        g.x[i] = (int)(g.x[i] - origemX);
+        g.y[i] = (int)(g.y[i] - origemY);
+    }
 
-    // Percorre todas as antenas
-    for (a1 = h; a1 != NULL; a1 = a1->prox)
+    LimitesMapa caixa = { (int)linhas, (int)colunas };
+    NucleoPares nucleo = nucleoPares(caixa);
+    size_t indices[2 * PARES_POR_BLOCO];
+
+    // Cada par de antenas da mesma frequência é visto uma vez; como antes (em que cada par era
+    // visto nos dois sentidos), cada posição com efeito nefasto fica duas vezes na lista
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
     {
-        for (a2 = h; a2 != NULL; a2 = a2->prox)
+        size_t fim = g.inicio[f + 1];
+        for (size_t i = g.inicio[f]; i < fim; i++)
         {
-            if (a1 != a2 && a1->freq == a2->freq)
+            for (size_t j = i + 1; j < fim; j += PARES_POR_BLOCO)
             {
-                int dx = a2->x - a1->x;
-                int dy = a2->y - a1->y;
+                int bloco = (fim - j < PARES_POR_BLOCO) ? (int)(fim - j) : PARES_POR_BLOCO;
+                int k = nucleo(g.x[i], g.y[i], g.x + j, g.y + j, bloco, caixa, indices);
 
-                // Só há efeito se não estiverem na mesma posição
-                if (dx != 0 || dy != 0)
+                for (int t = 0; t < 2 * k; t++)
                 {
-                    // Calcula as duas posições com efeito nefasto
-                    int x1 = a1->x - dx;
-                    int y1 = a1->y - dy;
-                    int x2 = a2->x + dx;
-                    int y2 = a2->y + dy;
-
-                    // Adiciona os pontos sem restrição de matriz
-                    efeitos = inserirEfeitoNefasto(efeitos, criarEfeitoNefasto(x1, y1));
-                    efeitos = inserirEfeitoNefasto(efeitos, criarEfeitoNefasto(x2, y2));
+                    // Cada índice entra duas vezes na lista
+                    size_t indice = indices[t / 2];
+                    int x = (int)((int64_t)(indice / (size_t)caixa.colunas) + origemX);
+                    int y = (int)((int64_t)(indice % (size_t)caixa.colunas) + origemY);
+                    RedeAntenas *novo = criarEfeitoNefasto(x, y);
+                    if (novo == NULL)
+                    {
+                        // Sem memória não devolve uma lista incompleta
+                        libertarEfeitos(efeitos);
+                        libertarGrupos(&g);
+                        return NULL;
+                    }
+                    efeitos = inserirEfeitoNefasto(efeitos, novo);
                 }
             }
         }
     }
 
+    libertarGrupos(&g);
     return efeitos;
 }
 
@@ -300,6 +1311,2437 @@ bool imprimirAntenasNefastos(const char *nomeFicheiro, RedeAntenas *h)
     return true;
 }
 
+GrelhaEsparsa *criarGrelha(LimitesMapa limites)
+{
+    GrelhaEsparsa *g = (GrelhaEsparsa *)reservarMemoriaZerada(1, sizeof(GrelhaEsparsa));
+    if (!g)
+    {
+        return NULL;
+    }
+    g->limites = limites;
+    return g;
+}
+
+void libertarGrelha(GrelhaEsparsa *g)
+{
+    if (g == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < g->numLinhas; i++)
+    {
+        libertarMemoria(g->linhas[i].colunas);
+        libertarMemoria(g->linhas[i].valores);
+    }
+    libertarMemoria(g->linhas);
+    libertarMemoria(g);
+}
+
+bool dentroGrelha(const GrelhaEsparsa *g, int x, int y)
+{
+    return x >= 0 && x < g->limites.linhas && y >= 0 && y < g->limites.colunas;
+}
+
+// Pesquisa binária: devolve a posição de v em vetor, ou a posição onde devia ser inserido
+static int posicaoOrdenada(const int *vetor, int n, int v)
+{
+    int inicio = 0, fim = n;
+    while (inicio < fim)
+    {
+        int meio = (inicio + fim) / 2;
+        if (vetor[meio] < v)
+            inicio = meio + 1;
+        else
+            fim = meio;
+    }
+    return inicio;
+}
+
+// Pesquisa binária da linha x (ou da posição onde devia ser inserida)
+static int posicaoLinha(const GrelhaEsparsa *g, int x)
+{
+    int inicio = 0, fim = g->numLinhas;
+    while (inicio < fim)
+    {
+        int meio = (inicio + fim) / 2;
+        if (g->linhas[meio].x < x)
+            inicio = meio + 1;
+        else
+            fim = meio;
+    }
+    return inicio;
+}
+
+char obterCelula(const GrelhaEsparsa *g, int x, int y)
+{
+    if (g == NULL || !dentroGrelha(g, x, y))
+    {
+        return '.';
+    }
+
+    int i = posicaoLinha(g, x);
+    if (i == g->numLinhas || g->linhas[i].x != x)
+    {
+        return '.';
+    }
+
+    const LinhaGrelha *l = &g->linhas[i];
+    int j = posicaoOrdenada(l->colunas, l->n, y);
+    return (j < l->n && l->colunas[j] == y) ? l->valores[j] : '.';
+}
+
+// Retira a célula j da linha i, e a própria linha se ficar vazia
+static void retirarCelula(GrelhaEsparsa *g, int i, int j)
+{
+    LinhaGrelha *l = &g->linhas[i];
+    memmove(l->colunas + j, l->colunas + j + 1, (size_t)(l->n - j - 1) * sizeof(int));
+    memmove(l->valores + j, l->valores + j + 1, (size_t)(l->n - j - 1));
+    l->n--;
+    g->ocupadas--;
+
+    if (l->n == 0)
+    {
+        libertarMemoria(l->colunas);
+        libertarMemoria(l->valores);
+        memmove(g->linhas + i, g->linhas + i + 1, (size_t)(g->numLinhas - i - 1) * sizeof(LinhaGrelha));
+        g->numLinhas--;
+    }
+}
+
+bool definirCelula(GrelhaEsparsa *g, int x, int y, char valor)
+{
+    if (g == NULL || !dentroGrelha(g, x, y))
+    {
+        return false;
+    }
+
+    int i = posicaoLinha(g, x);
+    bool existeLinha = (i < g->numLinhas && g->linhas[i].x == x);
+
+    // '.' apaga a célula
+    if (valor == '.')
+    {
+        if (existeLinha)
+        {
+            LinhaGrelha *l = &g->linhas[i];
+            int j = posicaoOrdenada(l->colunas, l->n, y);
+            if (j < l->n && l->colunas[j] == y)
+            {
+                retirarCelula(g, i, j);
+            }
+        }
+        return true;
+    }
+
+    if (!existeLinha)
+    {
+        if (g->numLinhas == g->capacidadeLinhas)
+        {
+            int capacidade = g->capacidadeLinhas ? g->capacidadeLinhas * 2 : 8;
+            LinhaGrelha *linhas = (LinhaGrelha *)realocarMemoria(g->linhas, (size_t)capacidade * sizeof(LinhaGrelha));
+            if (!linhas)
+            {
+                return false;
+            }
+            g->linhas = linhas;
+            g->capacidadeLinhas = capacidade;
+        }
+        memmove(g->linhas + i + 1, g->linhas + i, (size_t)(g->numLinhas - i) * sizeof(LinhaGrelha));
+        memset(&g->linhas[i], 0, sizeof(LinhaGrelha));
+        g->linhas[i].x = x;
+        g->numLinhas++;
+    }
+
+    LinhaGrelha *l = &g->linhas[i];
+    // Na leitura de um mapa as colunas chegam por ordem, e a pesquisa nem é precisa
+    int j = (l->n == 0 || l->colunas[l->n - 1] < y) ? l->n : posicaoOrdenada(l->colunas, l->n, y);
+    if (j < l->n && l->colunas[j] == y)
+    {
+        l->valores[j] = valor;
+        return true;
+    }
+
+    if (l->n == l->capacidade)
+    {
+        int capacidade = l->capacidade ? l->capacidade * 2 : 4;
+        int *colunas = (int *)realocarMemoria(l->colunas, (size_t)capacidade * sizeof(int));
+        if (colunas)
+        {
+            l->colunas = colunas;
+        }
+        char *valores = colunas ? (char *)realocarMemoria(l->valores, (size_t)capacidade) : NULL;
+        if (!valores)
+        {
+            if (l->n == 0)
+            {
+                // Linha acabada de criar: não pode ficar vazia na grelha
+                libertarMemoria(l->colunas);
+                memmove(g->linhas + i, g->linhas + i + 1, (size_t)(g->numLinhas - i - 1) * sizeof(LinhaGrelha));
+                g->numLinhas--;
+            }
+            return false;
+        }
+        l->valores = valores;
+        l->capacidade = capacidade;
+    }
+
+    memmove(l->colunas + j + 1, l->colunas + j, (size_t)(l->n - j) * sizeof(int));
+    memmove(l->valores + j + 1, l->valores + j, (size_t)(l->n - j));
+    l->colunas[j] = y;
+    l->valores[j] = valor;
+    l->n++;
+    g->ocupadas++;
+    return true;
+}
+
+bool percorrerGrelha(const GrelhaEsparsa *g, void (*visitar)(int x, int y, char valor, void *dados), void *dados)
+{
+    if (g == NULL || visitar == NULL)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < g->numLinhas; i++)
+    {
+        const LinhaGrelha *l = &g->linhas[i];
+        for (int j = 0; j < l->n; j++)
+        {
+            visitar(l->x, l->colunas[j], l->valores[j], dados);
+        }
+    }
+    return true;
+}
+
+GrelhaEsparsa *carregarGrelha(char *nomeFicheiro)
+{
+    FILE *f = fopen(nomeFicheiro, "r");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    // Os limites só ficam conhecidos no fim da leitura
+    LimitesMapa semLimites = { INT32_MAX, INT32_MAX };
+    GrelhaEsparsa *g = criarGrelha(semLimites);
+    int c, x = 0, y = 0, colunas = 0;
+
+    while (g != NULL && (c = fgetc(f)) != EOF)
+    {
+        // Como em carregarAntenasMapa, só as letras são antenas
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))
+        {
+            if (!definirCelula(g, x, y, (char)c))
+            {
+                libertarGrelha(g);
+                g = NULL;
+                break;
+            }
+        }
+
+        if (c == '\n')
+        {
+            x++;
+            y = 0;
+        }
+        else if (c != '\r')
+        {
+            y++;
+            if (y > colunas)
+            {
+                colunas = y;
+            }
+        }
+    }
+    fclose(f);
+
+    if (g != NULL)
+    {
+        g->limites.linhas = (y > 0) ? x + 1 : x;
+        g->limites.colunas = colunas;
+    }
+    return g;
+}
+
+GrelhaEsparsa *grelhaDeAntenas(Antena *h, LimitesMapa limites)
+{
+    GrelhaEsparsa *g = criarGrelha(limites);
+
+    for (Antena *a = h; a != NULL && g != NULL; a = a->prox)
+    {
+        // Antenas fora dos limites ficam de fora; só falha por falta de memória
+        if (dentroGrelha(g, a->x, a->y) && !definirCelula(g, a->x, a->y, a->freq))
+        {
+            libertarGrelha(g);
+            g = NULL;
+        }
+    }
+    return g;
+}
+
+GrelhaEsparsa *grelhaDeEfeitos(RedeAntenas *h, LimitesMapa limites)
+{
+    GrelhaEsparsa *g = criarGrelha(limites);
+
+    for (RedeAntenas *e = h; e != NULL && g != NULL; e = e->prox)
+    {
+        if (dentroGrelha(g, e->x, e->y) && !definirCelula(g, e->x, e->y, '#'))
+        {
+            libertarGrelha(g);
+            g = NULL;
+        }
+    }
+    return g;
+}
+
+GrelhaEsparsa *calcularEfeitosGrelha(Antena *h, LimitesMapa limites)
+{
+    GruposFrequencia grupos;
+    GrelhaEsparsa *g = criarGrelha(limites);
+
+    if (g == NULL || !agruparPorFrequencia(h, &grupos))
+    {
+        libertarGrelha(g);
+        return NULL;
+    }
+
+    for (int f = 0; f < NUM_FREQUENCIAS && g != NULL; f++)
+    {
+        for (size_t i = grupos.inicio[f]; i < grupos.inicio[f + 1] && g != NULL; i++)
+        {
+            for (size_t j = i + 1; j < grupos.inicio[f + 1] && g != NULL; j++)
+            {
+                int dx = grupos.x[j] - grupos.x[i];
+                int dy = grupos.y[j] - grupos.y[i];
+                if (dx == 0 && dy == 0)
+                    continue;
+
+                int pontos[2][2] = { { grupos.x[i] - dx, grupos.y[i] - dy }, { grupos.x[j] + dx, grupos.y[j] + dy } };
+                for (int p = 0; p < 2 && g != NULL; p++)
+                {
+                    if (dentroGrelha(g, pontos[p][0], pontos[p][1]) && !definirCelula(g, pontos[p][0], pontos[p][1], '#'))
+                    {
+                        libertarGrelha(g);
+                        g = NULL;
+                    }
+                }
+            }
+        }
+    }
+
+    libertarGrupos(&grupos);
+    return g;
+}
+
+// Escreve n caracteres '.' seguidos, em blocos
+static void escreverVazias(FILE *f, int n)
+{
+    static const char pontos[64] = "................................................................";
+    while (n > 0)
+    {
+        int k = (n < 64) ? n : 64;
+        fwrite(pontos, 1, (size_t)k, f);
+        n -= k;
+    }
+}
+
+bool imprimirGrelha(FILE *f, const GrelhaEsparsa *antenas, const GrelhaEsparsa *efeitos)
+{
+    if (f == NULL || antenas == NULL)
+    {
+        return false;
+    }
+
+    // As linhas vazias das duas grelhas são escritas de uma vez; nas outras, junta as células das duas
+    // (o efeito nefasto aparece como '#' por cima da antena, como em imprimirAntenasNefastos)
+    int ia = 0, ie = 0;
+    for (int x = 0; x < antenas->limites.linhas; x++)
+    {
+        const LinhaGrelha *la = (ia < antenas->numLinhas && antenas->linhas[ia].x == x) ? &antenas->linhas[ia++] : NULL;
+        const LinhaGrelha *le = NULL;
+        if (efeitos != NULL)
+        {
+            while (ie < efeitos->numLinhas && efeitos->linhas[ie].x < x)
+                ie++;
+            if (ie < efeitos->numLinhas && efeitos->linhas[ie].x == x)
+                le = &efeitos->linhas[ie];
+        }
+
+        int y = 0, ja = 0, je = 0;
+        while ((la && ja < la->n) || (le && je < le->n))
+        {
+            int ya = (la && ja < la->n) ? la->colunas[ja] : INT32_MAX;
+            int ye = (le && je < le->n) ? le->colunas[je] : INT32_MAX;
+            int proxima = (ya < ye) ? ya : ye;
+            if (proxima >= antenas->limites.colunas)
+                break;
+
+            escreverVazias(f, proxima - y);
+            fputc((ye == proxima) ? le->valores[je] : la->valores[ja], f);
+            ja += (ya == proxima);
+            je += (ye == proxima);
+            y = proxima + 1;
+        }
+        escreverVazias(f, antenas->limites.colunas - y);
+        fputc('\n', f);
+    }
+    return true;
+}
+
+// Inteiros sem sinal em formato variável: 7 bits por byte, com o bit alto a indicar que há mais
+static void gravarVariavel(FILE *f, uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        fputc((int)((v & 0x7F) | 0x80), f);
+        v >>= 7;
+    }
+    fputc((int)v, f);
+}
+
+static bool lerVariavel(FILE *f, uint32_t *v)
+{
+    *v = 0;
+    for (int deslocamento = 0; deslocamento < 35; deslocamento += 7)
+    {
+        int c = fgetc(f);
+        if (c == EOF)
+        {
+            return false;
+        }
+        *v |= (uint32_t)(c & 0x7F) << deslocamento;
+        if (!(c & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool gravarGrelha(char *nomeFicheiro, const GrelhaEsparsa *g)
+{
+    FILE *f = fopen(nomeFicheiro, "wb");
+    if (!f)
+    {
+        return false;
+    }
+
+    // Cabeçalho: "GRLE", linhas, colunas e número de linhas ocupadas.
+    // Cada linha: distância à linha ocupada anterior, número de sequências e, para cada sequência de
+    // células seguidas com o mesmo valor, o intervalo desde a sequência anterior, o comprimento e o valor.
+    fwrite("GRLE", 1, 4, f);
+    gravarVariavel(f, (uint32_t)g->limites.linhas);
+    gravarVariavel(f, (uint32_t)g->limites.colunas);
+    gravarVariavel(f, (uint32_t)g->numLinhas);
+
+    int xAnterior = 0;
+    for (int i = 0; i < g->numLinhas; i++)
+    {
+        const LinhaGrelha *l = &g->linhas[i];
+        uint32_t sequencias = 0;
+        for (int j = 0; j < l->n; j++)
+        {
+            sequencias += (j == 0 || l->colunas[j] != l->colunas[j - 1] + 1 || l->valores[j] != l->valores[j - 1]);
+        }
+
+        gravarVariavel(f, (uint32_t)(l->x - xAnterior));
+        gravarVariavel(f, sequencias);
+        xAnterior = l->x;
+
+        int fimAnterior = 0;
+        for (int j = 0; j < l->n;)
+        {
+            int k = j + 1;
+            while (k < l->n && l->colunas[k] == l->colunas[k - 1] + 1 && l->valores[k] == l->valores[j])
+                k++;
+
+            gravarVariavel(f, (uint32_t)(l->colunas[j] - fimAnterior));
+            gravarVariavel(f, (uint32_t)(k - j));
+            fputc((unsigned char)l->valores[j], f);
+            fimAnterior = l->colunas[k - 1] + 1;
+            j = k;
+        }
+    }
+
+    bool ok = !ferror(f);
+    return (fclose(f) == 0) && ok;
+}
+
+GrelhaEsparsa *carregarGrelhaBinario(char *nomeFicheiro)
+{
+    FILE *f = fopen(nomeFicheiro, "rb");
+    if (!f)
+    {
+        return NULL;
+    }
+
+    char magia[4];
+    uint32_t linhas, colunas, ocupadas;
+    if (fread(magia, 1, 4, f) != 4 || memcmp(magia, "GRLE", 4) != 0 || !lerVariavel(f, &linhas) ||
+        !lerVariavel(f, &colunas) || !lerVariavel(f, &ocupadas) || linhas > INT32_MAX || colunas > INT32_MAX)
+    {
+        fclose(f);
+        return NULL;
+    }
+
+    LimitesMapa limites = { (int)linhas, (int)colunas };
+    GrelhaEsparsa *g = criarGrelha(limites);
+    uint32_t x = 0;
+
+    for (uint32_t i = 0; i < ocupadas && g != NULL; i++)
+    {
+        uint32_t dx, sequencias, y = 0;
+        bool ok = lerVariavel(f, &dx) && lerVariavel(f, &sequencias);
+        x += dx;
+
+        for (uint32_t s = 0; s < sequencias && ok; s++)
+        {
+            uint32_t intervalo, comprimento;
+            int valor;
+            ok = lerVariavel(f, &intervalo) && lerVariavel(f, &comprimento) && (valor = fgetc(f)) != EOF;
+            y += intervalo;
+            for (uint32_t k = 0; k < comprimento && ok; k++, y++)
+            {
+                // definirCelula recusa posições fora dos limites, o que também apanha ficheiros corrompidos
+                ok = definirCelula(g, (int)x, (int)y, (char)valor);
+            }
+        }
+
+        if (!ok)
+        {
+            libertarGrelha(g);
+            g = NULL;
+        }
+    }
+
+    fclose(f);
+    return g;
+}
+
+// Frequências marcadas e não vazias, agrupadas como em agruparPorFrequencia, a partir das células da grelha
+static bool agruparGrelha(const GrelhaEsparsa *m, const bool afetada[NUM_FREQUENCIAS], GruposFrequencia *g)
+{
+    size_t contagem[NUM_FREQUENCIAS] = { 0 };
+    size_t n = 0;
+
+    for (int i = 0; i < m->numLinhas; i++)
+    {
+        const LinhaGrelha *l = &m->linhas[i];
+        for (int j = 0; j < l->n; j++)
+        {
+            unsigned char f = (unsigned char)l->valores[j] % NUM_FREQUENCIAS;
+            if (afetada[f])
+            {
+                contagem[f]++;
+                n++;
+            }
+        }
+    }
+
+    g->x = (int *)reservarMemoria((n + 1) * sizeof(int));
+    g->y = (int *)reservarMemoria((n + 1) * sizeof(int));
+    if (!g->x || !g->y)
+    {
+        libertarGrupos(g);
+        return false;
+    }
+
+    g->inicio[0] = 0;
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        g->inicio[f + 1] = g->inicio[f] + contagem[f];
+    }
+
+    size_t posicao[NUM_FREQUENCIAS];
+    memcpy(posicao, g->inicio, sizeof(posicao));
+    for (int i = 0; i < m->numLinhas; i++)
+    {
+        const LinhaGrelha *l = &m->linhas[i];
+        for (int j = 0; j < l->n; j++)
+        {
+            unsigned char f = (unsigned char)l->valores[j] % NUM_FREQUENCIAS;
+            if (afetada[f])
+            {
+                size_t k = posicao[f]++;
+                g->x[k] = l->x;
+                g->y[k] = l->colunas[j];
+            }
+        }
+    }
+    return true;
+}
+
+static inline bool ehAntena(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+// Conjunto de posições por endereçamento aberto (sondagem linear), com capacidade potência de 2
+typedef struct ConjuntoPosicoes
+{
+    uint64_t *chaves;
+    unsigned char *ocupado;
+    size_t capacidade, tamanho;
+} ConjuntoPosicoes;
+
+static inline size_t dispersarPosicao(uint64_t chave, size_t mascara)
+{
+    chave *= 0x9E3779B97F4A7C15ull;
+    return (size_t)(chave ^ (chave >> 32)) & mascara;
+}
+
+static bool iniciarConjunto(ConjuntoPosicoes *c, size_t n)
+{
+    c->capacidade = 16;
+    while (c->capacidade < 2 * n)
+    {
+        c->capacidade *= 2;
+    }
+    c->tamanho = 0;
+    c->chaves = (uint64_t *)reservarMemoria(c->capacidade * sizeof(uint64_t));
+    c->ocupado = (unsigned char *)reservarMemoriaZerada(c->capacidade, 1);
+    return c->chaves && c->ocupado;
+}
+
+static void libertarConjunto(ConjuntoPosicoes *c)
+{
+    libertarMemoria(c->chaves);
+    libertarMemoria(c->ocupado);
+    c->chaves = NULL;
+    c->ocupado = NULL;
+}
+
+static bool conjuntoContem(const ConjuntoPosicoes *c, int x, int y)
+{
+    uint64_t chave = chaveCoordenadas(x, y);
+    size_t mascara = c->capacidade - 1;
+
+    for (size_t i = dispersarPosicao(chave, mascara); c->ocupado[i]; i = (i + 1) & mascara)
+    {
+        if (c->chaves[i] == chave)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Acrescenta (x, y); devolve 1 se a posição é nova, 0 se já existia e -1 sem memória
+static int conjuntoAcrescentar(ConjuntoPosicoes *c, int x, int y)
+{
+    if (2 * (c->tamanho + 1) > c->capacidade)
+    {
+        ConjuntoPosicoes maior;
+        maior.capacidade = c->capacidade * 2;
+        maior.tamanho = c->tamanho;
+        maior.chaves = (uint64_t *)reservarMemoria(maior.capacidade * sizeof(uint64_t));
+        maior.ocupado = (unsigned char *)reservarMemoriaZerada(maior.capacidade, 1);
+        if (!maior.chaves || !maior.ocupado)
+        {
+            libertarConjunto(&maior);
+            return -1;
+        }
+        for (size_t i = 0; i < c->capacidade; i++)
+        {
+            if (c->ocupado[i])
+            {
+                size_t j = dispersarPosicao(c->chaves[i], maior.capacidade - 1);
+                while (maior.ocupado[j])
+                {
+                    j = (j + 1) & (maior.capacidade - 1);
+                }
+                maior.chaves[j] = c->chaves[i];
+                maior.ocupado[j] = 1;
+            }
+        }
+        libertarConjunto(c);
+        *c = maior;
+    }
+
+    uint64_t chave = chaveCoordenadas(x, y);
+    size_t mascara = c->capacidade - 1;
+    size_t i = dispersarPosicao(chave, mascara);
+    for (; c->ocupado[i]; i = (i + 1) & mascara)
+    {
+        if (c->chaves[i] == chave)
+        {
+            return 0;
+        }
+    }
+    c->chaves[i] = chave;
+    c->ocupado[i] = 1;
+    c->tamanho++;
+    return 1;
+}
+
+// Tabela de contagens por endereçamento aberto; as remoções deslocam os elementos seguintes
+static bool iniciarContagens(TabelaContagens *t, size_t n)
+{
+    t->capacidade = 64;
+    while (t->capacidade < 2 * n)
+    {
+        t->capacidade *= 2;
+    }
+    t->tamanho = 0;
+    t->chaves = (uint64_t *)reservarMemoria(t->capacidade * sizeof(uint64_t));
+    t->contagens = (uint32_t *)reservarMemoria(t->capacidade * sizeof(uint32_t));
+    t->ocupado = (unsigned char *)reservarMemoriaZerada(t->capacidade, 1);
+    return t->chaves && t->contagens && t->ocupado;
+}
+
+static void libertarContagens(TabelaContagens *t)
+{
+    libertarMemoria(t->chaves);
+    libertarMemoria(t->contagens);
+    libertarMemoria(t->ocupado);
+    t->chaves = NULL;
+    t->contagens = NULL;
+    t->ocupado = NULL;
+}
+
+// Soma delta (+1 ou -1) à contagem da posição e devolve a nova contagem (-1 sem memória)
+static long alterarContagem(TabelaContagens *t, int x, int y, int delta)
+{
+    if (delta > 0 && 2 * (t->tamanho + 1) > t->capacidade)
+    {
+        TabelaContagens maior;
+        if (!iniciarContagens(&maior, t->capacidade))
+        {
+            libertarContagens(&maior);
+            return -1;
+        }
+        for (size_t i = 0; i < t->capacidade; i++)
+        {
+            if (t->ocupado[i])
+            {
+                size_t j = dispersarPosicao(t->chaves[i], maior.capacidade - 1);
+                while (maior.ocupado[j])
+                {
+                    j = (j + 1) & (maior.capacidade - 1);
+                }
+                maior.chaves[j] = t->chaves[i];
+                maior.contagens[j] = t->contagens[i];
+                maior.ocupado[j] = 1;
+            }
+        }
+        maior.tamanho = t->tamanho;
+        libertarContagens(t);
+        *t = maior;
+    }
+
+    uint64_t chave = chaveCoordenadas(x, y);
+    size_t mascara = t->capacidade - 1;
+    size_t i = dispersarPosicao(chave, mascara);
+    while (t->ocupado[i] && t->chaves[i] != chave)
+    {
+        i = (i + 1) & mascara;
+    }
+
+    if (!t->ocupado[i])
+    {
+        if (delta < 0)
+        {
+            return 0; // Nunca acontece se as inserções e remoções forem simétricas
+        }
+        t->chaves[i] = chave;
+        t->contagens[i] = 1;
+        t->ocupado[i] = 1;
+        t->tamanho++;
+        return 1;
+    }
+
+    if (delta > 0)
+    {
+        return ++t->contagens[i];
+    }
+    if (--t->contagens[i] > 0)
+    {
+        return t->contagens[i];
+    }
+
+    // Contagem a zero: retira a posição e puxa para trás os elementos que a tinham saltado
+    t->ocupado[i] = 0;
+    t->tamanho--;
+    for (size_t j = (i + 1) & mascara; t->ocupado[j]; j = (j + 1) & mascara)
+    {
+        size_t ideal = dispersarPosicao(t->chaves[j], mascara);
+        if (((j - ideal) & mascara) >= ((j - i) & mascara))
+        {
+            t->chaves[i] = t->chaves[j];
+            t->contagens[i] = t->contagens[j];
+            t->ocupado[i] = 1;
+            t->ocupado[j] = 0;
+            i = j;
+        }
+    }
+    return 0;
+}
+
+// Contagem atual da posição (0 se nenhum par a produz)
+static uint32_t contagemPosicao(const TabelaContagens *t, int x, int y)
+{
+    uint64_t chave = chaveCoordenadas(x, y);
+    size_t mascara = t->capacidade - 1;
+
+    for (size_t i = dispersarPosicao(chave, mascara); t->ocupado[i]; i = (i + 1) & mascara)
+    {
+        if (t->chaves[i] == chave)
+        {
+            return t->contagens[i];
+        }
+    }
+    return 0;
+}
+
+static bool acrescentarAlteracao(DiferencasMapa *dif, TipoAlteracao tipo, char freq, int x, int y, int xNovo, int yNovo)
+{
+    if (dif->quantidade == dif->capacidade)
+    {
+        size_t capacidade = dif->capacidade ? dif->capacidade * 2 : 16;
+        Alteracao *itens = (Alteracao *)realocarMemoria(dif->itens, capacidade * sizeof(Alteracao));
+        if (!itens)
+        {
+            return false;
+        }
+        dif->itens = itens;
+        dif->capacidade = capacidade;
+    }
+
+    Alteracao *a = &dif->itens[dif->quantidade++];
+    a->tipo = tipo;
+    a->freq = freq;
+    a->x = x;
+    a->y = y;
+    a->xNovo = xNovo;
+    a->yNovo = yNovo;
+    return true;
+}
+
+// Antenas de uma frequência numa versão do mapa (vetores do grupo)
+typedef struct VersaoFrequencia
+{
+    const int *x, *y;
+    size_t n;
+} VersaoFrequencia;
+
+// Multiplicidade dos efeitos de uma frequência, da versão antiga para a nova, e posições que mudaram
+typedef struct ContagemDiferencas
+{
+    TabelaContagens *contagens;     // Da própria comparação, ou a guardada num EstadoDiferencas
+    ConjuntoPosicoes tocadas;       // Posições cuja contagem foi alterada
+    ConjuntoPosicoes tinhamEfeito;  // Das tocadas, as que tinham algum par antes da primeira alteração
+} ContagemDiferencas;
+
+static inline bool dentroLimites(LimitesMapa l, int x, int y)
+{
+    return x >= 0 && x < l.linhas && y >= 0 && y < l.colunas;
+}
+
+// Soma delta à multiplicidade dos dois efeitos do par (a, b) que caem dentro de alguma das versões;
+// com tocar, regista também as posições alteradas
+static bool contarPar(ContagemDiferencas *c, LimitesMapa antes, LimitesMapa depois, int ax, int ay, int bx, int by, int delta, bool tocar)
+{
+    int dx = bx - ax;
+    int dy = by - ay;
+    int pontos[2][2] = { { ax - dx, ay - dy }, { bx + dx, by + dy } };
+    for (int p = 0; p < 2; p++)
+    {
+        int px = pontos[p][0], py = pontos[p][1];
+        if (!dentroLimites(antes, px, py) && !dentroLimites(depois, px, py))
+            continue;
+
+        long contagem = alterarContagem(c->contagens, px, py, delta);
+        if (contagem < 0)
+        {
+            return false;
+        }
+        if (tocar)
+        {
+            int nova = conjuntoAcrescentar(&c->tocadas, px, py);
+            if (nova < 0 || (nova == 1 && contagem - delta > 0 && conjuntoAcrescentar(&c->tinhamEfeito, px, py) < 0))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Multiplicidade dos efeitos de uma versão: quantos pares dão cada posição. É o único passo O(k²),
+// feito uma vez por comparação isolada ou uma vez no início de um EstadoDiferencas
+static bool contarEfeitos(ContagemDiferencas *c, LimitesMapa antes, LimitesMapa depois, const VersaoFrequencia *v)
+{
+    for (size_t i = 0; i < v->n; i++)
+    {
+        for (size_t j = i + 1; j < v->n; j++)
+        {
+            if (!contarPar(c, antes, depois, v->x[i], v->y[i], v->x[j], v->y[j], 1, false))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Soma delta à multiplicidade dos efeitos dos pares que as antenas alteradas (ax, ay) formam na versão.
+// Um par de duas antenas alteradas conta uma só vez: a segunda salta as que já foram tratadas
+static bool contarAlteradas(ContagemDiferencas *c, const DiferencasMapa *dif, const int *ax, const int *ay, size_t na,
+                            const VersaoFrequencia *v, int delta)
+{
+    ConjuntoPosicoes feitas;
+    if (na == 0)
+    {
+        return true;
+    }
+    bool ok = iniciarConjunto(&feitas, na);
+
+    for (size_t i = 0; i < na && ok; i++)
+    {
+        for (size_t j = 0; j < v->n && ok; j++)
+        {
+            if ((v->x[j] == ax[i] && v->y[j] == ay[i]) || conjuntoContem(&feitas, v->x[j], v->y[j]))
+                continue;
+
+            ok = contarPar(c, dif->antes, dif->depois, ax[i], ay[i], v->x[j], v->y[j], delta, true);
+        }
+        ok = ok && conjuntoAcrescentar(&feitas, ax[i], ay[i]) >= 0;
+    }
+
+    libertarConjunto(&feitas);
+    return ok;
+}
+
+// Regista como tipo cada posição tocada cujo efeito só existe numa das versões
+static bool registarEfeitosAlterados(DiferencasMapa *dif, char freq, const ContagemDiferencas *c, TipoAlteracao tipo)
+{
+    for (size_t i = 0; i < c->tocadas.capacidade; i++)
+    {
+        if (!c->tocadas.ocupado[i])
+            continue;
+
+        int x = (int)((uint32_t)(c->tocadas.chaves[i] >> 32) ^ 0x80000000u);
+        int y = (int)((uint32_t)c->tocadas.chaves[i] ^ 0x80000000u);
+        bool antes = dentroLimites(dif->antes, x, y) && conjuntoContem(&c->tinhamEfeito, x, y);
+        bool depois = dentroLimites(dif->depois, x, y) && contagemPosicao(c->contagens, x, y) > 0;
+
+        if (((tipo == EFEITO_PERDIDO && antes && !depois) || (tipo == EFEITO_GANHO && depois && !antes)) &&
+            !acrescentarAlteracao(dif, tipo, freq, x, y, 0, 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Junta cada antena removida à primeira antena adicionada com a mesma frequência, como uma mudança de posição
+static void juntarMudancas(DiferencasMapa *dif)
+{
+    size_t cursor[NUM_FREQUENCIAS] = { 0 };
+    bool *consumida = (bool *)reservarMemoriaZerada(dif->quantidade + 1, sizeof(bool));
+    if (!consumida)
+    {
+        return; // Sem memória fica só como remoção e adição, que também é correto
+    }
+
+    for (size_t i = 0; i < dif->quantidade; i++)
+    {
+        Alteracao *r = &dif->itens[i];
+        if (r->tipo != ANTENA_REMOVIDA)
+            continue;
+
+        size_t *c = &cursor[(unsigned char)r->freq];
+        while (*c < dif->quantidade && (consumida[*c] || dif->itens[*c].tipo != ANTENA_ADICIONADA || dif->itens[*c].freq != r->freq))
+        {
+            (*c)++;
+        }
+        if (*c < dif->quantidade)
+        {
+            r->tipo = ANTENA_MOVIDA;
+            r->xNovo = dif->itens[*c].x;
+            r->yNovo = dif->itens[*c].y;
+            consumida[*c] = true;
+        }
+    }
+
+    size_t k = 0;
+    for (size_t i = 0; i < dif->quantidade; i++)
+    {
+        if (!consumida[i])
+        {
+            dif->itens[k++] = dif->itens[i];
+        }
+    }
+    dif->quantidade = k;
+    libertarMemoria(consumida);
+}
+
+// Posições das antenas da frequência alteradas numa versão (removidas do mapa antigo ou adicionadas ao novo)
+static bool posicoesAlteradas(const DiferencasMapa *dif, size_t fim, char freq, bool antigas, int **ax, int **ay, size_t *n)
+{
+    *n = 0;
+    *ax = (int *)reservarMemoria((fim + 1) * sizeof(int));
+    *ay = (int *)reservarMemoria((fim + 1) * sizeof(int));
+    if (!*ax || !*ay)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < fim; i++)
+    {
+        const Alteracao *a = &dif->itens[i];
+        if (a->freq != freq)
+            continue;
+
+        if (antigas && (a->tipo == ANTENA_REMOVIDA || a->tipo == ANTENA_MOVIDA))
+        {
+            (*ax)[*n] = a->x;
+            (*ay)[(*n)++] = a->y;
+        }
+        else if (!antigas && a->tipo == ANTENA_ADICIONADA)
+        {
+            (*ax)[*n] = a->x;
+            (*ay)[(*n)++] = a->y;
+        }
+        else if (!antigas && a->tipo == ANTENA_MOVIDA)
+        {
+            (*ax)[*n] = a->xNovo;
+            (*ay)[(*n)++] = a->yNovo;
+        }
+    }
+    return true;
+}
+
+static void iniciarVersaoFrequencia(VersaoFrequencia *v, const GruposFrequencia *g, int f)
+{
+    v->x = g->x + g->inicio[f];
+    v->y = g->y + g->inicio[f];
+    v->n = g->inicio[f + 1] - g->inicio[f];
+}
+
+// Efeitos ganhos e perdidos por uma frequência afetada. Os pares das antenas removidas descontam à
+// multiplicidade dos efeitos da versão antiga e os das adicionadas somam-lhe, o que custa O(alteradas·k).
+// Sem multiplicidade guardada (guardada NULL) ou com limites diferentes, a da versão antiga é contada
+// primeiro, em O(k²); com ela, é atualizada no lugar e fica a ser a da versão nova
+static bool diferencasFrequencia(DiferencasMapa *dif, size_t numAntenas, int f, bool tudo,
+                                 const GruposFrequencia *gAntes, const GruposFrequencia *gDepois, TabelaContagens *guardada)
+{
+    VersaoFrequencia antes, depois;
+    TabelaContagens propria = { NULL, NULL, NULL, 0, 0 };
+    ContagemDiferencas c = { (guardada != NULL && !tudo) ? guardada : &propria, { 0 }, { 0 } };
+    int *rx = NULL, *ry = NULL, *ax = NULL, *ay = NULL;
+    size_t nr = 0, na = 0;
+    iniciarVersaoFrequencia(&antes, gAntes, f);
+    iniciarVersaoFrequencia(&depois, gDepois, f);
+
+    bool ok = iniciarConjunto(&c.tocadas, antes.n + depois.n) && iniciarConjunto(&c.tinhamEfeito, antes.n);
+    if (ok && c.contagens == &propria)
+    {
+        ok = iniciarContagens(&propria, antes.n) && contarEfeitos(&c, dif->antes, dif->depois, &antes);
+    }
+    if (ok && tudo)
+    {
+        // Com limites diferentes, qualquer efeito pode entrar ou sair da matriz: todas as antenas contam
+        rx = (int *)antes.x; ry = (int *)antes.y; nr = antes.n;
+        ax = (int *)depois.x; ay = (int *)depois.y; na = depois.n;
+    }
+    else if (ok)
+    {
+        ok = posicoesAlteradas(dif, numAntenas, (char)f, true, &rx, &ry, &nr) &&
+             posicoesAlteradas(dif, numAntenas, (char)f, false, &ax, &ay, &na);
+    }
+
+    ok = ok && contarAlteradas(&c, dif, rx, ry, nr, &antes, -1) &&
+               contarAlteradas(&c, dif, ax, ay, na, &depois, 1);
+
+    ok = ok && registarEfeitosAlterados(dif, (char)f, &c, EFEITO_PERDIDO) &&
+               registarEfeitosAlterados(dif, (char)f, &c, EFEITO_GANHO);
+
+    if (!tudo)
+    {
+        libertarMemoria(rx); libertarMemoria(ry); libertarMemoria(ax); libertarMemoria(ay);
+    }
+    if (ok && guardada != NULL && c.contagens == &propria)
+    {
+        libertarContagens(guardada);
+        *guardada = propria; // Recontada com os limites novos
+    }
+    else if (c.contagens == &propria)
+    {
+        libertarContagens(&propria);
+    }
+    libertarConjunto(&c.tocadas);
+    libertarConjunto(&c.tinhamEfeito);
+    return ok;
+}
+
+// Com estado, as multiplicidades guardadas são as da versão antiga e passam a ser as da nova
+static bool compararComEstado(const GrelhaEsparsa *antiga, const GrelhaEsparsa *nova, EstadoDiferencas *estado, DiferencasMapa *dif)
+{
+    memset(dif, 0, sizeof(DiferencasMapa));
+    if (antiga == NULL || nova == NULL)
+    {
+        return false;
+    }
+    dif->antes = antiga->limites;
+    dif->depois = nova->limites;
+
+    // Linha a linha, pela ordem das linhas ocupadas das duas grelhas: as linhas iguais são saltadas
+    // com uma comparação de memória, e nas restantes as colunas são fundidas por ordem
+    bool ok = true;
+    bool afetada[NUM_FREQUENCIAS] = { false };
+    int ia = 0, in = 0;
+    while ((ia < antiga->numLinhas || in < nova->numLinhas) && ok)
+    {
+        int xa = (ia < antiga->numLinhas) ? antiga->linhas[ia].x : INT32_MAX;
+        int xn = (in < nova->numLinhas) ? nova->linhas[in].x : INT32_MAX;
+        int x = (xa < xn) ? xa : xn;
+        const LinhaGrelha *la = (xa == x) ? &antiga->linhas[ia++] : NULL;
+        const LinhaGrelha *ln = (xn == x) ? &nova->linhas[in++] : NULL;
+
+        if (la && ln && la->n == ln->n && memcmp(la->colunas, ln->colunas, (size_t)la->n * sizeof(int)) == 0 &&
+            memcmp(la->valores, ln->valores, (size_t)la->n) == 0)
+            continue;
+
+        int ja = 0, jn = 0;
+        int na = la ? la->n : 0, nn = ln ? ln->n : 0;
+        while ((ja < na || jn < nn) && ok)
+        {
+            int ya = (ja < na) ? la->colunas[ja] : INT32_MAX;
+            int yn = (jn < nn) ? ln->colunas[jn] : INT32_MAX;
+            int y = (ya < yn) ? ya : yn;
+            char a = (ya == y) ? la->valores[ja++] : '.';
+            char b = (yn == y) ? ln->valores[jn++] : '.';
+            if (a == b)
+                continue;
+
+            if (ehAntena(a))
+            {
+                ok = acrescentarAlteracao(dif, ANTENA_REMOVIDA, a, x, y, 0, 0);
+                afetada[(unsigned char)a] = true;
+            }
+            if (ok && ehAntena(b))
+            {
+                ok = acrescentarAlteracao(dif, ANTENA_ADICIONADA, b, x, y, 0, 0);
+                afetada[(unsigned char)b] = true;
+            }
+        }
+    }
+    juntarMudancas(dif);
+
+    // Se a matriz mudou de tamanho, todas as frequências são afetadas
+    bool tudo = (dif->antes.linhas != dif->depois.linhas || dif->antes.colunas != dif->depois.colunas);
+    if (tudo)
+    {
+        memset(afetada, true, sizeof(afetada));
+    }
+
+    // Só os efeitos das frequências afetadas podem mudar; para essas, apenas os pares com antenas alteradas
+    GruposFrequencia gAntes = { { 0 }, NULL, NULL }, gDepois = { { 0 }, NULL, NULL };
+    size_t numAntenas = dif->quantidade;
+    ok = ok && agruparGrelha(antiga, afetada, &gAntes) && agruparGrelha(nova, afetada, &gDepois);
+
+    for (int f = 0; f < NUM_FREQUENCIAS && ok; f++)
+    {
+        if (afetada[f] && ehAntena((char)f))
+        {
+            ok = diferencasFrequencia(dif, numAntenas, f, tudo, &gAntes, &gDepois, estado ? &estado->contagens[f] : NULL);
+        }
+    }
+
+    libertarGrupos(&gAntes);
+    libertarGrupos(&gDepois);
+    if (!ok)
+    {
+        libertarDiferencas(dif);
+    }
+    return ok;
+}
+
+bool compararGrelhas(const GrelhaEsparsa *antiga, const GrelhaEsparsa *nova, DiferencasMapa *dif)
+{
+    return compararComEstado(antiga, nova, NULL, dif);
+}
+
+// Conta de raiz a multiplicidade e o número de efeitos de todas as frequências da versão guardada
+static bool recontarEstado(EstadoDiferencas *e)
+{
+    bool todas[NUM_FREQUENCIAS];
+    GruposFrequencia g = { { 0 }, NULL, NULL };
+    memset(todas, true, sizeof(todas));
+    bool ok = agruparGrelha(e->versao, todas, &g);
+    LimitesMapa l = e->versao->limites;
+
+    for (int f = 0; f < NUM_FREQUENCIAS && ok; f++)
+    {
+        VersaoFrequencia v;
+        iniciarVersaoFrequencia(&v, &g, f);
+        ContagemDiferencas c = { &e->contagens[f], { 0 }, { 0 } };
+        libertarContagens(&e->contagens[f]);
+        ok = iniciarContagens(&e->contagens[f], v.n) && contarEfeitos(&c, l, l, &v);
+
+        e->efeitos[f] = 0;
+        for (size_t i = 0; ok && i < e->contagens[f].capacidade; i++)
+        {
+            e->efeitos[f] += e->contagens[f].ocupado[i] != 0; // Só há contagens dentro dos limites
+        }
+    }
+
+    libertarGrupos(&g);
+    e->valido = ok;
+    return ok;
+}
+
+bool iniciarEstadoDiferencas(EstadoDiferencas *e, char *nomeFicheiro)
+{
+    memset(e, 0, sizeof(EstadoDiferencas));
+    e->versao = carregarGrelha(nomeFicheiro);
+    if (e->versao == NULL || !recontarEstado(e))
+    {
+        libertarEstadoDiferencas(e);
+        return false;
+    }
+    return true;
+}
+
+bool compararVersaoSeguinte(EstadoDiferencas *e, char *nomeFicheiro, DiferencasMapa *dif)
+{
+    memset(dif, 0, sizeof(DiferencasMapa));
+    GrelhaEsparsa *nova = carregarGrelha(nomeFicheiro);
+    if (nova == NULL || (!e->valido && !recontarEstado(e)))
+    {
+        libertarGrelha(nova);
+        return false;
+    }
+
+    // Uma falha a meio deixa as multiplicidades entre as duas versões: são recontadas na próxima vez
+    if (!compararComEstado(e->versao, nova, e, dif))
+    {
+        e->valido = false;
+        libertarGrelha(nova);
+        return false;
+    }
+
+    for (size_t i = 0; i < dif->quantidade; i++)
+    {
+        const Alteracao *a = &dif->itens[i];
+        if (a->tipo == EFEITO_GANHO)
+            e->efeitos[(unsigned char)a->freq]++;
+        else if (a->tipo == EFEITO_PERDIDO)
+            e->efeitos[(unsigned char)a->freq]--;
+    }
+    libertarGrelha(e->versao);
+    e->versao = nova;
+    return true;
+}
+
+void libertarEstadoDiferencas(EstadoDiferencas *e)
+{
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        libertarContagens(&e->contagens[f]);
+    }
+    libertarGrelha(e->versao);
+    memset(e, 0, sizeof(EstadoDiferencas));
+}
+
+bool compararMapas(char *ficheiroAntigo, char *ficheiroNovo, DiferencasMapa *dif)
+{
+    GrelhaEsparsa *antiga = carregarGrelha(ficheiroAntigo);
+    GrelhaEsparsa *nova = (antiga != NULL) ? carregarGrelha(ficheiroNovo) : NULL;
+
+    bool ok = compararGrelhas(antiga, nova, dif);
+    libertarGrelha(antiga);
+    libertarGrelha(nova);
+    return ok;
+}
+
+bool imprimirDiferencas(const DiferencasMapa *dif)
+{
+    if (dif == NULL)
+    {
+        return false;
+    }
+
+    // Uma alteração por linha: '+'/'-' antena adicionada/removida, '>' antena movida,
+    // "+#"/"-#" efeito nefasto ganho/perdido pela frequência
+    for (size_t i = 0; i < dif->quantidade; i++)
+    {
+        const Alteracao *a = &dif->itens[i];
+        switch (a->tipo)
+        {
+        case ANTENA_ADICIONADA: printf("+ %c %d %d\n", a->freq, a->x, a->y); break;
+        case ANTENA_REMOVIDA:   printf("- %c %d %d\n", a->freq, a->x, a->y); break;
+        case ANTENA_MOVIDA:     printf("> %c %d %d %d %d\n", a->freq, a->x, a->y, a->xNovo, a->yNovo); break;
+        case EFEITO_GANHO:      printf("+# %c %d %d\n", a->freq, a->x, a->y); break;
+        case EFEITO_PERDIDO:    printf("-# %c %d %d\n", a->freq, a->x, a->y); break;
+        }
+    }
+    return true;
+}
+
+void libertarDiferencas(DiferencasMapa *dif)
+{
+    libertarMemoria(dif->itens);
+    dif->itens = NULL;
+    dif->quantidade = 0;
+    dif->capacidade = 0;
+}
+
+// Dispersão FNV-1a de uma linha do ficheiro, sem o '\r' final
+static uint64_t dispersarLinha(const char *linha, size_t n)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < n; i++)
+    {
+        h = (h ^ (unsigned char)linha[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Lê o ficheiro inteiro para memória (terminado em '\0')
+static char *lerFicheiro(const char *nomeFicheiro, size_t *tamanho)
+{
+    FILE *f = fopen(nomeFicheiro, "rb");
+    if (!f)
+    {
+        return NULL;
+    }
+
+    size_t capacidade = 4096, lidos;
+    char *texto = (char *)reservarMemoria(capacidade + 1);
+    *tamanho = 0;
+    while (texto && (lidos = fread(texto + *tamanho, 1, capacidade - *tamanho, f)) > 0)
+    {
+        *tamanho += lidos;
+        if (*tamanho == capacidade)
+        {
+            char *maior = (char *)realocarMemoria(texto, capacidade * 2 + 1);
+            if (!maior)
+            {
+                libertarMemoria(texto);
+                texto = NULL;
+                break;
+            }
+            texto = maior;
+            capacidade *= 2;
+        }
+    }
+    fclose(f);
+
+    if (texto)
+    {
+        texto[*tamanho] = '\0';
+    }
+    return texto;
+}
+
+// Retira uma contagem da posição e limpa-a do mapa quando deixa de ter pares (nunca precisa de memória)
+static void retirarParVigia(VigiaMapa *v, int x, int y)
+{
+    if (alterarContagem(&v->contagens, x, y, -1) == 0)
+    {
+        definirCelula(v->efeitos, x, y, '.');
+    }
+}
+
+// Aplica aos efeitos nefastos os pares da antena (freq, x, y) com as restantes da sua frequência.
+// Se faltar memória a meio de uma inserção, as contagens já feitas são desfeitas
+static bool paresAntenaVigia(VigiaMapa *v, char freq, int x, int y, int delta)
+{
+    PosicoesFrequencia *p = &v->porFrequencia[(unsigned char)freq % NUM_FREQUENCIAS];
+
+    for (size_t i = 0; i < p->n; i++)
+    {
+        int dx = p->x[i] - x;
+        int dy = p->y[i] - y;
+        if (dx == 0 && dy == 0)
+            continue;
+
+        int pontos[2][2] = { { x - dx, y - dy }, { p->x[i] + dx, p->y[i] + dy } };
+        for (int k = 0; k < 2; k++)
+        {
+            if (delta < 0)
+            {
+                retirarParVigia(v, pontos[k][0], pontos[k][1]);
+                continue;
+            }
+
+            long contagem = alterarContagem(&v->contagens, pontos[k][0], pontos[k][1], delta);
+            // Só muda o mapa quando a posição passa a ter algum par
+            if (contagem < 0 || (contagem == 1 && dentroGrelha(v->efeitos, pontos[k][0], pontos[k][1]) &&
+                                 !definirCelula(v->efeitos, pontos[k][0], pontos[k][1], '#')))
+            {
+                if (contagem > 0)
+                    retirarParVigia(v, pontos[k][0], pontos[k][1]);
+                if (k == 1)
+                    retirarParVigia(v, pontos[0][0], pontos[0][1]);
+                for (size_t j = 0; j < i; j++)
+                {
+                    int ex = p->x[j] - x, ey = p->y[j] - y;
+                    if (ex == 0 && ey == 0)
+                        continue;
+                    retirarParVigia(v, x - ex, y - ey);
+                    retirarParVigia(v, p->x[j] + ex, p->y[j] + ey);
+                }
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool inserirAntenaVigia(VigiaMapa *v, char freq, int x, int y)
+{
+    PosicoesFrequencia *p = &v->porFrequencia[(unsigned char)freq % NUM_FREQUENCIAS];
+    if (p->n == p->capacidade)
+    {
+        size_t capacidade = p->capacidade ? p->capacidade * 2 : 8;
+        int *nx = (int *)realocarMemoria(p->x, capacidade * sizeof(int));
+        if (nx)
+        {
+            p->x = nx;
+        }
+        int *ny = nx ? (int *)realocarMemoria(p->y, capacidade * sizeof(int)) : NULL;
+        if (!ny)
+        {
+            return false;
+        }
+        p->y = ny;
+        p->capacidade = capacidade;
+    }
+
+    // Uma inserção falhada não deixa nada: nem a célula na grelha nem contagens de pares
+    Antena *nova = criarAntena(freq, x, y);
+    if (nova == NULL || !definirCelula(v->grelhaAntenas, x, y, freq))
+    {
+        libertarMemoria(nova);
+        return false;
+    }
+    if (!paresAntenaVigia(v, freq, x, y, +1))
+    {
+        definirCelula(v->grelhaAntenas, x, y, '.');
+        libertarMemoria(nova);
+        return false;
+    }
+
+    v->antenas = inserirAntena(v->antenas, nova);
+    p->x[p->n] = x;
+    p->y[p->n] = y;
+    p->n++;
+    return true;
+}
+
+static void removerAntenaVigia(VigiaMapa *v, char freq, int x, int y)
+{
+    PosicoesFrequencia *p = &v->porFrequencia[(unsigned char)freq % NUM_FREQUENCIAS];
+    bool removida;
+
+    // Sai primeiro das posições da frequência, para não formar par consigo própria
+    for (size_t i = 0; i < p->n; i++)
+    {
+        if (p->x[i] == x && p->y[i] == y)
+        {
+            p->n--;
+            p->x[i] = p->x[p->n];
+            p->y[i] = p->y[p->n];
+            break;
+        }
+    }
+
+    paresAntenaVigia(v, freq, x, y, -1);
+    definirCelula(v->grelhaAntenas, x, y, '.');
+    v->antenas = removerAntena(v->antenas, x, y, &removida);
+}
+
+// Compara a linha x da grelha de antenas com o novo texto e aplica as remoções e depois as inserções
+static bool aplicarLinhaVigia(VigiaMapa *v, int x, const char *texto, int n)
+{
+    int i = posicaoLinha(v->grelhaAntenas, x);
+    if (i < v->grelhaAntenas->numLinhas && v->grelhaAntenas->linhas[i].x == x)
+    {
+        // A linha da grelha muda com cada remoção, por isso é percorrida de trás para a frente
+        for (int j = v->grelhaAntenas->linhas[i].n - 1; j >= 0; j--)
+        {
+            LinhaGrelha *l = &v->grelhaAntenas->linhas[i];
+            int y = l->colunas[j];
+            if (y >= n || texto[y] != l->valores[j])
+            {
+                removerAntenaVigia(v, l->valores[j], x, y);
+            }
+            if (i >= v->grelhaAntenas->numLinhas || v->grelhaAntenas->linhas[i].x != x)
+            {
+                break; // A linha ficou vazia e saiu da grelha
+            }
+        }
+    }
+
+    for (int y = 0; y < n; y++)
+    {
+        char c = texto[y];
+        if (((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) && obterCelula(v->grelhaAntenas, x, y) != c)
+        {
+            if (!inserirAntenaVigia(v, c, x, y))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Volta a preencher o mapa de efeitos a partir das contagens, quando os limites da matriz mudam
+static bool refazerEfeitosVigia(VigiaMapa *v, LimitesMapa limites)
+{
+    GrelhaEsparsa *efeitos = criarGrelha(limites);
+    if (efeitos == NULL)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < v->contagens.capacidade; i++)
+    {
+        if (!v->contagens.ocupado[i])
+            continue;
+
+        uint64_t chave = v->contagens.chaves[i];
+        int x = (int)((uint32_t)(chave >> 32) ^ 0x80000000u);
+        int y = (int)((uint32_t)chave ^ 0x80000000u);
+        if (dentroGrelha(efeitos, x, y) && !definirCelula(efeitos, x, y, '#'))
+        {
+            libertarGrelha(efeitos);
+            return false;
+        }
+    }
+
+    libertarGrelha(v->efeitos);
+    v->efeitos = efeitos;
+    return true;
+}
+
+int atualizarVigia(VigiaMapa *v)
+{
+    size_t tamanho;
+    char *texto = lerFicheiro(v->nomeFicheiro, &tamanho);
+    if (texto == NULL)
+    {
+        return -1;
+    }
+
+    // Uma linha por '\n', mais a última se não terminar em '\n' (como em carregarAntenasMapa)
+    int linhas = 0;
+    for (size_t i = 0; i < tamanho; i++)
+    {
+        linhas += (texto[i] == '\n');
+    }
+    if (tamanho > 0 && texto[tamanho - 1] != '\n')
+    {
+        linhas++;
+    }
+
+    uint64_t *dispersoes = (uint64_t *)reservarMemoria(((size_t)linhas + 1) * sizeof(uint64_t));
+    if (dispersoes == NULL)
+    {
+        libertarMemoria(texto);
+        return -1;
+    }
+
+    // Durante a atualização a grelha de antenas aceita qualquer posição: os limites só se sabem no fim
+    LimitesMapa semLimites = { INT32_MAX, INT32_MAX };
+    LimitesMapa limites = { linhas, 0 };
+    int alteradas = 0;
+    v->grelhaAntenas->limites = semLimites;
+    bool ok = true;
+    char *linha = texto;
+    for (int x = 0; x < linhas && ok; x++)
+    {
+        char *fim = strchr(linha, '\n');
+        if (fim == NULL)
+        {
+            fim = texto + tamanho;
+        }
+
+        int n = (int)(fim - linha), colunas = 0;
+        for (int k = 0; k < n; k++)
+        {
+            colunas += (linha[k] != '\r');
+        }
+        if (n > 0 && linha[n - 1] == '\r')
+        {
+            n--;
+        }
+        if (colunas > limites.colunas)
+        {
+            limites.colunas = colunas;
+        }
+
+        // Só as linhas novas ou com outra dispersão voltam a ser lidas
+        dispersoes[x] = dispersarLinha(linha, (size_t)n);
+        if (x >= v->numLinhas || dispersoes[x] != v->dispersoes[x])
+        {
+            ok = aplicarLinhaVigia(v, x, linha, n);
+            alteradas++;
+        }
+        linha = fim + 1;
+    }
+
+    // Linhas que desapareceram no fim do ficheiro. As antenas a retirar são procuradas na grelha e não só
+    // até numLinhas: depois de uma atualização falhada numLinhas é 0 mas as linhas antigas continuam lá
+    GrelhaEsparsa *g = v->grelhaAntenas;
+    int fimAnterior = v->numLinhas;
+    if (g->numLinhas > 0 && g->linhas[g->numLinhas - 1].x >= fimAnterior)
+    {
+        fimAnterior = g->linhas[g->numLinhas - 1].x + 1;
+    }
+    while (ok && g->numLinhas > 0 && g->linhas[g->numLinhas - 1].x >= linhas)
+    {
+        ok = aplicarLinhaVigia(v, g->linhas[g->numLinhas - 1].x, "", 0);
+    }
+    if (ok && fimAnterior > linhas)
+    {
+        alteradas += fimAnterior - linhas;
+    }
+    libertarMemoria(texto);
+
+    if (!ok)
+    {
+        // As antenas ficaram entre a versão antiga e a nova, mas cada uma com os seus pares contados:
+        // na próxima atualização todas as linhas são relidas e comparadas com a grelha
+        libertarMemoria(dispersoes);
+        libertarMemoria(v->dispersoes);
+        v->dispersoes = NULL;
+        v->numLinhas = 0;
+        v->grelhaAntenas->limites = v->limites;
+        return -1;
+    }
+
+    libertarMemoria(v->dispersoes);
+    v->dispersoes = dispersoes;
+    v->numLinhas = linhas;
+
+    v->grelhaAntenas->limites = limites;
+    // Os limites só mudam com o mapa de efeitos refeito: se faltar memória, a próxima atualização tenta de novo
+    if (limites.linhas != v->limites.linhas || limites.colunas != v->limites.colunas)
+    {
+        if (!refazerEfeitosVigia(v, limites))
+        {
+            return -1;
+        }
+        v->limites = limites;
+    }
+    return alteradas;
+}
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+VigiaMapa *criarVigia(char *nomeFicheiro)
+{
+    VigiaMapa *v = (VigiaMapa *)reservarMemoriaZerada(1, sizeof(VigiaMapa));
+    if (v == NULL)
+    {
+        return NULL;
+    }
+
+    LimitesMapa semLimites = { INT32_MAX, INT32_MAX };
+    size_t comprimento = strlen(nomeFicheiro);
+    v->descritor = -1;
+    v->nomeFicheiro = (char *)reservarMemoria(comprimento + 1);
+    v->grelhaAntenas = criarGrelha(semLimites);
+    v->efeitos = criarGrelha(semLimites);
+    if (!v->nomeFicheiro || !v->grelhaAntenas || !v->efeitos || !iniciarContagens(&v->contagens, 0))
+    {
+        libertarVigia(v);
+        return NULL;
+    }
+    memcpy(v->nomeFicheiro, nomeFicheiro, comprimento + 1);
+
+    // A primeira atualização lê todas as linhas
+    v->limites = semLimites;
+    if (atualizarVigia(v) < 0)
+    {
+        libertarVigia(v);
+        return NULL;
+    }
+
+#ifdef __linux__
+    // Vigia a pasta e não o ficheiro: os editores que gravam para um ficheiro novo e o renomeiam
+    // substituem o inode, e a vigia de um ficheiro deixaria de receber eventos
+    char *barra = strrchr(v->nomeFicheiro, '/');
+    v->descritor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (v->descritor >= 0)
+    {
+        if (barra != NULL)
+        {
+            *barra = '\0';
+        }
+        v->vigia = inotify_add_watch(v->descritor, barra ? (barra == v->nomeFicheiro ? "/" : v->nomeFicheiro) : ".",
+                                     IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+        if (barra != NULL)
+        {
+            *barra = '/';
+        }
+        if (v->vigia < 0)
+        {
+            close(v->descritor);
+            v->descritor = -1;
+        }
+    }
+#endif
+    return v;
+}
+
+bool esperarAlteracaoMapa(VigiaMapa *v, int tempoLimite)
+{
+#ifdef __linux__
+    if (v->descritor < 0)
+    {
+        return false;
+    }
+
+    const char *barra = strrchr(v->nomeFicheiro, '/');
+    const char *nome = barra ? barra + 1 : v->nomeFicheiro;
+    char eventos[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pfd = { v->descritor, POLLIN, 0 };
+
+    // Espera pelo primeiro evento do ficheiro e depois esvazia a fila, juntando as escritas seguidas
+    bool alterado = false;
+    while (!alterado)
+    {
+        int r = poll(&pfd, 1, tempoLimite);
+        if (r <= 0)
+        {
+            return false; // Tempo esgotado ou erro
+        }
+
+        ssize_t lidos;
+        while ((lidos = read(v->descritor, eventos, sizeof(eventos))) > 0)
+        {
+            for (char *p = eventos; p < eventos + lidos;)
+            {
+                struct inotify_event *e = (struct inotify_event *)p;
+                if (e->len > 0 && strcmp(e->name, nome) == 0)
+                {
+                    alterado = true;
+                }
+                p += sizeof(struct inotify_event) + e->len;
+            }
+        }
+    }
+    return true;
+#else
+    (void)v;
+    (void)tempoLimite;
+    return false; // Sem inotify: quem chama pode chamar atualizarVigia periodicamente
+#endif
+}
+
+bool vigiarMapa(VigiaMapa *v, bool (*aoAlterar)(VigiaMapa *v, int linhasAlteradas, void *dados), void *dados)
+{
+    while (esperarAlteracaoMapa(v, -1))
+    {
+        int alteradas = atualizarVigia(v);
+        if (aoAlterar != NULL && !aoAlterar(v, alteradas, dados))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void libertarVigia(VigiaMapa *v)
+{
+    if (v == NULL)
+    {
+        return;
+    }
+
+#ifdef __linux__
+    if (v->descritor >= 0)
+    {
+        close(v->descritor);
+    }
+#endif
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        libertarMemoria(v->porFrequencia[f].x);
+        libertarMemoria(v->porFrequencia[f].y);
+    }
+    libertarAntenas(v->antenas);
+    libertarGrelha(v->grelhaAntenas);
+    libertarGrelha(v->efeitos);
+    libertarContagens(&v->contagens);
+    libertarMemoria(v->dispersoes);
+    libertarMemoria(v->nomeFicheiro);
+    libertarMemoria(v);
+}
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <time.h>
+
+#define TAMANHO_REGISTO_DIARIO 16
+
+// Garante que o que foi escrito em f chegou ao disco
+static bool sincronizarFicheiro(FILE *f)
+{
+    if (fflush(f) != 0)
+    {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Torna duradoura uma mudança de nome, sincronizando a pasta do ficheiro
+static void sincronizarPasta(const char *nomeFicheiro)
+{
+#ifndef _WIN32
+    char pasta[4096];
+    const char *barra = strrchr(nomeFicheiro, '/');
+    size_t n = barra ? (size_t)(barra - nomeFicheiro) : 0;
+    if (n >= sizeof(pasta))
+    {
+        return;
+    }
+    memcpy(pasta, nomeFicheiro, n);
+    strcpy(pasta + n, (barra == NULL) ? "." : (n == 0 ? "/" : ""));
+
+    int fd = open(pasta, O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)nomeFicheiro;
+#endif
+}
+
+static double segundosAgora(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t somaRegisto(const unsigned char *r)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 12; i++)
+    {
+        h = (h ^ r[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void escreverInteiroLE(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t lerInteiroLE(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Aplica uma operação à lista: inserir substitui a frequência se a posição já estiver ocupada.
+// nova, se não for NULL, é o nodo já reservado para a inserção (se não for preciso é libertado)
+static bool aplicarOperacao(Antena **lista, char operacao, char freq, int x, int y, Antena *nova)
+{
+    if (operacao == 'R')
+    {
+        bool removida;
+        *lista = removerAntena(*lista, x, y, &removida);
+        libertarMemoria(nova);
+        return true;
+    }
+
+    Antena *existente = procurarAntena(*lista, x, y);
+    if (existente != NULL)
+    {
+        existente->freq = freq;
+        libertarMemoria(nova);
+        return true;
+    }
+
+    if (nova == NULL && (nova = criarAntena(freq, x, y)) == NULL)
+    {
+        return false;
+    }
+    *lista = inserirAntena(*lista, nova);
+    return true;
+}
+
+// Cria (ou esvazia) o ficheiro do diário, só com o cabeçalho
+static FILE *novoDiario(const char *nomeDiario)
+{
+    FILE *f = fopen(nomeDiario, "wb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    if (fwrite("DIAR", 1, 4, f) != 4 || !sincronizarFicheiro(f))
+    {
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+// Repete as operações do diário sobre a lista. Um registo incompleto ou com soma errada no fim
+// (escrita interrompida) termina a leitura; os registos válidos ficam em *validos
+static bool repetirDiario(const char *nomeDiario, Antena **lista, size_t *validos, bool *cortado)
+{
+    *validos = 0;
+    *cortado = false;
+
+    FILE *f = fopen(nomeDiario, "rb");
+    if (f == NULL)
+    {
+        return true; // Ainda não há diário
+    }
+
+    char cabecalho[4];
+    if (fread(cabecalho, 1, 4, f) != 4 || memcmp(cabecalho, "DIAR", 4) != 0)
+    {
+        *cortado = true;
+        fclose(f);
+        return true;
+    }
+
+    unsigned char r[TAMANHO_REGISTO_DIARIO];
+    size_t lidos;
+    bool ok = true;
+    while (ok && (lidos = fread(r, 1, sizeof(r), f)) > 0)
+    {
+        if (lidos != sizeof(r) || lerInteiroLE(r + 12) != somaRegisto(r) || (r[0] != 'I' && r[0] != 'R'))
+        {
+            *cortado = true;
+            break;
+        }
+        ok = aplicarOperacao(lista, (char)r[0], (char)r[1], (int)lerInteiroLE(r + 4), (int)lerInteiroLE(r + 8), NULL);
+        (*validos)++;
+    }
+    fclose(f);
+    return ok;
+}
+
+// Grava o instantâneo num ficheiro temporário e troca-o pelo anterior de uma só vez
+static bool gravarInstantaneo(const char *nomeInstantaneo, Antena *lista)
+{
+    size_t n = strlen(nomeInstantaneo);
+    char *temporario = (char *)reservarMemoria(n + 5);
+    if (temporario == NULL)
+    {
+        return false;
+    }
+    memcpy(temporario, nomeInstantaneo, n);
+    memcpy(temporario + n, ".tmp", 5);
+
+    FILE *f = fopen(temporario, "wb");
+    bool ok = (f != NULL);
+    if (ok)
+    {
+        escreverAntenasBinario(f, lista);
+        ok = !ferror(f) && sincronizarFicheiro(f);
+        ok = (fclose(f) == 0) && ok;
+    }
+#ifdef _WIN32
+    if (ok)
+    {
+        remove(nomeInstantaneo); // No Windows rename não substitui um ficheiro existente
+    }
+#endif
+    ok = ok && rename(temporario, nomeInstantaneo) == 0;
+    if (ok)
+    {
+        sincronizarPasta(nomeInstantaneo);
+    }
+    else
+    {
+        remove(temporario);
+    }
+    libertarMemoria(temporario);
+    return ok;
+}
+
+static char *copiarTexto(const char *texto)
+{
+    size_t n = strlen(texto) + 1;
+    char *copia = (char *)reservarMemoria(n);
+    if (copia != NULL)
+    {
+        memcpy(copia, texto, n);
+    }
+    return copia;
+}
+
+DiarioAntenas *abrirDiario(char *nomeInstantaneo, char *nomeDiario, Antena **lista)
+{
+    DiarioAntenas *d = (DiarioAntenas *)reservarMemoriaZerada(1, sizeof(DiarioAntenas));
+    if (d == NULL)
+    {
+        return NULL;
+    }
+
+    d->nomeInstantaneo = copiarTexto(nomeInstantaneo);
+    d->nomeDiario = copiarTexto(nomeDiario);
+    d->maxPendentes = 1;
+    d->intervaloSincronizacao = 0;
+    d->limiteCompactacao = 1 << 16;
+    if (!d->nomeInstantaneo || !d->nomeDiario)
+    {
+        fecharDiario(d, NULL);
+        return NULL;
+    }
+
+    // Recuperação: instantâneo e depois as operações registadas desde então.
+    // Se a última compactação foi interrompida antes de esvaziar o diário, repetir operações que o
+    // instantâneo já inclui dá o mesmo resultado, porque cada uma só fixa o estado de uma posição.
+    if (!lerAntenasBinario(nomeInstantaneo, lista, true))
+    {
+        fecharDiario(d, NULL);
+        return NULL;
+    }
+
+    bool cortado;
+    if (!repetirDiario(nomeDiario, lista, &d->registos, &cortado))
+    {
+        libertarAntenas(*lista);
+        *lista = NULL;
+        fecharDiario(d, NULL);
+        return NULL;
+    }
+
+    // Com um fim cortado, compacta já: o diário recomeça sem os bytes inválidos
+    if (cortado)
+    {
+        d->ficheiro = NULL;
+        if (!compactarDiario(d, *lista))
+        {
+            libertarAntenas(*lista);
+            *lista = NULL;
+            fecharDiario(d, NULL);
+            return NULL;
+        }
+        return d;
+    }
+
+    d->ficheiro = fopen(nomeDiario, "ab");
+    if (d->ficheiro != NULL && d->registos == 0 && ftell(d->ficheiro) == 0)
+    {
+        fclose(d->ficheiro);
+        d->ficheiro = novoDiario(nomeDiario);
+    }
+    if (d->ficheiro == NULL)
+    {
+        libertarAntenas(*lista);
+        *lista = NULL;
+        fecharDiario(d, NULL);
+        return NULL;
+    }
+    return d;
+}
+
+bool confirmarDiario(DiarioAntenas *d)
+{
+    if (d->numPendentes == 0)
+    {
+        return true;
+    }
+
+    // Todas as operações pendentes seguem numa única escrita e numa única sincronização
+    size_t bytes = d->numPendentes * TAMANHO_REGISTO_DIARIO;
+    if (fwrite(d->pendentes, 1, bytes, d->ficheiro) != bytes || !sincronizarFicheiro(d->ficheiro))
+    {
+        return false;
+    }
+
+    d->registos += d->numPendentes;
+    d->numPendentes = 0;
+    return true;
+}
+
+bool confirmarDiarioVencido(DiarioAntenas *d)
+{
+    // O prazo só é visto nas operações seguintes: quem deixa de editar chama isto no seu ciclo
+    if (d->numPendentes == 0 || d->intervaloSincronizacao == 0 ||
+        segundosAgora() - d->primeiraPendente < d->intervaloSincronizacao / 1000.0)
+    {
+        return true;
+    }
+    return confirmarDiario(d);
+}
+
+static bool registarOperacao(DiarioAntenas *d, Antena **lista, char operacao, char freq, int x, int y)
+{
+    if (d->numPendentes == d->capacidadePendentes)
+    {
+        size_t capacidade = d->capacidadePendentes ? d->capacidadePendentes * 2 : 64;
+        unsigned char *pendentes = (unsigned char *)realocarMemoria(d->pendentes, capacidade * TAMANHO_REGISTO_DIARIO);
+        if (pendentes == NULL)
+        {
+            return false;
+        }
+        d->pendentes = pendentes;
+        d->capacidadePendentes = capacidade;
+    }
+
+    unsigned char *r = d->pendentes + d->numPendentes * TAMANHO_REGISTO_DIARIO;
+    r[0] = (unsigned char)operacao;
+    r[1] = (unsigned char)freq;
+    r[2] = r[3] = 0;
+    escreverInteiroLE(r + 4, (uint32_t)x);
+    escreverInteiroLE(r + 8, (uint32_t)y);
+    escreverInteiroLE(r + 12, somaRegisto(r));
+
+    // Confirmação em grupo: espera por maxPendentes operações ou pelo fim do intervalo. Até lá a operação
+    // fica pendente, mas já visível na lista
+    bool confirmar = d->numPendentes + 1 >= d->maxPendentes ||
+                     (d->numPendentes > 0 && d->intervaloSincronizacao > 0 &&
+                      segundosAgora() - d->primeiraPendente >= d->intervaloSincronizacao / 1000.0);
+    if (!confirmar)
+    {
+        if (!aplicarOperacao(lista, operacao, freq, x, y, NULL))
+        {
+            return false;
+        }
+        if (d->numPendentes++ == 0)
+        {
+            d->primeiraPendente = segundosAgora();
+        }
+        return true;
+    }
+
+    // A operação que fecha o grupo só chega à lista depois de estar no disco. O nodo de uma inserção é
+    // reservado antes da escrita, para que a aplicação já não possa falhar
+    Antena *nova = NULL;
+    if (operacao == 'I' && procurarAntena(*lista, x, y) == NULL && (nova = criarAntena(freq, x, y)) == NULL)
+    {
+        return false;
+    }
+    d->numPendentes++;
+    if (!confirmarDiario(d))
+    {
+        d->numPendentes--;
+        libertarMemoria(nova);
+        // As pendentes anteriores já estão na lista e uma escrita parcial pode ter deixado lixo no fim do
+        // diário: um instantâneo da lista volta a pôr o disco de acordo com ela
+        compactarDiario(d, *lista);
+        return false;
+    }
+    aplicarOperacao(lista, operacao, freq, x, y, nova);
+
+    if (d->registos >= d->limiteCompactacao)
+    {
+        return compactarDiario(d, *lista);
+    }
+    return true;
+}
+
+bool diarioInserir(DiarioAntenas *d, Antena **lista, char freq, int x, int y)
+{
+    return registarOperacao(d, lista, 'I', freq, x, y);
+}
+
+bool diarioRemover(DiarioAntenas *d, Antena **lista, int x, int y)
+{
+    return registarOperacao(d, lista, 'R', 0, x, y);
+}
+
+bool compactarDiario(DiarioAntenas *d, Antena *lista)
+{
+    // A lista já inclui as operações pendentes, que passam a estar no instantâneo
+    if (!gravarInstantaneo(d->nomeInstantaneo, lista))
+    {
+        return false;
+    }
+
+    if (d->ficheiro != NULL)
+    {
+        fclose(d->ficheiro);
+    }
+    d->ficheiro = novoDiario(d->nomeDiario);
+    d->numPendentes = 0;
+    d->registos = 0;
+    return d->ficheiro != NULL;
+}
+
+bool fecharDiario(DiarioAntenas *d, Antena *lista)
+{
+    if (d == NULL)
+    {
+        return false;
+    }
+
+    bool ok = true;
+    if (d->ficheiro != NULL)
+    {
+        ok = confirmarDiario(d);
+        if (ok && lista != NULL && d->registos >= d->limiteCompactacao / 2)
+        {
+            ok = compactarDiario(d, lista);
+        }
+        if (d->ficheiro != NULL)
+        {
+            ok = (fclose(d->ficheiro) == 0) && ok;
+        }
+    }
+
+    libertarMemoria(d->pendentes);
+    libertarMemoria(d->nomeInstantaneo);
+    libertarMemoria(d->nomeDiario);
+    libertarMemoria(d);
+    return ok;
+}
+
+// Transforma as contagens por posição (guardadas em (x+1, y+1)) nas somas acumuladas, no lugar
+static void acumularSomas(uint32_t *s, LimitesMapa limites)
+{
+    size_t largura = (size_t)limites.colunas + 1;
+    for (int i = 1; i <= limites.linhas; i++)
+    {
+        uint32_t linha = 0;
+        uint32_t *atual = s + (size_t)i * largura;
+        const uint32_t *acima = atual - largura;
+        for (size_t j = 1; j < largura; j++)
+        {
+            linha += atual[j];
+            atual[j] = acima[j] + linha;
+        }
+    }
+}
+
+static uint32_t *criarSomas(LimitesMapa limites)
+{
+    return (uint32_t *)reservarMemoriaZerada(((size_t)limites.linhas + 1) * ((size_t)limites.colunas + 1), sizeof(uint32_t));
+}
+
+TabelaSomas *criarTabelaSomas(Antena *h, RedeAntenas *efeitos, LimitesMapa limites)
+{
+    if (limites.linhas <= 0 || limites.colunas <= 0)
+    {
+        return NULL;
+    }
+
+    TabelaSomas *t = (TabelaSomas *)reservarMemoriaZerada(1, sizeof(TabelaSomas));
+    if (!t)
+    {
+        return NULL;
+    }
+    t->limites = limites;
+    size_t largura = (size_t)limites.colunas + 1;
+
+    // Uma passagem por cada lista conta as posições; só as frequências presentes têm tabela
+    for (Antena *aux = h; aux != NULL; aux = aux->prox)
+    {
+        if (aux->x < 0 || aux->x >= limites.linhas || aux->y < 0 || aux->y >= limites.colunas)
+            continue;
+
+        int f = (unsigned char)aux->freq % NUM_FREQUENCIAS;
+        if (t->somas[f] == NULL && (t->somas[f] = criarSomas(limites)) == NULL)
+        {
+            libertarTabelaSomas(t);
+            return NULL;
+        }
+        t->somas[f][(size_t)(aux->x + 1) * largura + (size_t)(aux->y + 1)]++;
+    }
+
+    t->somasEfeitos = criarSomas(limites);
+    if (!t->somasEfeitos)
+    {
+        libertarTabelaSomas(t);
+        return NULL;
+    }
+    // A lista de efeitos pode repetir posições: conta-se cada posição uma vez
+    for (RedeAntenas *aux = efeitos; aux != NULL; aux = aux->prox)
+    {
+        if (aux->x >= 0 && aux->x < limites.linhas && aux->y >= 0 && aux->y < limites.colunas)
+        {
+            t->somasEfeitos[(size_t)(aux->x + 1) * largura + (size_t)(aux->y + 1)] = 1;
+        }
+    }
+
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        if (t->somas[f] != NULL)
+        {
+            acumularSomas(t->somas[f], limites);
+        }
+    }
+    acumularSomas(t->somasEfeitos, limites);
+    return t;
+}
+
+// Limita o retângulo (inclusivo) à matriz; devolve false se não sobrar nenhuma posição
+static bool recortarRetangulo(LimitesMapa limites, int *x0, int *y0, int *x1, int *y1)
+{
+    *x0 = (*x0 < 0) ? 0 : *x0;
+    *y0 = (*y0 < 0) ? 0 : *y0;
+    *x1 = (*x1 >= limites.linhas) ? limites.linhas - 1 : *x1;
+    *y1 = (*y1 >= limites.colunas) ? limites.colunas - 1 : *y1;
+    return *x0 <= *x1 && *y0 <= *y1;
+}
+
+// Quatro leituras da tabela, seja qual for o tamanho do retângulo; os pendentes somam-se à parte
+static uint32_t contarRetangulo(const TabelaSomas *t, const uint32_t *s, int freq, int x0, int y0, int x1, int y1)
+{
+    if (!recortarRetangulo(t->limites, &x0, &y0, &x1, &y1))
+    {
+        return 0;
+    }
+
+    uint32_t total = 0;
+    if (s != NULL)
+    {
+        size_t largura = (size_t)t->limites.colunas + 1;
+        total = s[(size_t)(x1 + 1) * largura + (size_t)(y1 + 1)] - s[(size_t)x0 * largura + (size_t)(y1 + 1)] -
+                s[(size_t)(x1 + 1) * largura + (size_t)y0] + s[(size_t)x0 * largura + (size_t)y0];
+    }
+
+    for (int i = 0; i < t->numPendentes; i++)
+    {
+        const AlteracaoSomas *a = &t->pendentes[i];
+        if (a->freq == freq && a->x >= x0 && a->x <= x1 && a->y >= y0 && a->y <= y1)
+        {
+            total += (uint32_t)a->delta;
+        }
+    }
+    return total;
+}
+
+uint32_t contarAntenasRetangulo(const TabelaSomas *t, char freq, int x0, int y0, int x1, int y1)
+{
+    if (t == NULL)
+    {
+        return 0;
+    }
+    int f = (unsigned char)freq % NUM_FREQUENCIAS;
+    return contarRetangulo(t, t->somas[f], f, x0, y0, x1, y1);
+}
+
+uint32_t contarEfeitosRetangulo(const TabelaSomas *t, int x0, int y0, int x1, int y1)
+{
+    if (t == NULL)
+    {
+        return 0;
+    }
+    return contarRetangulo(t, t->somasEfeitos, -1, x0, y0, x1, y1);
+}
+
+// Aplica de uma vez as alterações pendentes: cada tabela afetada é refeita numa passagem, seja qual for o número de alterações
+bool aplicarAlteracoesSomas(TabelaSomas *t)
+{
+    if (t == NULL || t->numPendentes == 0)
+    {
+        return t != NULL;
+    }
+
+    size_t largura = (size_t)t->limites.colunas + 1;
+    size_t tamanho = ((size_t)t->limites.linhas + 1) * largura;
+    uint32_t *diferencas = criarSomas(t->limites);
+    if (!diferencas)
+    {
+        return false; // As alterações continuam pendentes e as consultas continuam certas
+    }
+
+    bool aplicada[NUM_FREQUENCIAS + 1] = { false };
+    for (int i = 0; i < t->numPendentes; i++)
+    {
+        int f = t->pendentes[i].freq;
+        if (aplicada[f + 1])
+            continue;
+
+        uint32_t **destino = (f < 0) ? &t->somasEfeitos : &t->somas[f];
+        if (*destino == NULL && (*destino = criarSomas(t->limites)) == NULL)
+        {
+            libertarMemoria(diferencas);
+            return false;
+        }
+
+        // As alterações desta tabela acumulam-se como uma tabela de somas e juntam-se à existente
+        memset(diferencas, 0, tamanho * sizeof(uint32_t));
+        for (int k = i; k < t->numPendentes; k++)
+        {
+            const AlteracaoSomas *a = &t->pendentes[k];
+            if (a->freq == f)
+            {
+                diferencas[(size_t)(a->x + 1) * largura + (size_t)(a->y + 1)] += (uint32_t)a->delta;
+            }
+        }
+        acumularSomas(diferencas, t->limites);
+        for (size_t k = 0; k < tamanho; k++)
+        {
+            (*destino)[k] += diferencas[k];
+        }
+        aplicada[f + 1] = true;
+    }
+
+    libertarMemoria(diferencas);
+    t->numPendentes = 0;
+    return true;
+}
+
+static bool registarAlteracaoSomas(TabelaSomas *t, int freq, int x, int y, int delta)
+{
+    if (t == NULL)
+    {
+        return false;
+    }
+    if (x < 0 || x >= t->limites.linhas || y < 0 || y >= t->limites.colunas || delta == 0)
+    {
+        return true; // Fora da matriz não altera nenhuma contagem
+    }
+
+    if (t->numPendentes == MAX_ALTERACOES_SOMAS && !aplicarAlteracoesSomas(t))
+    {
+        return false;
+    }
+    t->pendentes[t->numPendentes].freq = freq;
+    t->pendentes[t->numPendentes].x = x;
+    t->pendentes[t->numPendentes].y = y;
+    t->pendentes[t->numPendentes].delta = delta;
+    t->numPendentes++;
+    return true;
+}
+
+// delta é +1 para uma antena inserida e -1 para uma removida
+bool registarAntenaSomas(TabelaSomas *t, char freq, int x, int y, int delta)
+{
+    return registarAlteracaoSomas(t, (unsigned char)freq % NUM_FREQUENCIAS, x, y, delta);
+}
+
+// delta é +1 quando a posição passa a ter efeito nefasto e -1 quando deixa de ter
+bool registarEfeitoSomas(TabelaSomas *t, int x, int y, int delta)
+{
+    return registarAlteracaoSomas(t, -1, x, y, delta);
+}
+
+void libertarTabelaSomas(TabelaSomas *t)
+{
+    if (t == NULL)
+    {
+        return;
+    }
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        libertarMemoria(t->somas[f]);
+    }
+    libertarMemoria(t->somasEfeitos);
+    libertarMemoria(t);
+}
+
 /*
 
 bool posicaoNefasta(Antena *lista, char freq, int x, int y)
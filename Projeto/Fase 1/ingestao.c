@@ -0,0 +1,562 @@
+/***
+ * @file ingestao.c
+ * @brief Leitura do mapa em três fases ligadas por anéis sem trincos (um produtor, um consumidor):
+ *        uma thread lê blocos do ficheiro, outra interpreta-os em lotes de antenas e quem chama
+ *        agrupa as antenas por frequência e calcula os pares à medida que os lotes chegam
+ * @author David Costa
+ */
+#define _POSIX_C_SOURCE 200809L // nanosleep em esperarVez com -std=c11
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "struct.h"
+#include "ingestao.h"
+
+#define TAMANHO_BLOCO_LEITURA (1 << 20)   // Bytes lidos de cada vez
+#define NUM_BLOCOS_LEITURA 4
+#define ANTENAS_POR_LOTE 4096
+#define NUM_LOTES 8
+
+// Anel de ponteiros com um só produtor e um só consumidor; a capacidade é uma potência de 2
+typedef struct AnelSPSC
+{
+    void **itens;
+    size_t mascara;
+    alignas(64) _Atomic size_t cabeca;  // Só escrita pelo produtor
+    alignas(64) _Atomic size_t cauda;   // Só escrita pelo consumidor
+} AnelSPSC;
+
+typedef struct BlocoLeitura
+{
+    char *dados;
+    ssize_t tamanho;            // 0 no fim do ficheiro, negativo se a leitura falhou
+} BlocoLeitura;
+
+typedef struct LoteAntenas
+{
+    char freq[ANTENAS_POR_LOTE];
+    int x[ANTENAS_POR_LOTE], y[ANTENAS_POR_LOTE];
+    int n;
+    bool ultimo, erro;
+    LimitesMapa limites;        // Só válidos no último lote
+    int largura;                // Colunas da primeira linha (0 enquanto não acabar)
+    size_t bytesLinha;          // Bytes da primeira linha, com o fim de linha
+} LoteAntenas;
+
+typedef struct EstadoIngestao
+{
+    int fd;
+    atomic_bool cancelar;       // O consumidor desistiu: a leitura termina mais cedo
+    BlocoLeitura blocos[NUM_BLOCOS_LEITURA];
+    LoteAntenas *lotes;
+    AnelSPSC blocosCheios, blocosLivres;
+    AnelSPSC lotesCheios, lotesLivres;
+} EstadoIngestao;
+
+// Antenas já recebidas de uma frequência
+typedef struct GrupoIngestao
+{
+    int *x, *y;
+    size_t n, capacidade;
+} GrupoIngestao;
+
+// Posições com efeito. Os limites só se conhecem no fim, mas a primeira linha e o tamanho do ficheiro
+// permitem prevê-los: até lá as posições vão para um conjunto por endereçamento aberto e a partir daí
+// para um mapa de bits dos limites previstos, deixando cair as de fora
+typedef struct ConjuntoEfeitos
+{
+    uint64_t *chaves;
+    size_t capacidade, quantidade;
+    uint64_t *mapa;             // NULL enquanto não há previsão
+    LimitesMapa previstos;
+} ConjuntoEfeitos;
+
+#define CHAVE_VAZIA UINT64_MAX
+
+static bool iniciarAnel(AnelSPSC *a, size_t capacidade)
+{
+    a->itens = (void **)reservarMemoria(capacidade * sizeof(void *));
+    a->mascara = capacidade - 1;
+    atomic_init(&a->cabeca, 0);
+    atomic_init(&a->cauda, 0);
+    return a->itens != NULL;
+}
+
+// Cada anel tem tantas posições como os objetos que circulam nele, por isso nunca enche
+static void colocarAnel(AnelSPSC *a, void *item)
+{
+    size_t cabeca = atomic_load_explicit(&a->cabeca, memory_order_relaxed);
+    a->itens[cabeca & a->mascara] = item;
+    atomic_store_explicit(&a->cabeca, cabeca + 1, memory_order_release);
+}
+
+// Espera ativa curta; depois dorme um pouco para não gastar um processador à espera do disco
+static void esperarVez(unsigned *tentativas)
+{
+    if (++*tentativas < 64)
+    {
+        sched_yield();
+    }
+    else
+    {
+        struct timespec pausa = { 0, 50000 };
+        nanosleep(&pausa, NULL);
+    }
+}
+
+static void *retirarAnel(AnelSPSC *a)
+{
+    size_t cauda = atomic_load_explicit(&a->cauda, memory_order_relaxed);
+    unsigned tentativas = 0;
+    while (atomic_load_explicit(&a->cabeca, memory_order_acquire) == cauda)
+    {
+        esperarVez(&tentativas);
+    }
+    void *item = a->itens[cauda & a->mascara];
+    atomic_store_explicit(&a->cauda, cauda + 1, memory_order_release);
+    return item;
+}
+
+static void *lerBlocos(void *arg)
+{
+    EstadoIngestao *e = (EstadoIngestao *)arg;
+
+    for (;;)
+    {
+        BlocoLeitura *b = (BlocoLeitura *)retirarAnel(&e->blocosLivres);
+        if (atomic_load_explicit(&e->cancelar, memory_order_relaxed))
+        {
+            b->tamanho = 0;
+        }
+        else
+        {
+            do
+            {
+                b->tamanho = read(e->fd, b->dados, TAMANHO_BLOCO_LEITURA);
+            } while (b->tamanho < 0 && errno == EINTR);
+        }
+
+        colocarAnel(&e->blocosCheios, b);
+        if (b->tamanho <= 0)
+        {
+            return NULL;
+        }
+    }
+}
+
+// Interpreta os blocos como carregarAntenasMapa: só as letras são antenas e '\r' não conta como coluna
+static void *interpretarBlocos(void *arg)
+{
+    EstadoIngestao *e = (EstadoIngestao *)arg;
+    int x = 0, y = 0, colunas = 0, largura = 0;
+    size_t bytesLinha = 0;
+    LoteAntenas *lote = (LoteAntenas *)retirarAnel(&e->lotesLivres);
+    lote->n = 0;
+
+    for (;;)
+    {
+        BlocoLeitura *b = (BlocoLeitura *)retirarAnel(&e->blocosCheios);
+        ssize_t tamanho = b->tamanho;
+
+        for (ssize_t i = 0; i < tamanho; i++)
+        {
+            unsigned char c = (unsigned char)b->dados[i];
+            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))
+            {
+                lote->freq[lote->n] = (char)c;
+                lote->x[lote->n] = x;
+                lote->y[lote->n] = y;
+                if (++lote->n == ANTENAS_POR_LOTE)
+                {
+                    lote->ultimo = false;
+                    lote->largura = largura;
+                    lote->bytesLinha = bytesLinha;
+                    colocarAnel(&e->lotesCheios, lote);
+                    lote = (LoteAntenas *)retirarAnel(&e->lotesLivres);
+                    lote->n = 0;
+                }
+            }
+
+            if (x == 0)
+            {
+                bytesLinha++;
+            }
+            if (c == '\n')
+            {
+                if (x == 0)
+                {
+                    largura = y;
+                }
+                x++;
+                y = 0;
+            }
+            else if (c != '\r')
+            {
+                y++;
+                if (y > colunas)
+                {
+                    colunas = y;
+                }
+            }
+        }
+
+        colocarAnel(&e->blocosLivres, b);
+        if (tamanho <= 0)
+        {
+            lote->ultimo = true;
+            lote->erro = (tamanho < 0);
+            lote->largura = largura;
+            lote->bytesLinha = bytesLinha;
+            lote->limites.linhas = (y > 0) ? x + 1 : x;
+            lote->limites.colunas = colunas;
+            colocarAnel(&e->lotesCheios, lote);
+            return NULL;
+        }
+    }
+}
+
+static inline size_t dispersarChave(uint64_t chave)
+{
+    chave ^= chave >> 33;
+    chave *= 0xff51afd7ed558ccdULL;
+    chave ^= chave >> 33;
+    return (size_t)chave;
+}
+
+static bool acrescentarEfeito(ConjuntoEfeitos *c, int x, int y)
+{
+    if (x < 0 || y < 0)
+    {
+        return true; // Nunca fica dentro da matriz
+    }
+    if (c->mapa != NULL)
+    {
+        if (x < c->previstos.linhas && y < c->previstos.colunas)
+        {
+            size_t p = (size_t)x * (size_t)c->previstos.colunas + (size_t)y;
+            c->mapa[p >> 6] |= (uint64_t)1 << (p & 63);
+        }
+        return true;
+    }
+
+    if ((c->quantidade + 1) * 2 > c->capacidade)
+    {
+        size_t nova = c->capacidade ? c->capacidade * 2 : 1024;
+        uint64_t *chaves = (uint64_t *)reservarMemoria(nova * sizeof(uint64_t));
+        if (chaves == NULL)
+        {
+            return false;
+        }
+        memset(chaves, 0xff, nova * sizeof(uint64_t));
+        for (size_t i = 0; i < c->capacidade; i++)
+        {
+            if (c->chaves[i] == CHAVE_VAZIA)
+                continue;
+            size_t k = dispersarChave(c->chaves[i]) & (nova - 1);
+            while (chaves[k] != CHAVE_VAZIA)
+                k = (k + 1) & (nova - 1);
+            chaves[k] = c->chaves[i];
+        }
+        libertarMemoria(c->chaves);
+        c->chaves = chaves;
+        c->capacidade = nova;
+    }
+
+    uint64_t chave = ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    size_t k = dispersarChave(chave) & (c->capacidade - 1);
+    while (c->chaves[k] != CHAVE_VAZIA)
+    {
+        if (c->chaves[k] == chave)
+            return true;
+        k = (k + 1) & (c->capacidade - 1);
+    }
+    c->chaves[k] = chave;
+    c->quantidade++;
+    return true;
+}
+
+// Com a primeira linha completa, cada linha deve ter bytesLinha bytes: o ficheiro dá o número de linhas.
+// Se a previsão falhar (linhas de tamanhos diferentes), listarEfeitos refaz os pares com os limites reais
+static void preverLimites(ConjuntoEfeitos *c, int largura, size_t bytesLinha, off_t tamanhoFicheiro)
+{
+    if (c->mapa != NULL || largura <= 0 || bytesLinha == 0 || tamanhoFicheiro <= 0)
+    {
+        return;
+    }
+
+    size_t linhas = ((size_t)tamanhoFicheiro + bytesLinha - 1) / bytesLinha;
+    if (linhas > (size_t)INT32_MAX)
+    {
+        return;
+    }
+    size_t celulas = linhas * (size_t)largura;
+    c->mapa = (uint64_t *)reservarMemoriaZerada((celulas + 63) / 64, sizeof(uint64_t));
+    c->previstos.linhas = (int)linhas;
+    c->previstos.colunas = largura; // Sem memória para o mapa continua-se só com o conjunto
+}
+
+// Junta a antena ao seu grupo e calcula logo os efeitos com as antenas da mesma frequência já recebidas
+static bool receberAntena(GrupoIngestao *g, ConjuntoEfeitos *c, int x, int y)
+{
+    for (size_t i = 0; i < g->n; i++)
+    {
+        int dx = x - g->x[i];
+        int dy = y - g->y[i];
+        if (dx == 0 && dy == 0)
+            continue;
+        if (!acrescentarEfeito(c, g->x[i] - dx, g->y[i] - dy) || !acrescentarEfeito(c, x + dx, y + dy))
+            return false;
+    }
+
+    if (g->n == g->capacidade)
+    {
+        size_t nova = g->capacidade ? g->capacidade * 2 : 64;
+        int *nx = (int *)realocarMemoria(g->x, nova * sizeof(int));
+        if (nx == NULL)
+            return false;
+        g->x = nx;
+        int *ny = (int *)realocarMemoria(g->y, nova * sizeof(int));
+        if (ny == NULL)
+            return false;
+        g->y = ny;
+        g->capacidade = nova;
+    }
+    g->x[g->n] = x;
+    g->y[g->n] = y;
+    g->n++;
+    return true;
+}
+
+static inline void marcarPosicao(uint64_t *mapa, LimitesMapa limites, int x, int y)
+{
+    if (x >= 0 && x < limites.linhas && y >= 0 && y < limites.colunas)
+    {
+        size_t p = (size_t)x * (size_t)limites.colunas + (size_t)y;
+        mapa[p >> 6] |= (uint64_t)1 << (p & 63);
+    }
+}
+
+// Com os limites conhecidos, as posições dentro da matriz passam para uma lista ordenada por (x, y).
+// Se a matriz saiu maior do que a previsão, as posições deixadas cair podiam estar dentro dela: os
+// efeitos são então recalculados a partir dos grupos
+static bool listarEfeitos(const ConjuntoEfeitos *c, const GrupoIngestao *grupos, LimitesMapa limites, RedeAntenas **efeitos)
+{
+    *efeitos = NULL;
+    if (limites.linhas <= 0 || limites.colunas <= 0)
+    {
+        return true;
+    }
+
+    size_t celulas = (size_t)limites.linhas * (size_t)limites.colunas;
+    uint64_t *mapa = (uint64_t *)reservarMemoriaZerada((celulas + 63) / 64, sizeof(uint64_t));
+    if (mapa == NULL)
+    {
+        return false;
+    }
+
+    if (c->mapa != NULL && (limites.linhas > c->previstos.linhas || limites.colunas > c->previstos.colunas))
+    {
+        for (int f = 0; f < NUM_FREQUENCIAS; f++)
+        {
+            const GrupoIngestao *g = &grupos[f];
+            for (size_t i = 0; i < g->n; i++)
+            {
+                for (size_t j = i + 1; j < g->n; j++)
+                {
+                    int dx = g->x[j] - g->x[i];
+                    int dy = g->y[j] - g->y[i];
+                    marcarPosicao(mapa, limites, g->x[i] - dx, g->y[i] - dy);
+                    marcarPosicao(mapa, limites, g->x[j] + dx, g->y[j] + dy);
+                }
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < c->capacidade; i++)
+        {
+            if (c->chaves[i] != CHAVE_VAZIA)
+                marcarPosicao(mapa, limites, (int)(c->chaves[i] >> 32), (int)(uint32_t)c->chaves[i]);
+        }
+        size_t palavras = c->mapa ? ((size_t)c->previstos.linhas * (size_t)c->previstos.colunas + 63) / 64 : 0;
+        for (size_t w = 0; w < palavras; w++)
+        {
+            for (uint64_t bits = c->mapa[w]; bits != 0; bits &= bits - 1)
+            {
+                size_t p = w * 64 + (size_t)__builtin_ctzll(bits);
+                marcarPosicao(mapa, limites, (int)(p / (size_t)c->previstos.colunas), (int)(p % (size_t)c->previstos.colunas));
+            }
+        }
+    }
+
+    RedeAntenas *h = NULL, *ultimo = NULL;
+    for (size_t w = 0; w < (celulas + 63) / 64; w++)
+    {
+        for (uint64_t bits = mapa[w]; bits != 0; bits &= bits - 1)
+        {
+            size_t p = w * 64 + (size_t)__builtin_ctzll(bits);
+            RedeAntenas *novo = criarEfeitoNefasto((int)(p / (size_t)limites.colunas), (int)(p % (size_t)limites.colunas));
+            if (novo == NULL)
+            {
+                libertarEfeitos(h);
+                libertarMemoria(mapa);
+                return false;
+            }
+            if (ultimo == NULL)
+                h = novo;
+            else
+                ultimo->prox = novo;
+            ultimo = novo;
+        }
+    }
+    libertarMemoria(mapa);
+
+    *efeitos = indexarEfeitos(h);
+    return true;
+}
+
+/***
+ * Devolve a mesma lista de antenas que carregarAntenasMapa e as posições com efeito nefasto dentro da
+ * matriz, sem repetições e por ordem. O cálculo dos pares começa com o primeiro lote de antenas, pelo
+ * que o tempo total se aproxima do maior entre a leitura e o cálculo em vez da sua soma.
+ */
+bool carregarEfeitosPipeline(char *nomeFicheiro, Antena **antenas, LimitesMapa *limites, RedeAntenas **efeitos)
+{
+    if (nomeFicheiro == NULL || antenas == NULL || limites == NULL || efeitos == NULL)
+    {
+        return false;
+    }
+    *antenas = NULL;
+    *efeitos = NULL;
+
+    EstadoIngestao e;
+    memset(&e, 0, sizeof(e));
+    atomic_init(&e.cancelar, false);
+    e.fd = open(nomeFicheiro, O_RDONLY);
+    if (e.fd < 0)
+    {
+        return false;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(e.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    struct stat info;
+    off_t tamanhoFicheiro = (fstat(e.fd, &info) == 0) ? info.st_size : 0;
+
+    bool ok = iniciarAnel(&e.blocosCheios, NUM_BLOCOS_LEITURA) && iniciarAnel(&e.blocosLivres, NUM_BLOCOS_LEITURA) &&
+              iniciarAnel(&e.lotesCheios, NUM_LOTES) && iniciarAnel(&e.lotesLivres, NUM_LOTES);
+    e.lotes = ok ? (LoteAntenas *)reservarMemoria(NUM_LOTES * sizeof(LoteAntenas)) : NULL;
+    ok = ok && e.lotes;
+    for (int i = 0; i < NUM_BLOCOS_LEITURA && ok; i++)
+    {
+        e.blocos[i].dados = (char *)reservarMemoria(TAMANHO_BLOCO_LEITURA);
+        ok = (e.blocos[i].dados != NULL);
+        if (ok)
+            colocarAnel(&e.blocosLivres, &e.blocos[i]);
+    }
+    for (int i = 0; i < NUM_LOTES && ok; i++)
+    {
+        colocarAnel(&e.lotesLivres, &e.lotes[i]);
+    }
+
+    pthread_t leitor, interprete;
+    bool leitorCriado = ok && pthread_create(&leitor, NULL, lerBlocos, &e) == 0;
+    bool interpreteCriado = leitorCriado && pthread_create(&interprete, NULL, interpretarBlocos, &e) == 0;
+    if (leitorCriado && !interpreteCriado)
+    {
+        // Sem quem interprete os blocos, a leitura é interrompida e os blocos já lidos são devolvidos
+        atomic_store_explicit(&e.cancelar, true, memory_order_relaxed);
+        BlocoLeitura *b;
+        while ((b = (BlocoLeitura *)retirarAnel(&e.blocosCheios))->tamanho > 0)
+        {
+            colocarAnel(&e.blocosLivres, b);
+        }
+    }
+    ok = interpreteCriado;
+
+    // Agrupa e calcula à medida que os lotes chegam; se faltar memória continua só a devolver lotes,
+    // para que as outras fases cheguem ao fim
+    GrupoIngestao grupos[NUM_FREQUENCIAS];
+    memset(grupos, 0, sizeof(grupos));
+    ConjuntoEfeitos conjunto = { NULL, 0, 0, NULL, { 0, 0 } };
+    Antena *h = NULL;
+    while (ok)
+    {
+        LoteAntenas *lote = (LoteAntenas *)retirarAnel(&e.lotesCheios);
+        preverLimites(&conjunto, lote->largura, lote->bytesLinha, tamanhoFicheiro);
+        for (int i = 0; i < lote->n && ok; i++)
+        {
+            Antena *nova = criarAntena(lote->freq[i], lote->x[i], lote->y[i]);
+            if (nova == NULL)
+            {
+                ok = false;
+                break;
+            }
+            nova->prox = h;
+            h = nova;
+            ok = receberAntena(&grupos[(unsigned char)lote->freq[i] % NUM_FREQUENCIAS], &conjunto, lote->x[i], lote->y[i]);
+        }
+
+        bool ultimo = lote->ultimo;
+        if (ultimo)
+        {
+            *limites = lote->limites;
+            ok = ok && !lote->erro;
+        }
+        colocarAnel(&e.lotesLivres, lote);
+        if (ultimo)
+        {
+            break;
+        }
+        if (!ok)
+        {
+            atomic_store_explicit(&e.cancelar, true, memory_order_relaxed);
+            while (!((LoteAntenas *)(lote = retirarAnel(&e.lotesCheios)))->ultimo)
+            {
+                colocarAnel(&e.lotesLivres, lote);
+            }
+        }
+    }
+
+    if (interpreteCriado)
+        pthread_join(interprete, NULL);
+    if (leitorCriado)
+        pthread_join(leitor, NULL);
+    close(e.fd);
+
+    ok = ok && listarEfeitos(&conjunto, grupos, *limites, efeitos);
+    if (ok)
+    {
+        *antenas = h;
+    }
+    else
+    {
+        libertarAntenas(h);
+    }
+
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        libertarMemoria(grupos[f].x);
+        libertarMemoria(grupos[f].y);
+    }
+    libertarMemoria(conjunto.chaves);
+    libertarMemoria(conjunto.mapa);
+    for (int i = 0; i < NUM_BLOCOS_LEITURA; i++)
+    {
+        libertarMemoria(e.blocos[i].dados);
+    }
+    libertarMemoria(e.lotes);
+    libertarMemoria(e.blocosCheios.itens);
+    libertarMemoria(e.blocosLivres.itens);
+    libertarMemoria(e.lotesCheios.itens);
+    libertarMemoria(e.lotesLivres.itens);
+    return ok;
+}
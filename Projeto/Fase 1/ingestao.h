@@ -0,0 +1,12 @@
+/***
+ * @file ingestao.h
+ * @brief Leitura do mapa em pipeline: a leitura, a interpretação e o cálculo dos efeitos decorrem em simultâneo
+ * @author David Costa
+ */
+#ifndef INGESTAO_H
+#define INGESTAO_H
+#include "struct.h"
+
+#endif
+
+bool carregarEfeitosPipeline(char *nomeFicheiro, Antena **antenas, LimitesMapa *limites, RedeAntenas **efeitos);
@@ -7,15 +7,56 @@
  * @brief Programa principal para gestão de antenas.
  */
 
+#define _POSIX_C_SOURCE 200809L // Para o diário de edições de funcoes.c, que é incluído depois de <stdio.h>
 #include <stdio.h>
 #include "struct.h"
 #include "funcoes.c"
 
-int main() {
+// Mostra o estado do mapa vigiado depois de cada alteração do ficheiro
+static bool mostrarAlteracao(VigiaMapa* v, int linhasAlteradas, void* dados) {
+    (void)dados;
+    if (linhasAlteradas < 0) {
+        printf("Erro ao atualizar o mapa.\n");
+    } else if (linhasAlteradas > 0) {
+        printf("%d linhas alteradas, %zu antenas, %zu posicoes com efeito nefasto\n",
+               linhasAlteradas, v->grelhaAntenas->ocupadas, v->efeitos->ocupadas);
+        fflush(stdout);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
     Antena* lista = NULL;
     RedeAntenas* listaNefastos = NULL;
     bool removida;
 
+    // Modo de vigilância: programa --vigiar <mapa>
+    if (argc == 3 && strcmp(argv[1], "--vigiar") == 0) {
+        VigiaMapa* v = criarVigia(argv[2]);
+        if (v == NULL) {
+            printf("Erro ao carregar o mapa.\n");
+            return 1;
+        }
+        mostrarAlteracao(v, v->numLinhas, NULL);
+        if (!vigiarMapa(v, mostrarAlteracao, NULL)) {
+            printf("Nao e possivel vigiar o ficheiro neste sistema.\n");
+        }
+        libertarVigia(v);
+        return 0;
+    }
+
+    // Modo de comparação: programa <mapa antigo> <mapa novo>
+    if (argc == 3) {
+        DiferencasMapa dif;
+        if (!compararMapas(argv[1], argv[2], &dif)) {
+            printf("Erro ao comparar os mapas.\n");
+            return 1;
+        }
+        imprimirDiferencas(&dif);
+        libertarDiferencas(&dif);
+        return 0;
+    }
+
     // Inserção manual de antenas
     lista = inserirAntena(lista, criarAntena('A', 3, 2));
     lista = inserirAntena(lista, criarAntena('B', 4, 2));
@@ -39,7 +80,8 @@ int main() {
     imprimirAntenas(lista);
     printf("\n");
 
-    // Carregar antenas de um ficheiro
+    // Carregar antenas de um ficheiro (a lista anterior deixa de ser usada)
+    libertarAntenas(lista);
     lista = carregarAntenas("antenas.txt");
     if (lista == NULL) {
         printf("Erro ao carregar antenas do ficheiro.\n");
@@ -70,5 +112,13 @@ int main() {
         printf("Falha ao criar o mapa atualizado com efeitos nefastos.\n");
     }
 
+    libertarEfeitos(listaNefastos);
+    libertarAntenas(lista);
+
+    // Tudo o que a biblioteca reservou devia ter sido libertado
+    if (!relatorioMemoria(NULL, NULL)) {
+        relatorioMemoria(stderr, NULL);
+    }
+
     return 0;
 }
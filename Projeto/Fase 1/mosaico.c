@@ -0,0 +1,380 @@
+/***
+ * @file mosaico.c
+ * @brief Cálculo dos efeitos nefastos por mosaicos, com troca das posições entre threads por filas limitadas
+ * @author David Costa
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "struct.h"
+#include "mosaico.h"
+
+#define TAMANHO_LOTE 256        // Posições juntadas antes de seguirem para a fila de outra thread
+
+// Fila limitada de posições com vários produtores e um consumidor (a thread dona)
+typedef struct FilaPosicoes
+{
+    int *x, *y;
+    size_t capacidade, inicio, tamanho;
+    pthread_mutex_t trinco;
+} FilaPosicoes;
+
+// Posições à espera de seguirem para a fila de uma thread
+typedef struct LotePosicoes
+{
+    int x[TAMANHO_LOTE], y[TAMANHO_LOTE];
+    int n;
+} LotePosicoes;
+
+typedef struct Mosaico
+{
+    int x0, y0;                 // Canto superior esquerdo
+    int linhas, colunas;
+    uint64_t *mapa;             // Um bit por posição do mosaico
+} Mosaico;
+
+typedef struct EstadoMosaicos
+{
+    const GruposFrequencia *grupos;
+    LimitesMapa limites;
+    int altura, largura;        // Dimensão dos mosaicos
+    int mosaicosPorLinha, numMosaicos;
+    Mosaico *mosaicos;
+    int numThreads;
+    FilaPosicoes *filas;        // Uma por thread
+    int filasIniciadas;         // Filas com o trinco já inicializado (as primeiras)
+    int produtoresAtivos;       // Threads que ainda estão a percorrer pares
+    pthread_mutex_t trincoAtivos;
+    pthread_cond_t pronto;      // As threads esperam que se saiba quantas arrancaram antes de começar
+    bool arrancar;
+    bool erro;
+} EstadoMosaicos;
+
+typedef struct TrabalhoMosaico
+{
+    EstadoMosaicos *estado;
+    int id;
+    LotePosicoes *lotes;        // Um por thread de destino
+} TrabalhoMosaico;
+
+static inline int mosaicoDe(const EstadoMosaicos *e, int x, int y)
+{
+    return (x / e->altura) * e->mosaicosPorLinha + y / e->largura;
+}
+
+static inline void marcarMosaico(EstadoMosaicos *e, int x, int y)
+{
+    Mosaico *m = &e->mosaicos[mosaicoDe(e, x, y)];
+    size_t i = (size_t)(x - m->x0) * (size_t)m->colunas + (size_t)(y - m->y0);
+    m->mapa[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+// Esvazia a fila de entrada da thread, marcando as posições nos seus mosaicos; devolve quantas tirou
+static size_t esvaziarFila(EstadoMosaicos *e, int id)
+{
+    FilaPosicoes *f = &e->filas[id];
+    int x[TAMANHO_LOTE], y[TAMANHO_LOTE];
+    size_t total = 0, n;
+
+    do
+    {
+        // Copia um lote e marca-o já fora do trinco, para não atrasar os produtores
+        pthread_mutex_lock(&f->trinco);
+        n = (f->tamanho < TAMANHO_LOTE) ? f->tamanho : TAMANHO_LOTE;
+        for (size_t k = 0; k < n; k++)
+        {
+            size_t i = (f->inicio + k) % f->capacidade;
+            x[k] = f->x[i];
+            y[k] = f->y[i];
+        }
+        f->inicio = (f->inicio + n) % f->capacidade;
+        f->tamanho -= n;
+        pthread_mutex_unlock(&f->trinco);
+
+        for (size_t k = 0; k < n; k++)
+        {
+            marcarMosaico(e, x[k], y[k]);
+        }
+        total += n;
+    } while (n > 0);
+    return total;
+}
+
+// Envia o lote para a fila da thread destino. Com a fila cheia, esvazia entretanto a sua própria fila:
+// duas threads à espera uma da outra continuam sempre a consumir, por isso não ficam bloqueadas
+static void enviarLote(EstadoMosaicos *e, int id, int destino, LotePosicoes *lote)
+{
+    FilaPosicoes *f = &e->filas[destino];
+    int enviados = 0;
+
+    while (enviados < lote->n)
+    {
+        pthread_mutex_lock(&f->trinco);
+        while (enviados < lote->n && f->tamanho < f->capacidade)
+        {
+            size_t i = (f->inicio + f->tamanho) % f->capacidade;
+            f->x[i] = lote->x[enviados];
+            f->y[i] = lote->y[enviados];
+            f->tamanho++;
+            enviados++;
+        }
+        pthread_mutex_unlock(&f->trinco);
+
+        if (enviados < lote->n && esvaziarFila(e, id) == 0)
+        {
+            sched_yield();
+        }
+    }
+    lote->n = 0;
+}
+
+static void registarPosicao(TrabalhoMosaico *t, int x, int y)
+{
+    EstadoMosaicos *e = t->estado;
+    if (x < 0 || x >= e->limites.linhas || y < 0 || y >= e->limites.colunas)
+    {
+        return;
+    }
+
+    // Os mosaicos da própria thread são marcados diretamente; os outros recebem a posição pela fila
+    int destino = mosaicoDe(e, x, y) % e->numThreads;
+    if (destino == t->id)
+    {
+        marcarMosaico(e, x, y);
+        return;
+    }
+
+    LotePosicoes *lote = &t->lotes[destino];
+    lote->x[lote->n] = x;
+    lote->y[lote->n] = y;
+    if (++lote->n == TAMANHO_LOTE)
+    {
+        enviarLote(e, t->id, destino, lote);
+    }
+}
+
+static void *trabalharMosaicos(void *arg)
+{
+    TrabalhoMosaico *t = (TrabalhoMosaico *)arg;
+    EstadoMosaicos *e = t->estado;
+    const GruposFrequencia *g = e->grupos;
+
+    // A divisão dos mosaicos depende do número de threads, que só fica fixo quando todas foram criadas
+    pthread_mutex_lock(&e->trincoAtivos);
+    while (!e->arrancar)
+        pthread_cond_wait(&e->pronto, &e->trincoAtivos);
+    pthread_mutex_unlock(&e->trincoAtivos);
+
+    // Cada par é calculado pela thread dona do mosaico da primeira antena do par
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        for (size_t i = g->inicio[f]; i < g->inicio[f + 1]; i++)
+        {
+            int ax = g->x[i], ay = g->y[i];
+            if (ax < 0 || ax >= e->limites.linhas || ay < 0 || ay >= e->limites.colunas ||
+                mosaicoDe(e, ax, ay) % e->numThreads != t->id)
+                continue;
+
+            for (size_t j = i + 1; j < g->inicio[f + 1]; j++)
+            {
+                int dx = g->x[j] - ax;
+                int dy = g->y[j] - ay;
+                if (dx == 0 && dy == 0)
+                    continue;
+
+                registarPosicao(t, ax - dx, ay - dy);
+                registarPosicao(t, g->x[j] + dx, g->y[j] + dy);
+            }
+        }
+    }
+
+    for (int d = 0; d < e->numThreads; d++)
+    {
+        if (t->lotes[d].n > 0)
+            enviarLote(e, t->id, d, &t->lotes[d]);
+    }
+
+    pthread_mutex_lock(&e->trincoAtivos);
+    e->produtoresAtivos--;
+    pthread_mutex_unlock(&e->trincoAtivos);
+
+    // Depois de todas as threads acabarem os pares já ninguém envia: basta esvaziar a fila uma última vez
+    for (;;)
+    {
+        pthread_mutex_lock(&e->trincoAtivos);
+        bool terminado = (e->produtoresAtivos == 0);
+        pthread_mutex_unlock(&e->trincoAtivos);
+
+        if (esvaziarFila(e, t->id) == 0)
+        {
+            if (terminado)
+                break;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Junta os mapas dos mosaicos numa lista ordenada por (x, y): a ordem é a mesma em qualquer execução
+static bool juntarMosaicos(const EstadoMosaicos *e, RedeAntenas **efeitos, size_t *total)
+{
+    RedeAntenas *h = NULL, *ultimo = NULL;
+    *total = 0;
+
+    for (int x = 0; x < e->limites.linhas; x++)
+    {
+        for (int m = (x / e->altura) * e->mosaicosPorLinha; m < (x / e->altura + 1) * e->mosaicosPorLinha; m++)
+        {
+            const Mosaico *mo = &e->mosaicos[m];
+            for (int y = 0; y < mo->colunas; y++)
+            {
+                size_t i = (size_t)(x - mo->x0) * (size_t)mo->colunas + (size_t)y;
+                if (!((mo->mapa[i >> 6] >> (i & 63)) & 1))
+                    continue;
+
+                (*total)++;
+                if (efeitos == NULL)
+                    continue;
+
+                RedeAntenas *novo = criarEfeitoNefasto(x, mo->y0 + y);
+                if (novo == NULL)
+                {
+                    libertarEfeitos(h);
+                    return false;
+                }
+                if (ultimo == NULL)
+                    h = novo;
+                else
+                    ultimo->prox = novo;
+                ultimo = novo;
+            }
+        }
+    }
+
+    if (efeitos != NULL)
+    {
+        *efeitos = indexarEfeitos(h); // Já está ordenada: o índice é construído de uma passagem
+    }
+    return true;
+}
+
+static void libertarEstado(EstadoMosaicos *e)
+{
+    for (int m = 0; m < e->numMosaicos && e->mosaicos; m++)
+    {
+        libertarMemoria(e->mosaicos[m].mapa);
+    }
+    for (int t = 0; t < e->numThreads && e->filas; t++)
+    {
+        libertarMemoria(e->filas[t].x);
+        libertarMemoria(e->filas[t].y);
+        if (t < e->filasIniciadas)
+            pthread_mutex_destroy(&e->filas[t].trinco);
+    }
+    libertarMemoria(e->mosaicos);
+    libertarMemoria(e->filas);
+}
+
+bool calcularEfeitosMosaico(Antena *h, LimitesMapa limites, const ConfigMosaico *cfg, RedeAntenas **efeitos, size_t *total)
+{
+    if (cfg == NULL || total == NULL || cfg->alturaMosaico <= 0 || cfg->larguraMosaico <= 0 ||
+        cfg->numThreads <= 0 || limites.linhas <= 0 || limites.colunas <= 0)
+    {
+        return false;
+    }
+
+    GruposFrequencia grupos;
+    if (!agruparPorFrequencia(h, &grupos))
+    {
+        return false;
+    }
+
+    EstadoMosaicos e;
+    memset(&e, 0, sizeof(e));
+    e.grupos = &grupos;
+    e.limites = limites;
+    e.altura = cfg->alturaMosaico;
+    e.largura = cfg->larguraMosaico;
+    e.mosaicosPorLinha = (limites.colunas + e.largura - 1) / e.largura;
+    e.numMosaicos = ((limites.linhas + e.altura - 1) / e.altura) * e.mosaicosPorLinha;
+    e.numThreads = (cfg->numThreads < e.numMosaicos) ? cfg->numThreads : e.numMosaicos;
+    pthread_mutex_init(&e.trincoAtivos, NULL);
+    pthread_cond_init(&e.pronto, NULL);
+
+    // Memória de cada mosaico: o seu mapa de bits; de cada thread: a fila e um lote por destino
+    e.mosaicos = (Mosaico *)reservarMemoriaZerada((size_t)e.numMosaicos, sizeof(Mosaico));
+    e.filas = (FilaPosicoes *)reservarMemoriaZerada((size_t)e.numThreads, sizeof(FilaPosicoes));
+    TrabalhoMosaico *trabalhos = (TrabalhoMosaico *)reservarMemoriaZerada((size_t)e.numThreads, sizeof(TrabalhoMosaico));
+    pthread_t *threads = (pthread_t *)reservarMemoria((size_t)e.numThreads * sizeof(pthread_t));
+    bool ok = e.mosaicos && e.filas && trabalhos && threads;
+
+    for (int m = 0; m < e.numMosaicos && ok; m++)
+    {
+        Mosaico *mo = &e.mosaicos[m];
+        mo->x0 = (m / e.mosaicosPorLinha) * e.altura;
+        mo->y0 = (m % e.mosaicosPorLinha) * e.largura;
+        mo->linhas = (limites.linhas - mo->x0 < e.altura) ? limites.linhas - mo->x0 : e.altura;
+        mo->colunas = (limites.colunas - mo->y0 < e.largura) ? limites.colunas - mo->y0 : e.largura;
+        mo->mapa = (uint64_t *)reservarMemoriaZerada(((size_t)mo->linhas * (size_t)mo->colunas + 63) / 64, sizeof(uint64_t));
+        ok = (mo->mapa != NULL);
+    }
+
+    size_t capacidade = (cfg->capacidadeFila >= TAMANHO_LOTE) ? cfg->capacidadeFila : TAMANHO_LOTE;
+    for (int t = 0; t < e.numThreads && ok; t++)
+    {
+        e.filas[t].capacidade = capacidade;
+        e.filas[t].x = (int *)reservarMemoria(capacidade * sizeof(int));
+        e.filas[t].y = (int *)reservarMemoria(capacidade * sizeof(int));
+        if (pthread_mutex_init(&e.filas[t].trinco, NULL) != 0)
+        {
+            ok = false;
+            break;
+        }
+        e.filasIniciadas++;
+        trabalhos[t].estado = &e;
+        trabalhos[t].id = t;
+        trabalhos[t].lotes = (LotePosicoes *)reservarMemoriaZerada((size_t)e.numThreads, sizeof(LotePosicoes));
+        ok = e.filas[t].x && e.filas[t].y && trabalhos[t].lotes;
+    }
+
+    // Como no otimizador, os mosaicos só são repartidos depois de se saber quantas threads arrancaram:
+    // as criadas ficam com os ids 0 .. criadas-1 e esta thread com o seguinte
+    int criadas = 0;
+    for (int t = 0; t + 1 < e.numThreads && ok; t++)
+    {
+        if (pthread_create(&threads[t], NULL, trabalharMosaicos, &trabalhos[t]) != 0)
+            break;
+        criadas++;
+    }
+
+    int alocadas = e.numThreads;
+    pthread_mutex_lock(&e.trincoAtivos);
+    e.numThreads = criadas + 1;
+    e.produtoresAtivos = e.numThreads;
+    e.arrancar = true;
+    pthread_cond_broadcast(&e.pronto);
+    pthread_mutex_unlock(&e.trincoAtivos);
+
+    if (ok)
+        trabalharMosaicos(&trabalhos[criadas]);
+    for (int t = 0; t < criadas; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    ok = ok && juntarMosaicos(&e, efeitos, total);
+
+    e.numThreads = alocadas;
+    for (int t = 0; t < e.numThreads && trabalhos; t++)
+    {
+        libertarMemoria(trabalhos[t].lotes);
+    }
+    libertarMemoria(trabalhos);
+    libertarMemoria(threads);
+    libertarEstado(&e);
+    pthread_mutex_destroy(&e.trincoAtivos);
+    pthread_cond_destroy(&e.pronto);
+    libertarGrupos(&grupos);
+    return ok;
+}
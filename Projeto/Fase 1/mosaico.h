@@ -0,0 +1,28 @@
+/***
+ * @file mosaico.h
+ * @brief Cálculo dos efeitos nefastos com a matriz dividida em mosaicos processados em paralelo
+ *
+ * Como o main.c já inclui o funcoes.c, o módulo compila-se ao lado dele: gcc -pthread main.c mosaico.c
+ * (ou, num programa que não inclua o funcoes.c, gcc -pthread programa.c funcoes.c mosaico.c)
+ * @author David Costa
+ */
+#ifndef MOSAICO_H
+#define MOSAICO_H
+#include "struct.h"
+
+/***
+ * @brief Configuração da divisão em mosaicos
+ * @param alturaMosaico Linhas de cada mosaico (os da última fila podem ter menos)
+ * @param larguraMosaico Colunas de cada mosaico
+ * @param numThreads Threads de trabalho; cada uma fica com os mosaicos t, t + numThreads, ...
+ * @param capacidadeFila Posições que cabem na fila de entrada de cada thread
+ */
+typedef struct ConfigMosaico {
+    int alturaMosaico, larguraMosaico;
+    int numThreads;
+    size_t capacidadeFila;
+} ConfigMosaico;
+
+#endif
+
+bool calcularEfeitosMosaico(Antena *h, LimitesMapa limites, const ConfigMosaico *cfg, RedeAntenas **efeitos, size_t *total);
@@ -0,0 +1,445 @@
+/***
+ * @file otimizador.c
+ * @brief Recozimento simulado paralelo sobre a frequência de cada antena, com avaliação incremental:
+ *        mudar uma antena de frequência só mexe nos pares com as antenas dos dois grupos envolvidos
+ * @author David Costa
+ */
+#define _POSIX_C_SOURCE 200809L // pthread_barrier_t não existe com -std=c11 sem este pedido
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "struct.h"
+#include "otimizador.h"
+
+#define NUM_EPOCAS 64           // Pontos de sincronização entre as cadeias
+
+// Estado de uma cadeia: atribuição atual, grupos por frequência e pares que produzem cada posição
+typedef struct CadeiaRecozimento
+{
+    int *freq;                  // Frequência de cada antena
+    int *posicaoNoGrupo;        // Posição de cada antena no seu grupo
+    int *grupos[NUM_FREQUENCIAS];
+    int *grupoX[NUM_FREQUENCIAS], *grupoY[NUM_FREQUENCIAS]; // Coordenadas das antenas de cada grupo, pela mesma ordem
+    int tamanho[NUM_FREQUENCIAS];
+    uint32_t *contagens;        // Uma por posição da matriz
+    size_t efeitos;             // Posições com contagem positiva
+    uint64_t aleatorio;
+} CadeiaRecozimento;
+
+typedef struct EstadoOtimizador
+{
+    int n;
+    const int *x, *y;
+    LimitesMapa limites;
+    int capacidade[NUM_FREQUENCIAS];
+    int permitidas[NUM_FREQUENCIAS], numPermitidas;
+    const ConfigOtimizador *cfg;
+    int numThreads;
+    CadeiaRecozimento *cadeias;
+    int *melhor;                // Melhor atribuição vista nas sincronizações
+    size_t efeitosMelhor;
+    pthread_barrier_t barreira;
+    pthread_mutex_t arranque;   // As threads esperam que a barreira exista antes de começar
+    pthread_cond_t pronto;
+    bool barreiraPronta;
+} EstadoOtimizador;
+
+typedef struct TrabalhoOtimizador
+{
+    EstadoOtimizador *estado;
+    int id;
+} TrabalhoOtimizador;
+
+static inline uint64_t proximoAleatorio(uint64_t *s)
+{
+    // xorshift64*
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 0x2545F4914F6CDD1DULL;
+}
+
+// Soma sinal às contagens das posições com efeito entre a antena i e todas as do grupo f.
+// O próprio i, se estiver no grupo, não conta: efeitosAntena ignora antenas na mesma posição
+static void contarGrupo(const EstadoOtimizador *e, CadeiaRecozimento *c, int i, int f, int sinal)
+{
+    size_t indices[2 * PARES_POR_BLOCO];
+
+    for (int j = 0; j < c->tamanho[f]; j += PARES_POR_BLOCO)
+    {
+        int n = (c->tamanho[f] - j < PARES_POR_BLOCO) ? c->tamanho[f] - j : PARES_POR_BLOCO;
+        int k = efeitosAntena(e->x[i], e->y[i], c->grupoX[f] + j, c->grupoY[f] + j, n, e->limites, indices);
+
+        for (int t = 0; t < k; t++)
+        {
+            uint32_t *p = &c->contagens[indices[t]];
+            if (sinal > 0)
+            {
+                if ((*p)++ == 0)
+                    c->efeitos++;
+            }
+            else if (--(*p) == 0)
+            {
+                c->efeitos--;
+            }
+        }
+    }
+}
+
+static void retirarDoGrupo(const EstadoOtimizador *e, CadeiaRecozimento *c, int i)
+{
+    int f = c->freq[i];
+    contarGrupo(e, c, i, f, -1);
+
+    int k = c->posicaoNoGrupo[i];
+    int ultimo = --c->tamanho[f];
+    c->grupos[f][k] = c->grupos[f][ultimo];
+    c->grupoX[f][k] = c->grupoX[f][ultimo];
+    c->grupoY[f][k] = c->grupoY[f][ultimo];
+    c->posicaoNoGrupo[c->grupos[f][k]] = k;
+}
+
+static void colocarNoGrupo(const EstadoOtimizador *e, CadeiaRecozimento *c, int i, int f)
+{
+    contarGrupo(e, c, i, f, +1);
+
+    int k = c->tamanho[f]++;
+    c->freq[i] = f;
+    c->posicaoNoGrupo[i] = k;
+    c->grupos[f][k] = i;
+    c->grupoX[f][k] = e->x[i];
+    c->grupoY[f][k] = e->y[i];
+}
+
+static void moverAntena(const EstadoOtimizador *e, CadeiaRecozimento *c, int i, int f)
+{
+    retirarDoGrupo(e, c, i);
+    colocarNoGrupo(e, c, i, f);
+}
+
+static void libertarCadeia(CadeiaRecozimento *c)
+{
+    libertarMemoria(c->freq);
+    libertarMemoria(c->posicaoNoGrupo);
+    libertarMemoria(c->contagens);
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        libertarMemoria(c->grupos[f]);
+        libertarMemoria(c->grupoX[f]);
+        libertarMemoria(c->grupoY[f]);
+    }
+}
+
+static bool reservarCadeia(const EstadoOtimizador *e, CadeiaRecozimento *c)
+{
+    memset(c, 0, sizeof(*c));
+    c->freq = (int *)reservarMemoria((size_t)e->n * sizeof(int));
+    c->posicaoNoGrupo = (int *)reservarMemoria((size_t)e->n * sizeof(int));
+    c->contagens = (uint32_t *)reservarMemoriaZerada((size_t)e->limites.linhas * (size_t)e->limites.colunas, sizeof(uint32_t));
+    bool ok = c->freq && c->posicaoNoGrupo && c->contagens;
+    for (int k = 0; k < e->numPermitidas && ok; k++)
+    {
+        // Uma posição a mais: numa troca, o grupo de destino recebe a antena antes de ceder a outra
+        int f = e->permitidas[k];
+        c->grupos[f] = (int *)reservarMemoria(((size_t)e->capacidade[f] + 1) * sizeof(int));
+        c->grupoX[f] = (int *)reservarMemoria(((size_t)e->capacidade[f] + 1) * sizeof(int));
+        c->grupoY[f] = (int *)reservarMemoria(((size_t)e->capacidade[f] + 1) * sizeof(int));
+        ok = c->grupos[f] && c->grupoX[f] && c->grupoY[f];
+    }
+    if (!ok)
+    {
+        libertarCadeia(c);
+    }
+    return ok;
+}
+
+static void copiarCadeia(const EstadoOtimizador *e, CadeiaRecozimento *destino, const CadeiaRecozimento *origem)
+{
+    memcpy(destino->freq, origem->freq, (size_t)e->n * sizeof(int));
+    memcpy(destino->posicaoNoGrupo, origem->posicaoNoGrupo, (size_t)e->n * sizeof(int));
+    memcpy(destino->contagens, origem->contagens, (size_t)e->limites.linhas * (size_t)e->limites.colunas * sizeof(uint32_t));
+    for (int k = 0; k < e->numPermitidas; k++)
+    {
+        int f = e->permitidas[k];
+        memcpy(destino->grupos[f], origem->grupos[f], (size_t)origem->tamanho[f] * sizeof(int));
+        memcpy(destino->grupoX[f], origem->grupoX[f], (size_t)origem->tamanho[f] * sizeof(int));
+        memcpy(destino->grupoY[f], origem->grupoY[f], (size_t)origem->tamanho[f] * sizeof(int));
+        destino->tamanho[f] = origem->tamanho[f];
+    }
+    destino->efeitos = origem->efeitos;
+}
+
+// Uma tentativa: muda uma antena para outra frequência, ou troca-a com uma antena dessa frequência
+// se esta estiver cheia. A alteração é desfeita se não for aceite.
+static void tentarAlteracao(const EstadoOtimizador *e, CadeiaRecozimento *c, double temperatura)
+{
+    int i = (int)(proximoAleatorio(&c->aleatorio) % (uint64_t)e->n);
+    int f = c->freq[i];
+    int g = e->permitidas[proximoAleatorio(&c->aleatorio) % (uint64_t)e->numPermitidas];
+    if (g == f)
+    {
+        return;
+    }
+
+    size_t antes = c->efeitos;
+    int j = -1;
+    if (c->tamanho[g] >= e->capacidade[g])
+    {
+        j = c->grupos[g][proximoAleatorio(&c->aleatorio) % (uint64_t)c->tamanho[g]];
+    }
+    moverAntena(e, c, i, g);
+    if (j >= 0)
+    {
+        moverAntena(e, c, j, f);
+    }
+
+    double delta = (double)c->efeitos - (double)antes;
+    if (delta <= 0)
+    {
+        return;
+    }
+    double u = (double)(proximoAleatorio(&c->aleatorio) >> 11) * (1.0 / 9007199254740992.0);
+    if (temperatura > 0 && u < exp(-delta / temperatura))
+    {
+        return;
+    }
+
+    if (j >= 0)
+    {
+        moverAntena(e, c, j, g);
+    }
+    moverAntena(e, c, i, f);
+}
+
+static void *trabalharOtimizador(void *arg)
+{
+    TrabalhoOtimizador *t = (TrabalhoOtimizador *)arg;
+    EstadoOtimizador *e = t->estado;
+    CadeiaRecozimento *c = &e->cadeias[t->id];
+    const ConfigOtimizador *cfg = e->cfg;
+    double t0 = cfg->temperaturaInicial, t1 = cfg->temperaturaFinal;
+    double razao = (t0 > 0 && t1 > 0) ? pow(t1 / t0, 1.0 / (double)(cfg->iteracoes > 1 ? cfg->iteracoes - 1 : 1)) : 0;
+    double temperatura = t0;
+    long feitas = 0;
+
+    if (t->id != 0)
+    {
+        pthread_mutex_lock(&e->arranque);
+        while (!e->barreiraPronta)
+            pthread_cond_wait(&e->pronto, &e->arranque);
+        pthread_mutex_unlock(&e->arranque);
+    }
+
+    for (int epoca = 0; epoca < NUM_EPOCAS; epoca++)
+    {
+        long fim = cfg->iteracoes * (epoca + 1) / NUM_EPOCAS;
+        for (; feitas < fim; feitas++)
+        {
+            tentarAlteracao(e, c, temperatura);
+            temperatura = (razao > 0) ? temperatura * razao : t0 + (t1 - t0) * (double)feitas / (double)cfg->iteracoes;
+        }
+
+        // Sincronização: a melhor cadeia é guardada e as piores continuam a partir dela
+        pthread_barrier_wait(&e->barreira);
+        int lider = 0;
+        for (int k = 1; k < e->numThreads; k++)
+        {
+            if (e->cadeias[k].efeitos < e->cadeias[lider].efeitos)
+                lider = k;
+        }
+        if (t->id == lider && c->efeitos < e->efeitosMelhor)
+        {
+            memcpy(e->melhor, c->freq, (size_t)e->n * sizeof(int));
+            e->efeitosMelhor = c->efeitos;
+        }
+        bool copiar = (t->id != lider && c->efeitos > e->cadeias[lider].efeitos);
+        pthread_barrier_wait(&e->barreira);
+
+        if (copiar)
+        {
+            copiarCadeia(e, c, &e->cadeias[lider]);
+        }
+        pthread_barrier_wait(&e->barreira);
+    }
+    return NULL;
+}
+
+// Frequências permitidas e capacidades; as antenas em excesso passam para frequências com espaço
+static bool prepararFrequencias(EstadoOtimizador *e, const ConfigOtimizador *cfg, int *inicial)
+{
+    int contagem[NUM_FREQUENCIAS] = { 0 };
+    for (int i = 0; i < e->n; i++)
+    {
+        contagem[inicial[i]]++;
+    }
+
+    for (int f = 0; f < NUM_FREQUENCIAS; f++)
+    {
+        e->capacidade[f] = cfg->capacidade ? cfg->capacidade[f] : (contagem[f] > 0 ? e->n : 0);
+        if (e->capacidade[f] > e->n)
+            e->capacidade[f] = e->n;
+        if (e->capacidade[f] > 0)
+            e->permitidas[e->numPermitidas++] = f;
+    }
+
+    int ocupadas[NUM_FREQUENCIAS] = { 0 };
+    int k = 0;
+    for (int i = 0; i < e->n; i++)
+    {
+        int f = inicial[i];
+        if (ocupadas[f] < e->capacidade[f])
+        {
+            ocupadas[f]++;
+            continue;
+        }
+        while (k < e->numPermitidas && ocupadas[e->permitidas[k]] >= e->capacidade[e->permitidas[k]])
+        {
+            k++;
+        }
+        if (k == e->numPermitidas)
+        {
+            return false; // A soma das capacidades não chega para todas as antenas
+        }
+        inicial[i] = e->permitidas[k];
+        ocupadas[inicial[i]]++;
+    }
+    return true;
+}
+
+/***
+ * Reatribui as frequências das antenas (as posições não mudam) para reduzir as posições da matriz com
+ * efeito nefasto, respeitando a capacidade de cada frequência. A melhor atribuição encontrada é
+ * escrita nas antenas da lista. efeitosAntes conta os efeitos da atribuição inicial, depois de
+ * retiradas as antenas que excediam a capacidade.
+ */
+bool otimizarFrequencias(Antena *h, LimitesMapa limites, const ConfigOtimizador *cfg, size_t *efeitosAntes, size_t *efeitosDepois)
+{
+    if (cfg == NULL || cfg->numThreads <= 0 || cfg->iteracoes < 0 || limites.linhas <= 0 || limites.colunas <= 0)
+    {
+        return false;
+    }
+
+    EstadoOtimizador e;
+    memset(&e, 0, sizeof(e));
+    e.limites = limites;
+    e.cfg = cfg;
+    for (Antena *aux = h; aux != NULL; aux = aux->prox)
+    {
+        e.n++;
+    }
+
+    int *x = (int *)reservarMemoria(((size_t)e.n + 1) * sizeof(int));
+    int *y = (int *)reservarMemoria(((size_t)e.n + 1) * sizeof(int));
+    Antena **antenas = (Antena **)reservarMemoria(((size_t)e.n + 1) * sizeof(Antena *));
+    e.melhor = (int *)reservarMemoria(((size_t)e.n + 1) * sizeof(int));
+    e.cadeias = (CadeiaRecozimento *)reservarMemoriaZerada((size_t)cfg->numThreads, sizeof(CadeiaRecozimento));
+    pthread_t *threads = (pthread_t *)reservarMemoria((size_t)cfg->numThreads * sizeof(pthread_t));
+    TrabalhoOtimizador *trabalhos = (TrabalhoOtimizador *)reservarMemoria((size_t)cfg->numThreads * sizeof(TrabalhoOtimizador));
+    bool ok = x && y && antenas && e.melhor && e.cadeias && threads && trabalhos;
+
+    int i = 0;
+    for (Antena *aux = h; ok && aux != NULL; aux = aux->prox, i++)
+    {
+        x[i] = aux->x;
+        y[i] = aux->y;
+        antenas[i] = aux;
+        e.melhor[i] = (unsigned char)aux->freq % NUM_FREQUENCIAS;
+    }
+    e.x = x;
+    e.y = y;
+    ok = ok && prepararFrequencias(&e, cfg, e.melhor);
+
+    // A primeira cadeia é construída par a par; as restantes começam como cópias dela
+    int reservadas = 0;
+    while (ok && reservadas < cfg->numThreads)
+    {
+        ok = reservarCadeia(&e, &e.cadeias[reservadas]);
+        if (ok)
+        {
+            e.cadeias[reservadas].aleatorio = ((cfg->semente + 1) * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)(reservadas + 1) * 0xD1B54A32D192ED03ULL);
+            e.cadeias[reservadas].aleatorio |= 1; // O xorshift não pode começar em 0
+            reservadas++;
+        }
+    }
+
+    if (ok)
+    {
+        for (i = 0; i < e.n; i++)
+        {
+            colocarNoGrupo(&e, &e.cadeias[0], i, e.melhor[i]);
+        }
+        e.efeitosMelhor = e.cadeias[0].efeitos;
+        if (efeitosAntes != NULL)
+        {
+            *efeitosAntes = e.efeitosMelhor;
+        }
+    }
+
+    // Com menos de duas frequências ou sem antenas não há alterações possíveis
+    if (ok && e.n > 0 && e.numPermitidas > 1)
+    {
+        pthread_mutex_init(&e.arranque, NULL);
+        pthread_cond_init(&e.pronto, NULL);
+
+        // pthread_barrier_init precisa do número exato de participantes, e pthread_create pode falhar a meio:
+        // as threads criadas esperam em e.pronto até a barreira existir com o número das que arrancaram
+        int criadas = 1;
+        trabalhos[0].estado = &e;
+        trabalhos[0].id = 0;
+        for (int k = 1; k < cfg->numThreads; k++)
+        {
+            trabalhos[criadas].estado = &e;
+            trabalhos[criadas].id = criadas;
+            if (pthread_create(&threads[criadas], NULL, trabalharOtimizador, &trabalhos[criadas]) != 0)
+                break;
+            criadas++;
+        }
+        e.numThreads = criadas;
+        for (int k = 1; k < criadas; k++)
+        {
+            copiarCadeia(&e, &e.cadeias[k], &e.cadeias[0]);
+        }
+        pthread_barrier_init(&e.barreira, NULL, (unsigned)criadas);
+
+        pthread_mutex_lock(&e.arranque);
+        e.barreiraPronta = true;
+        pthread_cond_broadcast(&e.pronto);
+        pthread_mutex_unlock(&e.arranque);
+
+        trabalharOtimizador(&trabalhos[0]);
+        for (int k = 1; k < criadas; k++)
+        {
+            pthread_join(threads[k], NULL);
+        }
+
+        pthread_barrier_destroy(&e.barreira);
+        pthread_mutex_destroy(&e.arranque);
+        pthread_cond_destroy(&e.pronto);
+    }
+
+    if (ok)
+    {
+        for (i = 0; i < e.n; i++)
+        {
+            antenas[i]->freq = (char)e.melhor[i];
+        }
+        if (efeitosDepois != NULL)
+        {
+            *efeitosDepois = e.efeitosMelhor;
+        }
+    }
+
+    for (int k = 0; k < reservadas; k++)
+    {
+        libertarCadeia(&e.cadeias[k]);
+    }
+    libertarMemoria(x);
+    libertarMemoria(y);
+    libertarMemoria(antenas);
+    libertarMemoria(e.melhor);
+    libertarMemoria(e.cadeias);
+    libertarMemoria(threads);
+    libertarMemoria(trabalhos);
+    return ok;
+}
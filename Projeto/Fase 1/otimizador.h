@@ -0,0 +1,29 @@
+/***
+ * @file otimizador.h
+ * @brief Reatribuição das frequências das antenas para reduzir as posições com efeito nefasto
+ * @author David Costa
+ */
+#ifndef OTIMIZADOR_H
+#define OTIMIZADOR_H
+#include "struct.h"
+
+/***
+ * @brief Parâmetros do recozimento simulado
+ * @param numThreads Cadeias independentes, uma por thread, que partilham a melhor solução no fim de cada época
+ * @param iteracoes Alterações tentadas por cada cadeia
+ * @param temperaturaInicial Aceita pioras de cerca deste número de efeitos no início
+ * @param temperaturaFinal Temperatura no fim (arrefecimento geométrico)
+ * @param capacidade Máximo de antenas por frequência (0 exclui a frequência); NULL usa só as frequências já presentes, sem limite
+ * @param semente Semente dos geradores aleatórios (cada cadeia usa uma diferente)
+ */
+typedef struct ConfigOtimizador {
+    int numThreads;
+    long iteracoes;
+    double temperaturaInicial, temperaturaFinal;
+    const int *capacidade;
+    uint64_t semente;
+} ConfigOtimizador;
+
+#endif
+
+bool otimizarFrequencias(Antena *h, LimitesMapa limites, const ConfigOtimizador *cfg, size_t *efeitosAntes, size_t *efeitosDepois);
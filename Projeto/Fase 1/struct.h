@@ -6,16 +6,80 @@
 #ifndef STRUCTS_H
 #define STRUCTS_H
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/***
+ * @brief Contexto de memória: funções de reserva e libertação e contadores das reservas feitas com elas
+ * @param reservar Reserva tamanho bytes (dados é o campo dados do contexto, por exemplo uma arena)
+ * @param libertar Liberta um bloco devolvido por reservar, com o mesmo tamanho
+ * @param limite Máximo de bytes vivos (0 para sem limite); acima dele as reservas falham
+ * @note O contexto atual é escolhido por thread; as threads da biblioteca que reservam memória usam o de quem chama.
+ *       Os contadores são atómicos, mas reservar e libertar têm de aguentar chamadas concorrentes
+ */
+typedef struct ContextoMemoria {
+    void *(*reservar)(size_t tamanho, void *dados);
+    void (*libertar)(void *p, size_t tamanho, void *dados);
+    void *dados;
+    size_t limite;
+    size_t vivos;           // Bytes reservados e ainda não libertados
+    size_t pico;            // Máximo de bytes vivos
+    size_t reservas, libertacoes;
+    size_t falhas;          // Reservas recusadas (sem memória ou acima do limite)
+} ContextoMemoria;
+
+#define NIVEL_MAX_INDICE 16     // Altura máxima das torres do índice ordenado
+
+/***
+ * @brief Ligações de um nodo a um índice ordenado (skip list)
+ * @param indice Índice a que o nodo pertence (NULL se a lista não estiver indexada)
+ * @param saltos Ligações dos níveis 1 em diante (o nível 0 é o próprio campo prox)
+ */
+typedef struct ElosIndice {
+    struct IndiceOrdenado *indice;
+    void **saltos;
+} ElosIndice;
+
+/***
+ * @brief Operações que dão acesso aos campos de um tipo de nodo indexado
+ * @param chave Chave de ordenação do nodo, com (x, y) empacotados
+ * @param obterProx Devolve o nodo seguinte na lista ligada
+ */
+typedef struct OperacoesIndice {
+    uint64_t (*chave)(const void *no);
+    void *(*obterProx)(const void *no);
+    void (*definirProx)(void *no, void *prox);
+    ElosIndice *(*elos)(void *no);
+} OperacoesIndice;
+
+/***
+ * @brief Índice ordenado por (x, y) sobre uma lista ligada já existente
+ * @param cabeca Início de cada nível; cabeca[0] é o início da lista ligada
+ * @param nivel Número de níveis em uso
+ */
+typedef struct IndiceOrdenado {
+    void *cabeca[NIVEL_MAX_INDICE];
+    int nivel;
+    size_t tamanho;                 // Número de nodos indexados
+    uint32_t semente;               // Estado do gerador das alturas das torres
+    const OperacoesIndice *ops;     // Acesso aos campos do tipo de nodo
+} IndiceOrdenado;
 
 /***
  * @brief Estrutura de dados para representar uma antena
  * @param frequencia Frequência da antena
  * @param x Coordenada x da posição da antena
+ *
+ * Na Fase 1 as coordenadas continuam a ser int: a chave do índice junta (x, y) em 64 bits, os pares
+ * são calculados em vetores de int32 e as grelhas guardam colunas int. As coordenadas de 64 bits,
+ * para regiões com desvios acima de 2^31, são as da biblioteca da Fase 2 (Coordenada).
  */
 typedef struct Antena {
     char freq;  // Frequência da antena
     int x, y;         // Posições da antena
     struct Antena *prox;  // Ponteiro para a próxima antena
+    ElosIndice elos;      // Ligações ao índice ordenado da lista
 } Antena;
 
 /***
@@ -25,28 +89,347 @@ typedef struct Antena {
 typedef struct RedeAntenas{
     int x, y;               //Coordenadas (linha, coluna)
     struct RedeAntenas* prox;   //Apontador para o próximo efeito na lista
+    ElosIndice elos;            //Ligações ao índice ordenado da lista
 } RedeAntenas;
 
+/***
+ * @brief Limites da matriz lida de um ficheiro de antenas
+ * @param linhas Número de linhas (valores válidos de x)
+ * @param colunas Número de colunas (valores válidos de y)
+ */
+typedef struct LimitesMapa {
+    int linhas, colunas;
+} LimitesMapa;
+
+#define NUM_FREQUENCIAS 128     // Frequências indexadas pelo código do caractere
+#define PARES_POR_BLOCO 16      // Antenas b passadas de cada vez a efeitosAntena pelos ciclos sobre pares
+
+/***
+ * @brief Modos de contagem de efeitos nefastos dentro da matriz
+ */
+typedef enum ModoContagem {
+    CONTAGEM_TOTAL,             // Apenas o número de posições distintas
+    CONTAGEM_POR_FREQUENCIA     // Também o número de posições distintas de cada frequência
+} ModoContagem;
+
+/***
+ * @brief Resultado de uma contagem de efeitos nefastos
+ * @param total Posições distintas da matriz com pelo menos um efeito nefasto
+ * @param porFrequencia Posições distintas afetadas por cada frequência
+ */
+typedef struct ContagemEfeitos {
+    size_t total;
+    size_t porFrequencia[NUM_FREQUENCIAS];
+} ContagemEfeitos;
+
+/***
+ * @brief Coordenadas das antenas agrupadas por frequência em vetores contíguos
+ * @param inicio As antenas da frequência f ocupam as posições inicio[f] a inicio[f+1]-1
+ */
+typedef struct GruposFrequencia {
+    size_t inicio[NUM_FREQUENCIAS + 1];
+    int *x, *y;
+} GruposFrequencia;
+
+/***
+ * @brief Tipos de alteração entre duas versões de um mapa
+ */
+typedef enum TipoAlteracao {
+    ANTENA_ADICIONADA,
+    ANTENA_REMOVIDA,
+    ANTENA_MOVIDA,      // Antena que saiu de (x, y) e apareceu em (xNovo, yNovo) com a mesma frequência
+    EFEITO_GANHO,       // Posição que passou a ter efeito nefasto da frequência
+    EFEITO_PERDIDO      // Posição que deixou de ter efeito nefasto da frequência
+} TipoAlteracao;
+
+/***
+ * @brief Uma alteração entre duas versões de um mapa
+ * @param freq Frequência da antena ou do efeito nefasto
+ * @param xNovo Linha de destino (só em ANTENA_MOVIDA)
+ */
+typedef struct Alteracao {
+    TipoAlteracao tipo;
+    char freq;
+    int x, y;
+    int xNovo, yNovo;
+} Alteracao;
+
+/***
+ * @brief Conjunto de alterações entre duas versões de um mapa
+ * @param itens Alterações das antenas (por ordem de linha) seguidas das dos efeitos nefastos
+ * @param antes Limites do mapa antigo
+ * @param depois Limites do mapa novo
+ */
+typedef struct DiferencasMapa {
+    Alteracao *itens;
+    size_t quantidade, capacidade;
+    LimitesMapa antes, depois;
+} DiferencasMapa;
+
+/***
+ * @brief Linha não vazia de uma grelha esparsa
+ * @param colunas Colunas ocupadas, por ordem crescente
+ * @param valores Caractere de cada coluna ocupada
+ */
+typedef struct LinhaGrelha {
+    int x;
+    int n, capacidade;
+    int *colunas;
+    char *valores;
+} LinhaGrelha;
+
+/***
+ * @brief Grelha esparsa por linhas: só guarda as linhas e as células ocupadas
+ * @param linhas Linhas não vazias, por ordem crescente de x
+ * @param ocupadas Número total de células ocupadas
+ */
+typedef struct GrelhaEsparsa {
+    LimitesMapa limites;
+    LinhaGrelha *linhas;
+    int numLinhas, capacidadeLinhas;
+    size_t ocupadas;
+} GrelhaEsparsa;
+
+/***
+ * @brief Número de pares de antenas que produzem cada posição (tabela de dispersão por coordenadas)
+ */
+typedef struct TabelaContagens {
+    uint64_t *chaves;
+    uint32_t *contagens;
+    unsigned char *ocupado;
+    size_t capacidade, tamanho;
+} TabelaContagens;
+
+/***
+ * @brief Última versão de um mapa recebido em versões sucessivas, com a multiplicidade dos efeitos de cada
+ *        frequência: cada comparação com a versão seguinte só conta os pares das antenas alteradas
+ * @param contagens Pares que produzem cada posição, por frequência
+ * @param efeitos Posições da matriz com efeito nefasto, por frequência
+ * @param valido Falso depois de uma comparação falhada: as contagens são refeitas na seguinte
+ */
+typedef struct EstadoDiferencas {
+    GrelhaEsparsa *versao;
+    TabelaContagens contagens[NUM_FREQUENCIAS];
+    size_t efeitos[NUM_FREQUENCIAS];
+    bool valido;
+} EstadoDiferencas;
+
+/***
+ * @brief Posições das antenas de uma frequência, sem ordem
+ */
+typedef struct PosicoesFrequencia {
+    int *x, *y;
+    size_t n, capacidade;
+} PosicoesFrequencia;
+
+/***
+ * @brief Mapa vigiado: antenas e efeitos nefastos mantidos em memória a par do ficheiro
+ * @param dispersoes Dispersão de cada linha lida, para encontrar as linhas alteradas
+ * @param efeitos Posições da matriz com efeito nefasto ('#')
+ * @param contagens Pares que produzem cada posição, também fora da matriz
+ */
+typedef struct VigiaMapa {
+    char *nomeFicheiro;
+    int descritor;              // Descritor do inotify (-1 se não estiver disponível)
+    int vigia;
+    uint64_t *dispersoes;
+    int numLinhas;
+    LimitesMapa limites;
+    Antena *antenas;            // Lista (indexada) das antenas
+    GrelhaEsparsa *grelhaAntenas;
+    GrelhaEsparsa *efeitos;
+    TabelaContagens contagens;
+    PosicoesFrequencia porFrequencia[NUM_FREQUENCIAS];
+} VigiaMapa;
+
+/***
+ * @brief Diário de operações sobre uma lista de antenas, com instantâneo e compactação
+ * @param pendentes Registos de operações já aplicadas à lista mas ainda não escritos
+ * @param maxPendentes Confirma ao juntar este número de operações (1 confirma cada uma); a operação que
+ *        fecha o grupo é escrita antes de ser aplicada à lista, e se a escrita falhar não é aplicada
+ * @param intervaloSincronizacao Ou quando a operação pendente mais antiga tem estes milissegundos (0 sem prazo).
+ *        O prazo só é verificado na operação seguinte ou em confirmarDiarioVencido, que quem pára de editar
+ *        deve chamar no seu ciclo; sem isso, as pendentes só ficam no disco com a edição ou confirmação seguinte
+ * @param limiteCompactacao Compacta quando o diário chega a este número de registos
+ */
+typedef struct DiarioAntenas {
+    char *nomeInstantaneo, *nomeDiario;
+    FILE *ficheiro;
+    unsigned char *pendentes;
+    size_t numPendentes, capacidadePendentes;
+    size_t registos;            // Registos já escritos no ficheiro do diário
+    size_t maxPendentes;
+    unsigned intervaloSincronizacao;
+    size_t limiteCompactacao;
+    double primeiraPendente;    // Instante (em segundos) da operação pendente mais antiga
+} DiarioAntenas;
+
+/***
+ * @brief Alteração registada numa tabela de somas e ainda não aplicada
+ */
+typedef struct AlteracaoSomas {
+    int freq;       // Índice da frequência, ou -1 para os efeitos nefastos
+    int x, y;
+    int delta;
+} AlteracaoSomas;
+
+#define MAX_ALTERACOES_SOMAS 256
+
+/***
+ * @brief Tabelas de somas acumuladas, por frequência e dos efeitos nefastos, para contar posições em retângulos
+ * @param somas (linhas+1)*(colunas+1) contagens por frequência: a posição (i, j) guarda as antenas com x < i e y < j (NULL se não há antenas)
+ * @param somasEfeitos O mesmo para as posições com efeito nefasto
+ * @param pendentes Alterações feitas depois da construção, somadas às consultas até serem aplicadas de uma vez
+ */
+typedef struct TabelaSomas {
+    LimitesMapa limites;
+    uint32_t *somas[NUM_FREQUENCIAS];
+    uint32_t *somasEfeitos;
+    AlteracaoSomas pendentes[MAX_ALTERACOES_SOMAS];
+    int numPendentes;
+} TabelaSomas;
+
 #endif
 
+void iniciarContextoMemoria(ContextoMemoria *ctx, void *(*reservar)(size_t tamanho, void *dados),
+                            void (*libertar)(void *p, size_t tamanho, void *dados), void *dados, size_t limite);
+
+ContextoMemoria *usarContextoMemoria(ContextoMemoria *ctx);
+
+ContextoMemoria *contextoMemoriaAtual(void);
+
+bool relatorioMemoria(FILE *f, const ContextoMemoria *ctx);
+
+void *reservarMemoria(size_t tamanho);
+
+void *reservarMemoriaZerada(size_t n, size_t tamanho);
+
+void *realocarMemoria(void *p, size_t tamanho);
+
+void libertarMemoria(void *p);
+
 Antena *criarAntena(char freq, int x, int y);
 
 Antena *carregarAntenas(char *nomeFicheiro);
 
+Antena *carregarAntenasMapa(char *nomeFicheiro, LimitesMapa *limites);
+
 Antena *inserirAntena(Antena *h, Antena *nova);
 
 Antena *removerAntena(Antena *lista, int x, int y, bool *res);
 
+Antena *procurarAntena(Antena *h, int x, int y);
+
+Antena *indexarAntenas(Antena *h);
+
+void libertarAntenas(Antena *h);
+
 bool imprimirAntenas(Antena *lista);
 
 bool gravarAntenasBinario(char *nomeFicheiro, Antena *h);
 
+Antena *carregarAntenasBinario(char *nomeFicheiro);
+
 RedeAntenas *criarEfeitoNefasto(int x, int y);
 
 RedeAntenas *inserirEfeitoNefasto(RedeAntenas *h, RedeAntenas *novo);
 
+RedeAntenas *indexarEfeitos(RedeAntenas *h);
+
+void libertarEfeitos(RedeAntenas *h);
+
+bool agruparPorFrequencia(Antena *h, GruposFrequencia *g);
+
+void libertarGrupos(GruposFrequencia *g);
+
 RedeAntenas *calcularEfeitosNefastos(Antena *h);
 
+size_t palavrasMapaEfeitos(Antena *h, LimitesMapa limites, ModoContagem modo);
+
+bool contarEfeitosNefastos(Antena *h, LimitesMapa limites, ModoContagem modo, uint64_t *mapa, ContagemEfeitos *res);
+
+bool efeitoNoMapa(const uint64_t *mapa, LimitesMapa limites, int x, int y);
+
+int efeitosAntena(int ax, int ay, const int *bx, const int *by, int n, LimitesMapa limites, size_t *saida);
+
 bool imprimirEfeitosNefastos(RedeAntenas *h);
 
-bool imprimirAntenasNefastos(const char *nomeFicheiro, RedeAntenas *h);
\ No newline at end of file
+bool imprimirAntenasNefastos(const char *nomeFicheiro, RedeAntenas *h);
+
+GrelhaEsparsa *criarGrelha(LimitesMapa limites);
+
+void libertarGrelha(GrelhaEsparsa *g);
+
+bool dentroGrelha(const GrelhaEsparsa *g, int x, int y);
+
+char obterCelula(const GrelhaEsparsa *g, int x, int y);
+
+bool definirCelula(GrelhaEsparsa *g, int x, int y, char valor);
+
+bool percorrerGrelha(const GrelhaEsparsa *g, void (*visitar)(int x, int y, char valor, void *dados), void *dados);
+
+GrelhaEsparsa *carregarGrelha(char *nomeFicheiro);
+
+GrelhaEsparsa *grelhaDeAntenas(Antena *h, LimitesMapa limites);
+
+GrelhaEsparsa *grelhaDeEfeitos(RedeAntenas *h, LimitesMapa limites);
+
+GrelhaEsparsa *calcularEfeitosGrelha(Antena *h, LimitesMapa limites);
+
+bool imprimirGrelha(FILE *f, const GrelhaEsparsa *antenas, const GrelhaEsparsa *efeitos);
+
+bool gravarGrelha(char *nomeFicheiro, const GrelhaEsparsa *g);
+
+GrelhaEsparsa *carregarGrelhaBinario(char *nomeFicheiro);
+
+bool compararGrelhas(const GrelhaEsparsa *antiga, const GrelhaEsparsa *nova, DiferencasMapa *dif);
+
+bool compararMapas(char *ficheiroAntigo, char *ficheiroNovo, DiferencasMapa *dif);
+
+bool iniciarEstadoDiferencas(EstadoDiferencas *e, char *nomeFicheiro);
+
+bool compararVersaoSeguinte(EstadoDiferencas *e, char *nomeFicheiro, DiferencasMapa *dif);
+
+void libertarEstadoDiferencas(EstadoDiferencas *e);
+
+bool imprimirDiferencas(const DiferencasMapa *dif);
+
+void libertarDiferencas(DiferencasMapa *dif);
+
+VigiaMapa *criarVigia(char *nomeFicheiro);
+
+int atualizarVigia(VigiaMapa *v);
+
+bool esperarAlteracaoMapa(VigiaMapa *v, int tempoLimite);
+
+bool vigiarMapa(VigiaMapa *v, bool (*aoAlterar)(VigiaMapa *v, int linhasAlteradas, void *dados), void *dados);
+
+void libertarVigia(VigiaMapa *v);
+
+DiarioAntenas *abrirDiario(char *nomeInstantaneo, char *nomeDiario, Antena **lista);
+
+bool diarioInserir(DiarioAntenas *d, Antena **lista, char freq, int x, int y);
+
+bool diarioRemover(DiarioAntenas *d, Antena **lista, int x, int y);
+
+bool confirmarDiario(DiarioAntenas *d);
+
+bool confirmarDiarioVencido(DiarioAntenas *d);
+
+bool compactarDiario(DiarioAntenas *d, Antena *lista);
+
+bool fecharDiario(DiarioAntenas *d, Antena *lista);
+
+TabelaSomas *criarTabelaSomas(Antena *h, RedeAntenas *efeitos, LimitesMapa limites);
+
+uint32_t contarAntenasRetangulo(const TabelaSomas *t, char freq, int x0, int y0, int x1, int y1);
+
+uint32_t contarEfeitosRetangulo(const TabelaSomas *t, int x0, int y0, int x1, int y1);
+
+bool registarAntenaSomas(TabelaSomas *t, char freq, int x, int y, int delta);
+
+bool registarEfeitoSomas(TabelaSomas *t, int x, int y, int delta);
+
+bool aplicarAlteracoesSomas(TabelaSomas *t);
+
+void libertarTabelaSomas(TabelaSomas *t);
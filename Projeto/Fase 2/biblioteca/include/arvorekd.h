@@ -0,0 +1,73 @@
+/**
+ * @file arvorekd.h
+ * @brief Árvore k-d estática sobre as antenas, para consultas de vizinhos mais próximos e por raio.
+ * @author David Costa (a24609@alunos.ipca.pt)
+ *
+ * As antenas de cada frequência formam uma árvore própria, guardada de forma implícita num
+ * intervalo contíguo do vetor de nós: a raiz do intervalo [i, f) é o nó do meio, e as subárvores
+ * esquerda e direita são as metades à sua esquerda e à sua direita. Não há ponteiros entre nós.
+ */
+
+#ifndef ARVOREKD_H
+#define ARVOREKD_H
+
+#include "struct.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/// Número de frequências possíveis (indexadas pelo código do caracter).
+#define FREQUENCIAS_KD 128
+
+/**
+ * @brief Nó da árvore: coordenadas e antena original.
+ */
+typedef struct NoKD {
+    Coordenada x, y;
+    Antena *antena;
+} NoKD;
+
+/**
+ * @brief Árvores k-d de todas as frequências, lado a lado no mesmo vetor.
+ *
+ * Os nós da frequência f estão entre inicioFrequencia[f] e inicioFrequencia[f+1]-1.
+ */
+typedef struct ArvoreKD {
+    int numNos;
+    NoKD *nos;
+    int inicioFrequencia[FREQUENCIAS_KD + 1];
+} ArvoreKD;
+
+/**
+ * @brief Resultado de uma consulta: nó encontrado e quadrado da distância euclidiana.
+ *
+ * O quadrado é calculado em double, exato enquanto for menor do que 2^53; as posições consultadas
+ * devem estar entre -COORDENADA_MAX e COORDENADA_MAX, como as antenas.
+ */
+typedef struct VizinhoKD {
+    int no;                 ///< Índice em ArvoreKD::nos
+    double distancia2;
+} VizinhoKD;
+
+/**
+ * @brief Consulta de um lote: posição e frequência (0 para qualquer frequência).
+ */
+typedef struct ConsultaKD {
+    char frequencia;
+    Coordenada x, y;
+} ConsultaKD;
+
+/// @name Construção
+///@{
+ArvoreKD* CriarArvoreKD(TipoAntena* listaTipos);
+void LiberarArvoreKD(ArvoreKD* a);
+///@}
+
+/// @name Consultas
+///@{
+int VizinhosMaisProximos(const ArvoreKD* a, char frequencia, Coordenada x, Coordenada y, int k, bool excluirPosicao, VizinhoKD* resultado);
+size_t AntenasNoRaio(const ArvoreKD* a, char frequencia, Coordenada x, Coordenada y, Coordenada raio, VizinhoKD* resultado, size_t maximo);
+bool VizinhosMaisProximosLote(const ArvoreKD* a, const ConsultaKD* consultas, int numConsultas, int k,
+                              bool excluirPosicao, VizinhoKD* resultados, int* quantidades, int numThreads);
+///@}
+
+#endif // ARVOREKD_H
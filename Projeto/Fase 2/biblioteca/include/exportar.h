@@ -0,0 +1,93 @@
+/**
+ * @file exportar.h
+ * @brief Exportação em bloco de antenas, efeitos nefastos, adjacências e percursos (CSV, NDJSON e binário).
+ * @author David Costa (a24609@alunos.ipca.pt)
+ *
+ * Todo o texto é formatado à mão para um buffer grande, reutilizável entre exportações, que só é
+ * enviado ao descritor de ficheiro quando enche. Assim uma exportação grande resulta em poucas
+ * chamadas a write, em vez de uma chamada a printf por nodo.
+ */
+
+#ifndef EXPORTAR_H
+#define EXPORTAR_H
+
+#include "struct.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Capacidade por omissão do buffer de saída (1 MiB).
+#define TAMANHO_BUFFER_SAIDA (1u << 20)
+
+/// Identificação dos ficheiros no formato binário. Os ficheiros "ANTC", da versão anterior, tinham
+/// coordenadas int32: a identificação mudou para que os leitores antigos os rejeitem em vez de os lerem mal.
+#define MAGIA_BINARIO "ANT2"
+/// Bytes de cada coordenada no formato binário.
+#define BYTES_COORDENADA 8
+
+/**
+ * @brief Formatos de exportação.
+ *
+ * FORMATO_BINARIO é colunar: um CabecalhoBinario seguido de cada coluna inteira, pela ordem
+ * indicada em TipoRegisto. As colunas de coordenadas são int64 e a de frequências uint8,
+ * sempre em little-endian.
+ */
+typedef enum FormatoExportacao {
+    FORMATO_CSV,
+    FORMATO_NDJSON,
+    FORMATO_BINARIO
+} FormatoExportacao;
+
+/**
+ * @brief Conteúdo de uma exportação, com as respetivas colunas.
+ */
+typedef enum TipoRegisto {
+    REGISTO_ANTENAS = 1,       ///< frequencia, x, y
+    REGISTO_EFEITOS = 2,       ///< x, y
+    REGISTO_ADJACENCIAS = 3,   ///< x, y (origem), x2, y2 (destino)
+    REGISTO_PERCURSO = 4       ///< x, y, pela ordem de visita
+} TipoRegisto;
+
+/**
+ * @brief Cabeçalho do formato binário (16 bytes).
+ */
+typedef struct CabecalhoBinario {
+    char magia[4];             ///< MAGIA_BINARIO
+    uint8_t registo;           ///< Valor de TipoRegisto
+    uint8_t numColunas;
+    uint8_t bytesCoordenada;   ///< BYTES_COORDENADA
+    uint8_t reservado;
+    uint64_t numLinhas;        ///< Número de valores em cada coluna
+} CabecalhoBinario;
+
+/**
+ * @brief Buffer de saída associado a um descritor de ficheiro.
+ *
+ * Depois de um erro de escrita, as escritas seguintes são ignoradas e `erro` fica a true.
+ */
+typedef struct BufferSaida {
+    int fd;
+    char *dados;
+    size_t usados;
+    size_t capacidade;
+    bool erro;
+} BufferSaida;
+
+/// @name Buffer de saída
+///@{
+bool IniciarBufferSaida(BufferSaida* b, int fd, size_t capacidade);
+bool DescarregarBuffer(BufferSaida* b);
+bool TerminarBufferSaida(BufferSaida* b);
+void EscreverBytes(BufferSaida* b, const void* dados, size_t n);
+void EscreverInteiro(BufferSaida* b, long long valor);
+///@}
+
+/// @name Exportação
+///@{
+bool ExportarAntenas(BufferSaida* b, TipoAntena* listaTipos, FormatoExportacao formato);
+bool ExportarEfeitos(BufferSaida* b, const EfeitoNefasto* lista, FormatoExportacao formato);
+bool ExportarAdjacencias(BufferSaida* b, TipoAntena* listaTipos, FormatoExportacao formato);
+bool ExportarPercurso(BufferSaida* b, const ResultadoDFS* lista, FormatoExportacao formato);
+///@}
+
+#endif // EXPORTAR_H
@@ -11,25 +11,41 @@
 #define FUNCOES_H
 
 #include "struct.h"
+#include "tabela.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Posições com efeito nefasto a acumular, sem repetições.
+ *
+ * Usa um mapa de bits da matriz quando este é mais pequeno do que o conjunto esparso esperado;
+ * caso contrário (matriz grande ou sem limites), um conjunto de coordenadas que cresce com os efeitos.
+ */
+typedef struct AcumuladorEfeitos {
+    Coordenada maxLin, maxCol;      ///< Limites da matriz (sem limites se algum for <= 0)
+    uint64_t *mapa;                 ///< Mapa de bits da matriz, ou NULL se for usado o conjunto
+    ConjuntoCoordenadas conjunto;
+} AcumuladorEfeitos;
 
 /// @name Criação e inserção de antenas
 ///@{
-Antena* CriarAntena(char frequencia, int x, int y);
+Antena* CriarAntena(char frequencia, Coordenada x, Coordenada y);
 Antena* InserirAntena(Antena* lista, Antena* novaAntena);
 ///@}
 
 /// @name Adjacências
 ///@{
-Adjacente* CriarAdjacente(int x, int y);
+Adjacente* CriarAdjacente(Coordenada x, Coordenada y);
 bool InserirAdjacente(Adjacente** lista, Adjacente* novo);
-bool AdicionarAdjacenteAntena(Antena* antena, int x, int y);
+bool AdicionarAdjacenteAntena(Antena* antena, Coordenada x, Coordenada y);
 ///@}
 
 /// @name Interligação de antenas
 ///@{
 Antena* InterligarTodasAntenasMesmoTipo(Antena* lista);
 bool InterligarAntenasTipo(TipoAntena* listaTipos);
+bool InterligarAntenasMesmoTipo(TipoAntena* listaTipos);
 ///@}
 
 /// @name Manipulação de tipos de antenas
@@ -38,21 +54,53 @@ TipoAntena* CriarTipoAntena(char tipo);
 TipoAntena* InserirTipoAntena(TipoAntena* lista, TipoAntena* novo);
 TipoAntena* ProcurarTipo(TipoAntena* lista, char tipo);
 TipoAntena* AdicionarAntenaTipo(TipoAntena* listaTipos, char tipo, Antena* novaAntena);
+TipoAntena* AdicionarTipoAntena(TipoAntena* lista, char tipo);
+TipoAntena* InserirAntenaEmTipo(TipoAntena* listaTipos, char tipo, Antena* novaAntena);
+Antena* ProcurarAntenaPorCoordenadas(TipoAntena* listaTipos, Coordenada x, Coordenada y);
+///@}
+
+/// @name Carregamento e edição da rede
+///@{
+TipoAntena* CarregarAntenasFicheiro(const char* nomeFicheiro, Coordenada* maxLin, Coordenada* maxCol);
+TipoAntena* CarregarRegiaoFicheiro(TipoAntena* listaTipos, const char* nomeFicheiro, Coordenada origemX, Coordenada origemY,
+                                   Coordenada* maxLin, Coordenada* maxCol, bool* res);
+TipoAntena* InserirAntenaRede(TipoAntena* listaTipos, char frequencia, Coordenada x, Coordenada y, bool* res);
+TipoAntena* RemoverAntenaRede(TipoAntena* listaTipos, Coordenada x, Coordenada y, bool* res);
+///@}
+
+/// @name Efeitos nefastos
+///@{
+EfeitoNefasto* CalcularEfeitosNefastos(TipoAntena* listaTipos, Coordenada maxLin, Coordenada maxCol);
+bool IniciarAcumuladorEfeitos(AcumuladorEfeitos* a, Coordenada maxLin, Coordenada maxCol, size_t numPares);
+bool AcumularEfeitosPar(AcumuladorEfeitos* a, Coordenada x1, Coordenada y1, Coordenada x2, Coordenada y2);
+EfeitoNefasto* ListaEfeitosAcumulados(const AcumuladorEfeitos* a);
+void LiberarAcumuladorEfeitos(AcumuladorEfeitos* a);
 ///@}
 
 /// @name Algoritmos de grafos
 ///@{
-ResultadoDFS* DFS(Antena* inicio, TipoAntena* listaTipos, int maxLin, int maxCol);
-ResultadoDFS* BFS(Antena* inicio, TipoAntena* listaTipos, int maxLin, int maxCol);
+ResultadoDFS* BuscaEmProfundidade(TipoAntena* listaTipos, Coordenada x_inicial, Coordenada y_inicial, Coordenada max_x, Coordenada max_y);
+ResultadoDFS* BuscaEmLargura(TipoAntena* listaTipos, Coordenada x_inicial, Coordenada y_inicial, Coordenada max_x, Coordenada max_y);
+bool ExisteCaminho(TipoAntena* listaTipos, Coordenada xOrigem, Coordenada yOrigem, Coordenada xDestino, Coordenada yDestino,
+                   Coordenada max_x, Coordenada max_y);
 bool ExisteCaminhoEntreAntenas(Antena* origem, Antena* destino);
 bool CaminhoDFS(Antena* atual, Antena* destino, bool* visitado, bool* caminhoEncontrado);
 ///@}
 
 /// @name Verificações
 ///@{
-bool AntenaExiste(Antena* lista, int x, int y);
+bool AntenaExiste(Antena* lista, Coordenada x, Coordenada y);
 bool VerificarInterferencia(Antena* novaAntena, Antena* lista);
 bool VerificarEfeitosNefastos(Antena* novaAntena, Antena* lista);
 ///@}
 
+/// @name Libertação de memória
+///@{
+bool LiberarAdjacentes(Adjacente* lista);
+bool LiberarAntenas(Antena* lista);
+bool LiberarTiposAntenas(TipoAntena* lista);
+bool LiberarResultados(ResultadoDFS* lista);
+bool LiberarEfeitos(EfeitoNefasto* lista);
+///@}
+
 #endif // FUNCOES_H
@@ -0,0 +1,178 @@
+/**
+ * @file grafo.h
+ * @brief Representação plana (CSR) do grafo de antenas e algoritmos que trabalham sobre ela.
+ * @author David Costa (a24609@alunos.ipca.pt)
+ *
+ * As antenas são numeradas de 0 a numVertices-1 e os adjacentes de cada uma ficam contíguos num
+ * único vetor, já resolvidos para índices. Assim as buscas deixam de procurar coordenadas por cada aresta.
+ */
+
+#ifndef GRAFO_H
+#define GRAFO_H
+
+#include "struct.h"
+#include "tabela.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Grafo em formato CSR (compressed sparse row).
+ *
+ * Os adjacentes do vértice v são adjacentes[inicioAdj[v]] .. adjacentes[inicioAdj[v+1]-1].
+ */
+typedef struct GrafoPlano {
+    int numVertices;
+    size_t numArestas;      ///< Número de arcos (cada ligação entre duas antenas conta duas vezes)
+    size_t *inicioAdj;      ///< numVertices+1 posições
+    int *adjacentes;        ///< Índice do vértice de destino de cada arco
+    Coordenada *x, *y;      ///< Coordenadas de cada vértice
+    char *frequencia;       ///< Frequência de cada vértice
+    Antena **antenas;       ///< Antena original de cada vértice
+    TabelaCoordenadas indice;   ///< Coordenadas -> índice do vértice
+} GrafoPlano;
+
+/**
+ * @brief Grafo implícito: as antenas de cada tipo formam um grupo em que todas estão interligadas.
+ *
+ * Não guarda arestas. Os vizinhos de um vértice são os restantes vértices do seu tipo, que ocupam
+ * posições contíguas: os do tipo t estão entre inicioTipo[t] e inicioTipo[t+1]-1.
+ */
+typedef struct GrafoImplicito {
+    int numVertices;
+    int numTipos;
+    int *inicioTipo;        ///< numTipos+1 posições
+    int *tipoVertice;       ///< Tipo (índice em inicioTipo) de cada vértice
+    Coordenada *x, *y;
+    char *frequencia;
+    Antena **antenas;
+    TabelaCoordenadas indice;
+} GrafoImplicito;
+
+/**
+ * @brief Ligação escolhida para a árvore de cobertura mínima.
+ *
+ * O peso é a distância euclidiana entre as antenas; as ligações são comparadas pelo seu quadrado,
+ * que dá a mesma ordem.
+ */
+typedef struct ArestaArvore {
+    int origem, destino;        ///< Índices dos vértices no grafo usado
+    double distancia2;          ///< Quadrado da distância entre as duas antenas (exato até 2^53)
+} ArestaArvore;
+
+/**
+ * @brief Árvore (ou floresta, se o grafo não for conexo) de cobertura mínima.
+ */
+typedef struct ArvoreCobertura {
+    int numArestas;
+    ArestaArvore *arestas;      ///< Pela ordem em que foram escolhidas
+    double custo;               ///< Soma das distâncias euclidianas das ligações escolhidas
+} ArvoreCobertura;
+
+/**
+ * @brief Ligação entre dois vértices do grafo plano.
+ */
+typedef struct LigacaoGrafo {
+    int origem, destino;
+} LigacaoGrafo;
+
+/**
+ * @brief Pontos únicos de falha da rede: pontos de articulação, pontes e componentes biconexas.
+ *
+ * As ligações da componente biconexa c são ligacoesComponente[inicioComponente[c]] ..
+ * ligacoesComponente[inicioComponente[c+1]-1]; cada ligação aparece numa única componente.
+ */
+typedef struct ResultadoResiliencia {
+    int numArticulacoes;
+    int *articulacoes;              ///< Vértices cuja remoção desliga a sua componente
+    int numPontes;
+    LigacaoGrafo *pontes;           ///< Ligações cuja remoção desliga a sua componente
+    int numComponentes;
+    int *inicioComponente;          ///< numComponentes+1 posições
+    LigacaoGrafo *ligacoesComponente;
+} ResultadoResiliencia;
+
+/**
+ * @brief Matriz de distâncias em saltos entre todos os pares de vértices, por linhas (origem, destino).
+ *
+ * Cada distância ocupa bytesPorDistancia bytes (uint8_t ou uint16_t). O maior valor representável
+ * indica que o destino não é alcançável; as distâncias que não cabem ficam com o valor anterior a esse.
+ */
+typedef struct MatrizSaltos {
+    int numVertices;
+    int bytesPorDistancia;      ///< 1 ou 2
+    void *distancias;
+    size_t tamanho;             ///< Bytes ocupados pela matriz
+    bool mapeada;               ///< true se a matriz está mapeada num ficheiro (mmap)
+} MatrizSaltos;
+
+/**
+ * @brief Tempos medidos por MedirReordenacaoMorton, em segundos.
+ */
+typedef struct TemposReordenacao {
+    int buscas;                 ///< Número de BFS feitas em cada grafo
+    double original;            ///< Total das BFS sobre o grafo pela ordem das listas
+    double reordenacao;         ///< Tempo de ReordenarMortonPlano
+    double reordenado;          ///< Total das mesmas BFS sobre o grafo reordenado
+} TemposReordenacao;
+
+/// @name Grafo plano
+///@{
+GrafoPlano* CriarGrafoPlano(TipoAntena* listaTipos);
+int ProcurarVertice(const GrafoPlano* g, Coordenada x, Coordenada y);
+void LiberarGrafoPlano(GrafoPlano* g);
+///@}
+
+/// @name Buscas sobre o grafo plano
+///@{
+bool BuscaEmLarguraParalela(const GrafoPlano* g, int origem, int numThreads, int* nivel, int* pai);
+///@}
+
+/// @name Grafo implícito (grupos de antenas do mesmo tipo)
+///@{
+GrafoImplicito* CriarGrafoImplicito(TipoAntena* listaTipos);
+int ProcurarVerticeImplicito(const GrafoImplicito* g, Coordenada x, Coordenada y);
+int ComponenteImplicita(const GrafoImplicito* g, int v);
+int ContarComponentesImplicitas(const GrafoImplicito* g);
+bool ExisteCaminhoImplicito(const GrafoImplicito* g, int origem, int destino);
+int OrdemVisitaImplicita(const GrafoImplicito* g, int origem, int* ordem);
+ResultadoDFS* BuscaEmProfundidadeImplicita(const GrafoImplicito* g, Coordenada x, Coordenada y);
+ResultadoDFS* BuscaEmLarguraImplicita(const GrafoImplicito* g, Coordenada x, Coordenada y);
+EfeitoNefasto* CalcularEfeitosImplicitos(const GrafoImplicito* g, Coordenada maxLin, Coordenada maxCol);
+void LiberarGrafoImplicito(GrafoImplicito* g);
+///@}
+
+/// @name Árvore de cobertura mínima
+///@{
+bool ArvoreMinimaKruskal(const GrafoPlano* g, int numThreads, ArvoreCobertura* arvore);
+bool ArvoreMinimaPrim(const GrafoImplicito* g, bool porTipo, ArvoreCobertura* arvore);
+void LiberarArvoreCobertura(ArvoreCobertura* arvore);
+///@}
+
+/// @name Resiliência (pontos de articulação, pontes e componentes biconexas)
+///@{
+bool AnalisarResiliencia(const GrafoPlano* g, ResultadoResiliencia* r);
+void LiberarResultadoResiliencia(ResultadoResiliencia* r);
+///@}
+
+/// @name Centralidade de intermediação
+///@{
+bool CentralidadeIntermediacao(const GrafoPlano* g, bool ponderado, int numThreads, int amostras,
+                               uint64_t semente, double* centralidade);
+///@}
+
+/// @name Distâncias em saltos entre todos os pares
+///@{
+bool CalcularMatrizSaltos(const GrafoPlano* g, int bytesPorDistancia, const char* nomeFicheiro, int numThreads, MatrizSaltos* m);
+unsigned DistanciaSaltos(const MatrizSaltos* m, int origem, int destino);
+void LiberarMatrizSaltos(MatrizSaltos* m);
+///@}
+
+/// @name Reordenação espacial (curva de Morton)
+///@{
+bool ReordenarMortonPlano(GrafoPlano* g, int numThreads);
+bool ReordenarMortonImplicito(GrafoImplicito* g, int numThreads);
+bool MedirReordenacaoMorton(TipoAntena* listaTipos, int buscas, int numThreads, TemposReordenacao* t);
+///@}
+
+#endif // GRAFO_H
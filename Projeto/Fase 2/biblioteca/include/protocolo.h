@@ -0,0 +1,91 @@
+/**
+ * @file protocolo.h
+ * @brief Protocolo binário do serviço de consultas à rede de antenas.
+ * @author David Costa (a24609@alunos.ipca.pt)
+ *
+ * Ao ligar, o cliente envia uma SaudacaoBinaria com a versão do protocolo que fala; o serviço responde
+ * com a sua e, se forem diferentes, fecha a ligação. Um cliente de outra versão recebe assim um erro
+ * claro em vez de desalinhar a leitura dos pedidos.
+ *
+ * Depois, o cliente envia lotes de pedidos pelo socket Unix local: um uint32_t com o número de pedidos
+ * seguido de outros tantos PedidoBinario. O serviço responde ao lote inteiro de uma só vez, com
+ * uma RespostaBinaria por pedido, cada uma seguida de `quantidade` CoordenadaBinaria.
+ * Todos os campos estão na ordem de bytes da máquina, porque cliente e serviço correm no mesmo sistema.
+ */
+
+#ifndef PROTOCOLO_H
+#define PROTOCOLO_H
+
+#include <stdint.h>
+
+/// Número máximo de pedidos aceites num único lote.
+#define MAX_PEDIDOS_LOTE 4096
+
+/// Identificação do protocolo na saudação.
+#define MAGIA_PROTOCOLO "ANTP"
+/// Versão atual do protocolo. A versão 2 passou as coordenadas de int32 para int64; a versão 1 não
+/// tinha saudação, por isso os seus clientes são recusados logo na primeira mensagem.
+#define VERSAO_PROTOCOLO 2
+
+/**
+ * @brief Saudação trocada no início de cada ligação (8 bytes).
+ */
+typedef struct SaudacaoBinaria {
+    char magia[4];             ///< MAGIA_PROTOCOLO
+    uint32_t versao;           ///< VERSAO_PROTOCOLO
+} SaudacaoBinaria;
+
+/**
+ * @brief Operações suportadas pelo serviço.
+ */
+typedef enum OperacaoPedido {
+    OP_EFEITOS_NEFASTOS = 1,   ///< Posições com efeito nefasto (sem argumentos)
+    OP_ALCANCAVEL = 2,         ///< Existe caminho de (x, y) até (x2, y2)
+    OP_BUSCA_LARGURA = 3,      ///< Ordem de visita da BFS a partir de (x, y)
+    OP_BUSCA_PROFUNDIDADE = 4, ///< Ordem de visita da DFS a partir de (x, y)
+    OP_INSERIR = 5,            ///< Insere uma antena de `frequencia` em (x, y)
+    OP_REMOVER = 6             ///< Remove a antena em (x, y)
+} OperacaoPedido;
+
+/**
+ * @brief Estado de cada resposta.
+ */
+typedef enum EstadoResposta {
+    ESTADO_OK = 0,
+    ESTADO_NAO_ENCONTRADO = 1, ///< Não existe antena na posição indicada
+    ESTADO_INVALIDO = 2,       ///< Operação desconhecida, posição fora da matriz ou posição ocupada
+    ESTADO_NAO_SUPORTADO = 3,  ///< Reservado (as buscas já não têm limite de tamanho da matriz)
+    ESTADO_SEM_MEMORIA = 4
+} EstadoResposta;
+
+/**
+ * @brief Pedido de tamanho fixo (40 bytes).
+ */
+typedef struct PedidoBinario {
+    uint8_t operacao;          ///< Valor de OperacaoPedido
+    uint8_t frequencia;        ///< Frequência da antena (só OP_INSERIR)
+    uint16_t reservado;
+    uint32_t reservado2;       ///< Alinha as coordenadas a 8 bytes
+    int64_t x, y;              ///< Posição da antena
+    int64_t x2, y2;            ///< Posição de destino (só OP_ALCANCAVEL)
+} PedidoBinario;
+
+/**
+ * @brief Cabeçalho de cada resposta (8 bytes).
+ *
+ * Em OP_ALCANCAVEL, quantidade é 1 se existir caminho e 0 caso contrário, sem coordenadas a seguir.
+ */
+typedef struct RespostaBinaria {
+    uint8_t estado;            ///< Valor de EstadoResposta
+    uint8_t reservado[3];
+    uint32_t quantidade;       ///< Número de coordenadas que se seguem
+} RespostaBinaria;
+
+/**
+ * @brief Coordenada devolvida nas respostas (16 bytes).
+ */
+typedef struct CoordenadaBinaria {
+    int64_t x, y;
+} CoordenadaBinaria;
+
+#endif // PROTOCOLO_H
@@ -6,7 +6,21 @@
 #ifndef STRUCT_H
 #define STRUCT_H
 
+#include <stdint.h>
 
+/**
+ * @brief Coordenada de uma posição (linha ou coluna), em 64 bits.
+ *
+ * As posições podem ser negativas ou estar fora da matriz lida, por exemplo ao juntar várias
+ * regiões num único sistema de coordenadas global.
+ */
+typedef int64_t Coordenada;
+
+/// Maior valor absoluto aceite numa coordenada: garante que 2*a - b (efeitos nefastos) e a - b não transbordam.
+#define COORDENADA_MAX ((Coordenada)1 << 61)
+
+/// Verifica se uma coordenada está entre -COORDENADA_MAX e COORDENADA_MAX.
+#define COORDENADA_VALIDA(c) ((c) >= -COORDENADA_MAX && (c) <= COORDENADA_MAX)
 
 /**
  * @brief Estrutura que representa uma antena.
@@ -16,7 +30,7 @@
  */
 typedef struct Antena {
     char frequencia;
-    int x, y;
+    Coordenada x, y;
     struct Antena *proximo;
     struct Adjacente *adjacentes;
 } Antena;
@@ -38,8 +52,8 @@ typedef struct TipoAntena {
  * Usada para armazenar o resultado da busca em profundidade.
  */
 typedef struct ResultadoDFS {
-    int x;
-    int y;
+    Coordenada x;
+    Coordenada y;
     struct Antena *antena; 
     struct ResultadoDFS *proximo;
 } ResultadoDFS;
@@ -68,8 +82,8 @@ typedef struct {
  * @brief Estrutura para representar um caminho (sequência de coordenadas) entre antenas.
  */
 typedef struct Caminho {
-    int x;
-    int y;
+    Coordenada x;
+    Coordenada y;
     struct Caminho *proximo;
 } Caminho;
 
@@ -81,6 +95,15 @@ typedef struct ListaCaminhos {
     struct ListaCaminhos *proximo;
 } ListaCaminhos;
 
+/**
+ * @brief Lista ligada das posições da matriz com efeito nefasto.
+ */
+typedef struct EfeitoNefasto {
+    Coordenada x;
+    Coordenada y;
+    struct EfeitoNefasto *proximo;
+} EfeitoNefasto;
+
 #endif // STRUCT_H
 
 
@@ -93,7 +116,7 @@ typedef struct ListaCaminhos {
  * Contém as coordenadas da antena adjacente e um ponteiro para o próximo adjacente.
  */
 typedef struct Adjacente {
-    int x, y;
+    Coordenada x, y;
     struct Adjacente *proximo;
 } Adjacente;
 
@@ -0,0 +1,66 @@
+/**
+ * @file tabela.h
+ * @brief Tabela e conjunto de dispersão (endereçamento aberto) indexados por coordenadas de 64 bits.
+ * @author David Costa (a24609@alunos.ipca.pt)
+ *
+ * Servem de índice e de conjunto de visitados quando a matriz é demasiado grande (ou ilimitada) para
+ * ser reservada por inteiro: a memória cresce com o número de posições guardadas, não com a área.
+ */
+
+#ifndef TABELA_H
+#define TABELA_H
+
+#include "struct.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Tabela com sondagem linear de coordenadas (x, y) para valores de 64 bits.
+ *
+ * A capacidade é sempre uma potência de 2 e a tabela cresce quando passa de 70% de ocupação.
+ * As remoções deslocam os elementos seguintes, por isso não há marcas de remoção.
+ */
+typedef struct TabelaCoordenadas {
+    Coordenada *x, *y;
+    uint64_t *valores;
+    bool *ocupado;
+    size_t capacidade;
+    size_t tamanho;
+} TabelaCoordenadas;
+
+/**
+ * @brief Conjunto de coordenadas com sondagem linear, sem valores nem remoções (p. ex. posições visitadas).
+ *
+ * As posições ocupadas podem ser percorridas diretamente: x[i], y[i] para cada i com ocupado[i].
+ */
+typedef struct ConjuntoCoordenadas {
+    Coordenada *x, *y;
+    bool *ocupado;
+    size_t capacidade;
+    size_t tamanho;
+} ConjuntoCoordenadas;
+
+/// @name Dispersão
+///@{
+size_t Dispersar(Coordenada x, Coordenada y, size_t capacidade);
+///@}
+
+/// @name Tabela de coordenadas
+///@{
+bool IniciarTabela(TabelaCoordenadas* t, size_t capacidadeInicial);
+bool InserirTabela(TabelaCoordenadas* t, Coordenada x, Coordenada y, uint64_t valor);
+bool ProcurarTabela(const TabelaCoordenadas* t, Coordenada x, Coordenada y, uint64_t* valor);
+bool RemoverTabela(TabelaCoordenadas* t, Coordenada x, Coordenada y);
+void LiberarTabela(TabelaCoordenadas* t);
+///@}
+
+/// @name Conjunto de coordenadas
+///@{
+bool IniciarConjunto(ConjuntoCoordenadas* c, size_t capacidadeInicial);
+bool AdicionarConjunto(ConjuntoCoordenadas* c, Coordenada x, Coordenada y, bool* novo);
+bool ContemConjunto(const ConjuntoCoordenadas* c, Coordenada x, Coordenada y);
+void LiberarConjunto(ConjuntoCoordenadas* c);
+///@}
+
+#endif // TABELA_H
@@ -0,0 +1,161 @@
+/**
+ * @file versoes.h
+ * @brief Rede de antenas com versões imutáveis, para leituras concorrentes durante edições.
+ * @author David Costa (a24609@alunos.ipca.pt)
+ *
+ * Os escritores preparam uma nova versão copiando apenas os blocos que alteram (copy-on-write)
+ * e publicam-na de uma só vez. Os leitores fixam a versão atual sem trincos e nunca esperam pelos
+ * escritores. As versões antigas são libertadas por épocas, quando nenhum leitor as pode estar a usar.
+ */
+
+#ifndef VERSOES_H
+#define VERSOES_H
+
+#include "struct.h"
+#include "tabela.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Número de antenas guardadas em cada bloco.
+#define ANTENAS_POR_BLOCO 256
+/// Número máximo de leitores registados em simultâneo.
+#define MAX_LEITORES 64
+/// Número de tipos possíveis (indexados pelo código do caracter).
+#define NUM_TIPOS 128
+
+/**
+ * @brief Bloco de coordenadas das antenas de um tipo.
+ *
+ * `versao` é a versão que criou o bloco: enquanto essa versão não é publicada, o bloco ainda
+ * pode ser alterado no lugar.
+ */
+typedef struct BlocoAntenas {
+    uint64_t versao;
+    Coordenada x[ANTENAS_POR_BLOCO];
+    Coordenada y[ANTENAS_POR_BLOCO];
+} BlocoAntenas;
+
+/**
+ * @brief Antenas de um tipo numa versão: tabela de blocos, em que só o último pode estar incompleto.
+ */
+typedef struct TipoVersao {
+    uint64_t versao;
+    char tipo;
+    size_t quantidade;
+    size_t numBlocos;
+    size_t capacidadeBlocos;
+    BlocoAntenas *blocos[];
+} TipoVersao;
+
+/// Número de posições em cada página da tabela de coordenadas de uma versão.
+#define POSICOES_POR_PAGINA 256
+
+/**
+ * @brief Página da tabela de coordenadas de uma versão: um troço contíguo das posições da sondagem.
+ *
+ * Tal como nos blocos de antenas, `versao` é a versão que criou a página.
+ */
+typedef struct PaginaPosicoes {
+    uint64_t versao;
+    Coordenada x[POSICOES_POR_PAGINA];
+    Coordenada y[POSICOES_POR_PAGINA];
+    uint64_t valores[POSICOES_POR_PAGINA];  ///< (tipo << 32) | índice da antena no tipo
+    bool ocupado[POSICOES_POR_PAGINA];
+} PaginaPosicoes;
+
+/**
+ * @brief Tabela de coordenadas de uma versão, com sondagem linear como a TabelaCoordenadas.
+ *
+ * As posições estão repartidas por páginas para que um escritor só copie as páginas que altera.
+ */
+typedef struct TabelaVersao {
+    uint64_t versao;
+    size_t capacidade;      ///< Número de posições (potência de 2, múltiplo de POSICOES_POR_PAGINA)
+    size_t tamanho;
+    size_t numPaginas;
+    PaginaPosicoes *paginas[];
+} TabelaVersao;
+
+/**
+ * @brief Versão imutável da rede, com as antenas particionadas por tipo.
+ *
+ * Como todas as antenas do mesmo tipo estão interligadas, os vizinhos de uma antena são as
+ * restantes antenas do seu tipo; a versão não precisa de guardar listas de adjacentes.
+ */
+typedef struct VersaoRede {
+    uint64_t numero;
+    size_t totalAntenas;
+    TipoVersao *tipos[NUM_TIPOS];
+    TabelaVersao *posicoes;         ///< Tipo e índice de cada antena, por coordenadas
+} VersaoRede;
+
+/**
+ * @brief Objeto substituído por uma versão, à espera de que nenhum leitor o possa usar.
+ */
+typedef struct ObjetoRetirado {
+    void *ponteiro;
+    uint64_t epoca;
+    struct ObjetoRetirado *proximo;
+} ObjetoRetirado;
+
+/// Tamanho de uma linha de cache.
+#define LINHA_CACHE 64
+
+/**
+ * @brief Registo de um leitor. Cada um fica numa linha de cache própria.
+ */
+typedef struct LeitorRede {
+    _Alignas(LINHA_CACHE) _Atomic uint64_t epoca;  ///< Época fixada, ou 0 se o leitor não está a ler
+    atomic_bool ocupado;
+    struct RedeVersionada *rede;
+} LeitorRede;
+
+/**
+ * @brief Rede versionada: versão publicada, leitores registados e estado dos escritores.
+ *
+ * Os leitores começam numa linha de cache nova, para não partilharem a linha de `atual` e `epoca`.
+ * Por isso a rede é reservada alinhada a LINHA_CACHE.
+ */
+typedef struct RedeVersionada {
+    _Atomic(VersaoRede *) atual;
+    _Atomic uint64_t epoca;
+    _Alignas(LINHA_CACHE) LeitorRede leitores[MAX_LEITORES];
+
+    pthread_mutex_t escrita;        ///< Serializa os escritores (os leitores nunca o usam)
+    VersaoRede *rascunho;           ///< Versão em preparação entre IniciarEdicao e PublicarEdicao
+    ObjetoRetirado *retiradosRascunho;
+    ObjetoRetirado *pendentes;      ///< Objetos retirados à espera de libertação
+} RedeVersionada;
+
+/// @name Criação e libertação
+///@{
+RedeVersionada* CriarRedeVersionada(TipoAntena* listaTipos);
+void LiberarRedeVersionada(RedeVersionada* rede);
+///@}
+
+/// @name Leitores
+///@{
+LeitorRede* RegistarLeitor(RedeVersionada* rede);
+const VersaoRede* FixarVersao(LeitorRede* leitor);
+void LibertarVersao(LeitorRede* leitor);
+void RemoverLeitor(LeitorRede* leitor);
+///@}
+
+/// @name Escritores
+///@{
+bool IniciarEdicao(RedeVersionada* rede);
+bool InserirAntenaVersao(RedeVersionada* rede, char frequencia, Coordenada x, Coordenada y);
+bool RemoverAntenaVersao(RedeVersionada* rede, Coordenada x, Coordenada y);
+void PublicarEdicao(RedeVersionada* rede);
+///@}
+
+/// @name Consultas sobre uma versão
+///@{
+bool ProcurarAntenaVersao(const VersaoRede* v, Coordenada x, Coordenada y, char* frequencia);
+EfeitoNefasto* CalcularEfeitosVersao(const VersaoRede* v, Coordenada maxLin, Coordenada maxCol);
+ResultadoDFS* BuscaEmLarguraVersao(const VersaoRede* v, Coordenada x, Coordenada y);
+///@}
+
+#endif // VERSOES_H
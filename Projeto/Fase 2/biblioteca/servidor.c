@@ -0,0 +1,487 @@
+/**
+ * @file servidor.c
+ * @author David Costa (a24609@alunos.ipca.pt)
+ * @brief Serviço residente que carrega a rede de antenas uma única vez e responde a consultas
+ * por um socket Unix local, usando o protocolo binário de protocolo.h.
+ *
+ * Utilização: servidor <ficheiro de antenas> <caminho do socket>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "struct.h"
+#include "funcoes.h"
+#include "grafo.h"
+#include "protocolo.h"
+
+#ifdef _WIN32
+
+int main(void) {
+    printf("O servico de consultas so esta disponivel em sistemas com sockets Unix.\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define MAX_CLIENTES 64
+/// Maior mensagem que um cliente pode enviar: um lote completo com o número de pedidos à frente.
+#define TAMANHO_MAX_LOTE (sizeof(uint32_t) + MAX_PEDIDOS_LOTE * sizeof(PedidoBinario))
+
+/**
+ * @brief Estado do serviço: a rede carregada, o grafo implícito e a cache dos efeitos nefastos.
+ *
+ * As consultas são respondidas a partir do grafo, que guarda as antenas em vetores por tipo e
+ * um índice por coordenadas. Cada inserção ou remoção invalida-o e a consulta seguinte reconstrói-o.
+ */
+typedef struct Servico {
+    TipoAntena *listaTipos;
+    Coordenada maxLin, maxCol;
+    GrafoImplicito *grafo;         ///< Grafo da rede atual, ou NULL se a rede mudou desde que foi criado
+    CoordenadaBinaria *efeitos;    ///< Efeitos já calculados (válidos enquanto efeitosValidos)
+    uint32_t numEfeitos;
+    bool efeitosValidos;
+} Servico;
+
+/**
+ * @brief Buffer de bytes que cresce à medida do necessário (pedidos recebidos ou respostas por enviar).
+ */
+typedef struct BufferResposta {
+    unsigned char *dados;
+    size_t tamanho, capacidade;
+} BufferResposta;
+
+/**
+ * @brief Estado de uma ligação.
+ *
+ * Os sockets dos clientes não bloqueiam: o que chega fica em `entrada` até formar uma mensagem
+ * completa, e as respostas ficam em `saida` até o cliente as aceitar. Um cliente lento ou que
+ * envia um lote aos bocados nunca faz esperar os restantes.
+ */
+typedef struct Cliente {
+    bool saudado;              ///< A saudação já foi trocada
+    bool recusado;             ///< Saudação de outra versão: fecha depois de enviar a resposta
+    bool fimEntrada;           ///< O cliente já não envia mais nada
+    BufferResposta entrada;
+    BufferResposta saida;
+    size_t enviados;           ///< Bytes de `saida` já enviados
+} Cliente;
+
+static volatile sig_atomic_t terminar = 0;
+
+static void PedirTerminar(int sinal) {
+    (void)sinal;
+    terminar = 1;
+}
+
+static bool Reservar(BufferResposta *b, size_t extra) {
+    if (b->tamanho + extra <= b->capacidade) return true;
+
+    size_t nova = b->capacidade ? b->capacidade : 4096;
+    while (nova < b->tamanho + extra) nova *= 2;
+
+    unsigned char *dados = (unsigned char *)realloc(b->dados, nova);
+    if (!dados) return false;
+    b->dados = dados;
+    b->capacidade = nova;
+    return true;
+}
+
+static bool Acrescentar(BufferResposta *b, const void *dados, size_t n) {
+    if (!Reservar(b, n)) return false;
+    memcpy(b->dados + b->tamanho, dados, n);
+    b->tamanho += n;
+    return true;
+}
+
+/**
+ * @brief Escreve o cabeçalho de uma resposta seguido das coordenadas.
+ */
+static bool ResponderCoordenadas(BufferResposta *b, uint8_t estado, const CoordenadaBinaria *coords, uint32_t n) {
+    RespostaBinaria r = { estado, { 0, 0, 0 }, n };
+    return Acrescentar(b, &r, sizeof(r)) && (n == 0 || Acrescentar(b, coords, n * sizeof(CoordenadaBinaria)));
+}
+
+static bool ResponderEstado(BufferResposta *b, uint8_t estado, uint32_t quantidade) {
+    RespostaBinaria r = { estado, { 0, 0, 0 }, quantidade };
+    return Acrescentar(b, &r, sizeof(r));
+}
+
+/**
+ * @brief Responde com a ordem de visita de uma busca, escrevendo as coordenadas diretamente no buffer.
+ */
+static bool ResponderResultados(BufferResposta *b, ResultadoDFS *resultado) {
+    uint32_t n = 0;
+    for (ResultadoDFS *r = resultado; r; r = r->proximo) n++;
+
+    if (!ResponderEstado(b, ESTADO_OK, n)) return false;
+    for (ResultadoDFS *r = resultado; r; r = r->proximo) {
+        CoordenadaBinaria c = { r->x, r->y };
+        if (!Acrescentar(b, &c, sizeof(c))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reconstrói o grafo se a rede mudou desde que foi criado.
+ */
+static bool AtualizarGrafo(Servico *s) {
+    if (!s->grafo) s->grafo = CriarGrafoImplicito(s->listaTipos);
+    return s->grafo != NULL;
+}
+
+/**
+ * @brief A rede mudou: o grafo e os efeitos deixam de ser válidos.
+ */
+static void InvalidarRede(Servico *s) {
+    LiberarGrafoImplicito(s->grafo);
+    s->grafo = NULL;
+    s->efeitosValidos = false;
+}
+
+/**
+ * @brief Recalcula os efeitos nefastos se a rede mudou desde o último cálculo.
+ */
+static bool AtualizarEfeitos(Servico *s) {
+    if (s->efeitosValidos) return true;
+    if (!AtualizarGrafo(s)) return false;
+
+    EfeitoNefasto *lista = CalcularEfeitosImplicitos(s->grafo, s->maxLin, s->maxCol);
+    uint32_t n = 0;
+    for (EfeitoNefasto *e = lista; e; e = e->proximo) n++;
+
+    CoordenadaBinaria *efeitos = NULL;
+    if (n > 0) {
+        efeitos = (CoordenadaBinaria *)malloc(n * sizeof(CoordenadaBinaria));
+        if (!efeitos) {
+            LiberarEfeitos(lista);
+            return false;
+        }
+    }
+
+    uint32_t i = 0;
+    for (EfeitoNefasto *e = lista; e; e = e->proximo, i++) {
+        efeitos[i].x = e->x;
+        efeitos[i].y = e->y;
+    }
+    LiberarEfeitos(lista);
+
+    free(s->efeitos);
+    s->efeitos = efeitos;
+    s->numEfeitos = n;
+    s->efeitosValidos = true;
+    return true;
+}
+
+static bool DentroMatriz(const Servico *s, int64_t x, int64_t y) {
+    return x >= 0 && x < s->maxLin && y >= 0 && y < s->maxCol;
+}
+
+/**
+ * @brief Processa um pedido e acrescenta a resposta ao buffer.
+ *
+ * @return false apenas se faltou memória para a resposta.
+ */
+static bool ProcessarPedido(Servico *s, const PedidoBinario *p, BufferResposta *b) {
+    bool res;
+
+    switch (p->operacao) {
+    case OP_EFEITOS_NEFASTOS:
+        if (!AtualizarEfeitos(s)) return ResponderEstado(b, ESTADO_SEM_MEMORIA, 0);
+        return ResponderCoordenadas(b, ESTADO_OK, s->efeitos, s->numEfeitos);
+
+    case OP_ALCANCAVEL:
+    case OP_BUSCA_LARGURA:
+    case OP_BUSCA_PROFUNDIDADE: {
+        if (!AtualizarGrafo(s)) return ResponderEstado(b, ESTADO_SEM_MEMORIA, 0);
+
+        // Todas as antenas da rede estão dentro da matriz, por isso os limites não cortam nenhum caminho
+        int origem = ProcurarVerticeImplicito(s->grafo, p->x, p->y);
+        if (origem < 0) return ResponderEstado(b, ESTADO_NAO_ENCONTRADO, 0);
+
+        if (p->operacao == OP_ALCANCAVEL) {
+            res = ExisteCaminhoImplicito(s->grafo, origem, ProcurarVerticeImplicito(s->grafo, p->x2, p->y2));
+            return ResponderEstado(b, ESTADO_OK, res ? 1 : 0);
+        } else {
+            ResultadoDFS *resultado = (p->operacao == OP_BUSCA_LARGURA)
+                ? BuscaEmLarguraImplicita(s->grafo, p->x, p->y)
+                : BuscaEmProfundidadeImplicita(s->grafo, p->x, p->y);
+            if (!resultado) return ResponderEstado(b, ESTADO_SEM_MEMORIA, 0);
+            res = ResponderResultados(b, resultado);
+            LiberarResultados(resultado);
+            return res;
+        }
+    }
+
+    case OP_INSERIR:
+        if (!DentroMatriz(s, p->x, p->y) ||
+            !((p->frequencia >= 'A' && p->frequencia <= 'Z') || (p->frequencia >= 'a' && p->frequencia <= 'z')))
+            return ResponderEstado(b, ESTADO_INVALIDO, 0);
+
+        s->listaTipos = InserirAntenaRede(s->listaTipos, (char)p->frequencia, p->x, p->y, &res);
+        if (res) InvalidarRede(s);
+        return ResponderEstado(b, res ? ESTADO_OK : ESTADO_INVALIDO, 0);
+
+    case OP_REMOVER:
+        s->listaTipos = RemoverAntenaRede(s->listaTipos, p->x, p->y, &res);
+        if (res) InvalidarRede(s);
+        return ResponderEstado(b, res ? ESTADO_OK : ESTADO_NAO_ENCONTRADO, 0);
+
+    default:
+        return ResponderEstado(b, ESTADO_INVALIDO, 0);
+    }
+}
+
+/**
+ * @brief Envia o que o socket aceitar da saída pendente do cliente.
+ *
+ * @return false se a ligação falhou.
+ */
+static bool EnviarPendente(int fd, Cliente *c) {
+    while (c->enviados < c->saida.tamanho) {
+        ssize_t r = write(fd, c->saida.dados + c->enviados, c->saida.tamanho - c->enviados);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (r <= 0) return false;
+        c->enviados += (size_t)r;
+    }
+    c->saida.tamanho = 0;
+    c->enviados = 0;
+    return true;
+}
+
+/**
+ * @brief Lê o que estiver disponível no socket, sem passar do tamanho de um lote completo.
+ *
+ * @return 1 se leu alguma coisa (ou nada estava disponível), 0 se o cliente fechou a ligação, -1 em caso de erro.
+ */
+static int ReceberDisponivel(int fd, Cliente *c) {
+    while (c->entrada.tamanho < TAMANHO_MAX_LOTE) {
+        if (!Reservar(&c->entrada, 4096)) return -1;
+
+        size_t livre = c->entrada.capacidade - c->entrada.tamanho;
+        if (livre > TAMANHO_MAX_LOTE - c->entrada.tamanho) livre = TAMANHO_MAX_LOTE - c->entrada.tamanho;
+        ssize_t r = read(fd, c->entrada.dados + c->entrada.tamanho, livre);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+        if (r < 0) return -1;
+        if (r == 0) return 0;
+        c->entrada.tamanho += (size_t)r;
+    }
+    return 1;
+}
+
+/**
+ * @brief Retira os primeiros n bytes da entrada do cliente.
+ */
+static void Consumir(Cliente *c, size_t n) {
+    memmove(c->entrada.dados, c->entrada.dados + n, c->entrada.tamanho - n);
+    c->entrada.tamanho -= n;
+}
+
+/**
+ * @brief Responde à saudação de um cliente acabado de ligar.
+ *
+ * A resposta leva sempre a versão do serviço, para que um cliente de outra versão saiba porque é
+ * recusado; nesse caso a ligação fecha depois de a resposta seguir.
+ *
+ * @return false se faltou memória para a resposta.
+ */
+static bool Saudar(Cliente *c) {
+    SaudacaoBinaria pedida, propria;
+    memcpy(&pedida, c->entrada.dados, sizeof(pedida));
+    Consumir(c, sizeof(pedida));
+
+    memcpy(propria.magia, MAGIA_PROTOCOLO, 4);
+    propria.versao = VERSAO_PROTOCOLO;
+    if (memcmp(pedida.magia, MAGIA_PROTOCOLO, 4) != 0 || pedida.versao != VERSAO_PROTOCOLO) {
+        c->recusado = true;
+        c->entrada.tamanho = 0;
+    }
+    c->saudado = true;
+    return Acrescentar(&c->saida, &propria, sizeof(propria));
+}
+
+/**
+ * @brief Atende as mensagens completas que o cliente já enviou.
+ *
+ * Um lote só é processado depois de ter chegado inteiro; as respostas de cada lote seguem juntas.
+ * Enquanto houver respostas por enviar, os lotes seguintes ficam à espera na entrada.
+ *
+ * @return false se a ligação deve ser fechada.
+ */
+static bool AtenderMensagens(Servico *s, int fd, Cliente *c, PedidoBinario *pedidos) {
+    while (!c->recusado && c->saida.tamanho == 0) {
+        if (!c->saudado) {
+            if (c->entrada.tamanho < sizeof(SaudacaoBinaria)) return true;
+            if (!Saudar(c)) return false;
+        } else {
+            uint32_t n;
+            if (c->entrada.tamanho < sizeof(n)) return true;
+            memcpy(&n, c->entrada.dados, sizeof(n));
+            if (n > MAX_PEDIDOS_LOTE) return false;
+
+            size_t tamanho = sizeof(n) + n * sizeof(PedidoBinario);
+            if (c->entrada.tamanho < tamanho) return true;
+
+            // Copiados para um vetor alinhado: na entrada os pedidos podem não estar
+            memcpy(pedidos, c->entrada.dados + sizeof(n), n * sizeof(PedidoBinario));
+            Consumir(c, tamanho);
+            for (uint32_t i = 0; i < n; i++) {
+                if (!ProcessarPedido(s, &pedidos[i], &c->saida)) return false;
+            }
+        }
+        if (!EnviarPendente(fd, c)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Trata os eventos de uma ligação.
+ *
+ * @return false se a ligação deve ser fechada.
+ */
+static bool AtenderCliente(Servico *s, int fd, short eventos, Cliente *c, PedidoBinario *pedidos) {
+    if (eventos & (POLLERR | POLLNVAL)) return false;
+    if ((eventos & POLLOUT) && !EnviarPendente(fd, c)) return false;
+
+    if (eventos & POLLIN) {
+        int r = ReceberDisponivel(fd, c);
+        if (r < 0) return false;
+        if (r == 0) c->fimEntrada = true; // Ainda se responde aos lotes que chegaram completos
+    } else if (eventos & POLLHUP) {
+        return false;
+    }
+
+    if (!AtenderMensagens(s, fd, c, pedidos)) return false;
+    return !((c->recusado || c->fimEntrada) && c->saida.tamanho == 0);
+}
+
+/**
+ * @brief Eventos a esperar de um cliente: só se lê quando não há respostas por enviar.
+ */
+static short EventosCliente(const Cliente *c) {
+    if (c->saida.tamanho > 0) return POLLOUT;
+    if (c->recusado || c->fimEntrada || c->entrada.tamanho >= TAMANHO_MAX_LOTE) return 0;
+    return POLLIN;
+}
+
+static int CriarSocket(const char *caminho) {
+    struct sockaddr_un endereco;
+    if (strlen(caminho) >= sizeof(endereco.sun_path)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    strcpy(endereco.sun_path, caminho);
+    unlink(caminho);
+
+    if (bind(fd, (struct sockaddr *)&endereco, sizeof(endereco)) < 0 || listen(fd, 16) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        printf("Utilizacao: %s <ficheiro de antenas> <caminho do socket>\n", argv[0]);
+        return 1;
+    }
+
+    Servico s = { NULL, 0, 0, NULL, NULL, 0, false };
+    s.listaTipos = CarregarAntenasFicheiro(argv[1], &s.maxLin, &s.maxCol);
+    if (!s.listaTipos) {
+        printf("Erro ao carregar antenas do ficheiro.\n");
+        return 1;
+    }
+    InterligarAntenasMesmoTipo(s.listaTipos);
+
+    PedidoBinario *pedidos = (PedidoBinario *)malloc(MAX_PEDIDOS_LOTE * sizeof(PedidoBinario));
+    if (!pedidos) {
+        printf("Erro ao reservar memoria para os pedidos.\n");
+        LiberarTiposAntenas(s.listaTipos);
+        return 1;
+    }
+
+    int servidor = CriarSocket(argv[2]);
+    if (servidor < 0) {
+        printf("Erro ao criar o socket %s.\n", argv[2]);
+        free(pedidos);
+        LiberarTiposAntenas(s.listaTipos);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, PedirTerminar);
+    signal(SIGTERM, PedirTerminar);
+
+    struct pollfd fds[MAX_CLIENTES + 1];
+    Cliente clientes[MAX_CLIENTES + 1];    // clientes[i] é o da ligação fds[i] (a posição 0 é o servidor)
+    int numFds = 1;
+
+    fds[0].fd = servidor;
+    fds[0].events = POLLIN;
+
+    printf("Rede carregada (%lld x %lld). A aguardar pedidos em %s\n", (long long)s.maxLin, (long long)s.maxCol, argv[2]);
+
+    // Um único fio de execução atende todos os clientes, por isso a rede nunca é acedida em concorrência
+    while (!terminar) {
+        for (int i = 1; i < numFds; i++) fds[i].events = EventosCliente(&clientes[i]);
+
+        if (poll(fds, numFds, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = numFds - 1; i >= 1; i--) {
+            if (!fds[i].revents) continue;
+
+            if (!AtenderCliente(&s, fds[i].fd, fds[i].revents, &clientes[i], pedidos)) {
+                close(fds[i].fd);
+                free(clientes[i].entrada.dados);
+                free(clientes[i].saida.dados);
+                numFds--;
+                fds[i] = fds[numFds];
+                clientes[i] = clientes[numFds];
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int cliente = accept(servidor, NULL, NULL);
+            if (cliente >= 0 && numFds <= MAX_CLIENTES && fcntl(cliente, F_SETFL, fcntl(cliente, F_GETFL) | O_NONBLOCK) == 0) {
+                memset(&clientes[numFds], 0, sizeof(Cliente));
+                fds[numFds].fd = cliente;
+                fds[numFds].revents = 0;
+                numFds++;
+            } else if (cliente >= 0) {
+                close(cliente);
+            }
+        }
+    }
+
+    for (int i = 1; i < numFds; i++) {
+        close(fds[i].fd);
+        free(clientes[i].entrada.dados);
+        free(clientes[i].saida.dados);
+    }
+    close(servidor);
+    unlink(argv[2]);
+
+    free(pedidos);
+    free(s.efeitos);
+    LiberarGrafoImplicito(s.grafo);
+    LiberarTiposAntenas(s.listaTipos);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,359 @@
+/**
+ * @file arvorekd.c
+ * @author David Costa
+ * @brief Construção da árvore k-d implícita e consultas de vizinhos mais próximos e por raio.
+ */
+
+#include "arvorekd.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma region Construção
+
+/**
+ * @brief Coordenada usada para dividir os nós a uma dada profundidade (x nos níveis pares, y nos ímpares).
+ */
+static inline Coordenada CoordenadaKD(const NoKD *n, int eixo) {
+    return eixo ? n->y : n->x;
+}
+
+/**
+ * @brief Coloca em nos[alvo] o nó que lá ficaria se o intervalo estivesse ordenado pelo eixo,
+ * com os menores ou iguais à esquerda e os maiores ou iguais à direita (seleção rápida, O(n) esperado).
+ */
+static void SelecionarKD(NoKD *nos, int inicio, int fim, int alvo, int eixo) {
+    while (fim - inicio > 1) {
+        // Pivô: mediana de três, para intervalos já ordenados não caírem no pior caso
+        Coordenada a = CoordenadaKD(&nos[inicio], eixo);
+        Coordenada b = CoordenadaKD(&nos[inicio + (fim - inicio) / 2], eixo);
+        Coordenada c = CoordenadaKD(&nos[fim - 1], eixo);
+        Coordenada pivo = (a < b) ? ((b < c) ? b : (a < c ? c : a)) : ((a < c) ? a : (b < c ? c : b));
+
+        // Partição em três (menores, iguais, maiores): coordenadas repetidas não degradam a seleção
+        int menores = inicio, i = inicio, maiores = fim;
+        while (i < maiores) {
+            Coordenada v = CoordenadaKD(&nos[i], eixo);
+            NoKD troca;
+            if (v < pivo) {
+                troca = nos[i]; nos[i] = nos[menores]; nos[menores] = troca;
+                menores++;
+                i++;
+            } else if (v > pivo) {
+                maiores--;
+                troca = nos[i]; nos[i] = nos[maiores]; nos[maiores] = troca;
+            } else {
+                i++;
+            }
+        }
+
+        if (alvo < menores) fim = menores;
+        else if (alvo >= maiores) inicio = maiores;
+        else return;
+    }
+}
+
+/**
+ * @brief Organiza o intervalo [inicio, fim) como árvore implícita: mediana no meio e subárvores dos lados.
+ */
+static void ConstruirKD(NoKD *nos, int inicio, int fim, int eixo) {
+    while (fim - inicio > 1) {
+        int meio = inicio + (fim - inicio) / 2;
+        SelecionarKD(nos, inicio, fim, meio, eixo);
+        ConstruirKD(nos, inicio, meio, eixo ^ 1);
+        // A metade direita continua no ciclo, para a recursão só crescer com a profundidade da árvore
+        inicio = meio + 1;
+        eixo ^= 1;
+    }
+}
+
+/**
+ * @brief Constrói as árvores k-d de todas as frequências a partir da lista de tipos, em O(n log n).
+ *
+ * @param listaTipos Lista de tipos de antenas.
+ * @return ArvoreKD* Árvore criada, ou NULL em caso de erro.
+ */
+ArvoreKD *CriarArvoreKD(TipoAntena *listaTipos) {
+    ArvoreKD *a = (ArvoreKD *)calloc(1, sizeof(ArvoreKD));
+    if (!a) return NULL;
+
+    // Contagem por frequência, seguida da soma de prefixos para o início de cada intervalo
+    for (TipoAntena *t = listaTipos; t; t = t->proximo)
+        for (Antena *an = t->listaAntenas; an; an = an->proximo) {
+            a->inicioFrequencia[(unsigned char)an->frequencia % FREQUENCIAS_KD + 1]++;
+            a->numNos++;
+        }
+    for (int f = 0; f < FREQUENCIAS_KD; f++) a->inicioFrequencia[f + 1] += a->inicioFrequencia[f];
+
+    a->nos = (NoKD *)malloc(((size_t)a->numNos + 1) * sizeof(NoKD));
+    int *posicao = (int *)malloc(FREQUENCIAS_KD * sizeof(int));
+    if (!a->nos || !posicao) {
+        free(posicao);
+        LiberarArvoreKD(a);
+        return NULL;
+    }
+    memcpy(posicao, a->inicioFrequencia, FREQUENCIAS_KD * sizeof(int));
+
+    for (TipoAntena *t = listaTipos; t; t = t->proximo)
+        for (Antena *an = t->listaAntenas; an; an = an->proximo) {
+            NoKD *n = &a->nos[posicao[(unsigned char)an->frequencia % FREQUENCIAS_KD]++];
+            n->x = an->x;
+            n->y = an->y;
+            n->antena = an;
+        }
+    free(posicao);
+
+    for (int f = 0; f < FREQUENCIAS_KD; f++)
+        ConstruirKD(a->nos, a->inicioFrequencia[f], a->inicioFrequencia[f + 1], 0);
+    return a;
+}
+
+/**
+ * @brief Liberta a árvore (as antenas originais não são alteradas).
+ *
+ * @param a Árvore k-d.
+ */
+void LiberarArvoreKD(ArvoreKD *a) {
+    if (!a) return;
+    free(a->nos);
+    free(a);
+}
+
+#pragma endregion
+
+#pragma region Consultas
+
+/**
+ * @brief Estado de uma consulta dos k mais próximos: heap de máximo com os melhores encontrados.
+ */
+typedef struct ConsultaVizinhos {
+    const NoKD *nos;
+    Coordenada x, y;
+    bool excluirPosicao;
+    int k, tamanho;
+    VizinhoKD *heap;        ///< heap[0] é o pior dos k melhores
+} ConsultaVizinhos;
+
+static void AcrescentarVizinho(ConsultaVizinhos *c, int no, double d2) {
+    int i;
+    if (c->tamanho < c->k) {
+        // Sobe o novo elemento até ao seu lugar
+        i = c->tamanho++;
+        while (i > 0 && c->heap[(i - 1) / 2].distancia2 < d2) {
+            c->heap[i] = c->heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else {
+        if (d2 >= c->heap[0].distancia2) return;
+        // Substitui a raiz e desce-a até ao seu lugar
+        i = 0;
+        for (;;) {
+            int filho = 2 * i + 1;
+            if (filho >= c->k) break;
+            if (filho + 1 < c->k && c->heap[filho + 1].distancia2 > c->heap[filho].distancia2) filho++;
+            if (c->heap[filho].distancia2 <= d2) break;
+            c->heap[i] = c->heap[filho];
+            i = filho;
+        }
+    }
+    c->heap[i].no = no;
+    c->heap[i].distancia2 = d2;
+}
+
+/**
+ * @brief Desce primeiro pelo lado da posição consultada; o outro lado só é visitado se o plano
+ * de divisão estiver mais perto do que o pior dos k melhores.
+ */
+static void ProcurarVizinhosKD(ConsultaVizinhos *c, int inicio, int fim, int eixo) {
+    while (fim > inicio) {
+        int meio = inicio + (fim - inicio) / 2;
+        const NoKD *n = &c->nos[meio];
+        Coordenada dx = n->x - c->x, dy = n->y - c->y;
+        if (!(c->excluirPosicao && dx == 0 && dy == 0))
+            AcrescentarVizinho(c, meio, (double)dx * (double)dx + (double)dy * (double)dy);
+
+        double diferenca = (double)(eixo ? -dy : -dx);   // Posição consultada menos o plano
+        int perto0 = diferenca < 0 ? inicio : meio + 1, perto1 = diferenca < 0 ? meio : fim;
+        int longe0 = diferenca < 0 ? meio + 1 : inicio, longe1 = diferenca < 0 ? fim : meio;
+
+        ProcurarVizinhosKD(c, perto0, perto1, eixo ^ 1);
+        if (c->tamanho == c->k && diferenca * diferenca >= c->heap[0].distancia2) return;
+        inicio = longe0;
+        fim = longe1;
+        eixo ^= 1;
+    }
+}
+
+/**
+ * @brief Ordena os resultados por distância crescente (e pelo índice do nó, em caso de empate).
+ */
+static int CompararVizinhos(const void *a, const void *b) {
+    const VizinhoKD *va = (const VizinhoKD *)a, *vb = (const VizinhoKD *)b;
+    if (va->distancia2 != vb->distancia2) return va->distancia2 < vb->distancia2 ? -1 : 1;
+    return (va->no > vb->no) - (va->no < vb->no);
+}
+
+/**
+ * @brief Procura as k antenas mais próximas de (x, y).
+ *
+ * @param a Árvore k-d.
+ * @param frequencia Frequência das antenas procuradas, ou 0 para qualquer frequência.
+ * @param x Coordenada X da posição consultada.
+ * @param y Coordenada Y da posição consultada.
+ * @param k Número máximo de vizinhos.
+ * @param excluirPosicao Se true, ignora a antena que esteja exatamente em (x, y) (a própria antena consultada).
+ * @param resultado Recebe até k vizinhos, por distância crescente.
+ * @return int Número de vizinhos encontrados, ou -1 em caso de erro.
+ */
+int VizinhosMaisProximos(const ArvoreKD *a, char frequencia, Coordenada x, Coordenada y, int k, bool excluirPosicao, VizinhoKD *resultado) {
+    if (!a || !resultado || k < 0) return -1;
+    if (k == 0) return 0;
+
+    ConsultaVizinhos c = { a->nos, x, y, excluirPosicao, k, 0, resultado };
+    int primeira = frequencia ? (unsigned char)frequencia % FREQUENCIAS_KD : 0;
+    int ultima = frequencia ? primeira : FREQUENCIAS_KD - 1;
+    for (int f = primeira; f <= ultima; f++)
+        ProcurarVizinhosKD(&c, a->inicioFrequencia[f], a->inicioFrequencia[f + 1], 0);
+
+    qsort(resultado, (size_t)c.tamanho, sizeof(VizinhoKD), CompararVizinhos);
+    return c.tamanho;
+}
+
+/**
+ * @brief Estado de uma consulta por raio.
+ */
+typedef struct ConsultaRaio {
+    const NoKD *nos;
+    Coordenada x, y;
+    Coordenada raio;
+    double raio2;
+    VizinhoKD *resultado;
+    size_t maximo, encontrados;
+} ConsultaRaio;
+
+static void ProcurarRaioKD(ConsultaRaio *c, int inicio, int fim, int eixo) {
+    while (fim > inicio) {
+        int meio = inicio + (fim - inicio) / 2;
+        const NoKD *n = &c->nos[meio];
+        Coordenada dx = n->x - c->x, dy = n->y - c->y;
+        double d2 = (double)dx * (double)dx + (double)dy * (double)dy;
+        if (d2 <= c->raio2) {
+            if (c->encontrados < c->maximo) {
+                c->resultado[c->encontrados].no = meio;
+                c->resultado[c->encontrados].distancia2 = d2;
+            }
+            c->encontrados++;
+        }
+
+        // Só desce pelos lados que o círculo atravessa
+        Coordenada plano = eixo ? dy : dx;      // Plano menos posição consultada
+        bool esquerda = plano >= -c->raio, direita = plano <= c->raio;
+        if (esquerda && direita) {
+            ProcurarRaioKD(c, inicio, meio, eixo ^ 1);
+            inicio = meio + 1;
+        } else if (esquerda) {
+            fim = meio;
+        } else {
+            inicio = meio + 1;
+        }
+        eixo ^= 1;
+    }
+}
+
+/**
+ * @brief Procura as antenas a distância euclidiana não superior a raio de (x, y).
+ *
+ * @param a Árvore k-d.
+ * @param frequencia Frequência das antenas procuradas, ou 0 para qualquer frequência.
+ * @param x Coordenada X do centro.
+ * @param y Coordenada Y do centro.
+ * @param raio Raio (inclusivo).
+ * @param resultado Recebe até `maximo` antenas, sem ordem definida (pode ser NULL se maximo for 0).
+ * @param maximo Capacidade de resultado.
+ * @return size_t Número total de antenas no raio, que pode exceder `maximo`.
+ */
+size_t AntenasNoRaio(const ArvoreKD *a, char frequencia, Coordenada x, Coordenada y, Coordenada raio, VizinhoKD *resultado, size_t maximo) {
+    if (!a || raio < 0 || (!resultado && maximo > 0)) return 0;
+
+    ConsultaRaio c = { a->nos, x, y, raio, (double)raio * (double)raio, resultado, maximo, 0 };
+    int primeira = frequencia ? (unsigned char)frequencia % FREQUENCIAS_KD : 0;
+    int ultima = frequencia ? primeira : FREQUENCIAS_KD - 1;
+    for (int f = primeira; f <= ultima; f++)
+        ProcurarRaioKD(&c, a->inicioFrequencia[f], a->inicioFrequencia[f + 1], 0);
+    return c.encontrados;
+}
+
+#pragma endregion
+
+#pragma region Consultas em lote
+
+/**
+ * @brief Lote partilhado pelos fios; cada fio reserva blocos de consultas com um contador atómico.
+ */
+typedef struct LoteKD {
+    const ArvoreKD *a;
+    const ConsultaKD *consultas;
+    int numConsultas, k;
+    bool excluirPosicao;
+    VizinhoKD *resultados;
+    int *quantidades;
+    int seguinte;
+} LoteKD;
+
+/// Consultas reservadas de cada vez por um fio.
+#define CONSULTAS_POR_BLOCO 64
+
+static void *TrabalhadorKD(void *arg) {
+    LoteKD *l = (LoteKD *)arg;
+    for (;;) {
+        int inicio = __atomic_fetch_add(&l->seguinte, CONSULTAS_POR_BLOCO, __ATOMIC_RELAXED);
+        if (inicio >= l->numConsultas) break;
+        int fim = inicio + CONSULTAS_POR_BLOCO < l->numConsultas ? inicio + CONSULTAS_POR_BLOCO : l->numConsultas;
+        for (int i = inicio; i < fim; i++) {
+            const ConsultaKD *q = &l->consultas[i];
+            l->quantidades[i] = VizinhosMaisProximos(l->a, q->frequencia, q->x, q->y, l->k, l->excluirPosicao,
+                                                     l->resultados + (size_t)i * (size_t)l->k);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Responde a um lote de consultas dos k mais próximos, repartidas por vários fios.
+ *
+ * A árvore só é lida, por isso os fios não precisam de sincronização além da reserva das consultas.
+ *
+ * @param a Árvore k-d.
+ * @param consultas Posições e frequências a consultar.
+ * @param numConsultas Número de consultas.
+ * @param k Vizinhos por consulta.
+ * @param excluirPosicao Como em VizinhosMaisProximos.
+ * @param resultados numConsultas*k posições; os vizinhos da consulta i começam em resultados[i*k].
+ * @param quantidades Recebe o número de vizinhos encontrados em cada consulta.
+ * @param numThreads Número de fios de execução (1 para sequencial).
+ * @return true Se todas as consultas foram respondidas.
+ */
+bool VizinhosMaisProximosLote(const ArvoreKD *a, const ConsultaKD *consultas, int numConsultas, int k,
+                              bool excluirPosicao, VizinhoKD *resultados, int *quantidades, int numThreads) {
+    if (!a || numConsultas < 0 || k < 0 || (numConsultas > 0 && (!consultas || !quantidades || (k > 0 && !resultados))))
+        return false;
+    if (numThreads < 1) numThreads = 1;
+
+    LoteKD l = { a, consultas, numConsultas, k, excluirPosicao, resultados, quantidades, 0 };
+    pthread_t *ids = (pthread_t *)malloc((size_t)numThreads * sizeof(pthread_t));
+    int criados = 0;
+    if (ids) {
+        for (int i = 1; i < numThreads; i++) {
+            if (pthread_create(&ids[criados], NULL, TrabalhadorKD, &l) != 0) break;
+            criados++;
+        }
+    }
+
+    // O fio que chama também trabalha; sem fios adicionais faz todas as consultas
+    TrabalhadorKD(&l);
+    for (int i = 0; i < criados; i++) pthread_join(ids[i], NULL);
+    free(ids);
+    return true;
+}
+
+#pragma endregion
@@ -0,0 +1,405 @@
+/**
+ * @file exportar.c
+ * @author David Costa
+ * @brief Buffer de saída com formatação própria de inteiros e exportação em CSV, NDJSON e binário colunar.
+ */
+
+#include "exportar.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+
+#pragma region Buffer de saída
+
+/**
+ * @brief Inicializa um buffer de saída para o descritor indicado.
+ * 
+ * @param b Buffer a inicializar.
+ * @param fd Descritor de ficheiro de destino (não é fechado no fim).
+ * @param capacidade Tamanho do buffer em bytes (0 para TAMANHO_BUFFER_SAIDA).
+ * @return true Se a memória foi reservada.
+ */
+bool IniciarBufferSaida(BufferSaida *b, int fd, size_t capacidade) {
+    if (capacidade < 64) capacidade = (capacidade == 0) ? TAMANHO_BUFFER_SAIDA : 64;
+
+    b->fd = fd;
+    b->dados = (char *)malloc(capacidade);
+    b->usados = 0;
+    b->capacidade = capacidade;
+    b->erro = (b->dados == NULL);
+    return !b->erro;
+}
+
+/**
+ * @brief Escreve no descritor todo o bloco indicado, repetindo as escritas parciais.
+ */
+static bool EscreverDescritor(BufferSaida *b, const char *dados, size_t n) {
+    while (n > 0 && !b->erro) {
+        long escritos = (long)write(b->fd, dados, n);
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            b->erro = true;
+        } else {
+            dados += escritos;
+            n -= (size_t)escritos;
+        }
+    }
+    return !b->erro;
+}
+
+/**
+ * @brief Envia para o descritor o conteúdo acumulado no buffer.
+ * 
+ * @param b Buffer de saída.
+ * @return true Se não houve nenhum erro de escrita até agora.
+ */
+bool DescarregarBuffer(BufferSaida *b) {
+    if (b->usados > 0 && b->dados) EscreverDescritor(b, b->dados, b->usados);
+    b->usados = 0;
+    return !b->erro;
+}
+
+/**
+ * @brief Descarrega o buffer e liberta a sua memória.
+ * 
+ * @param b Buffer de saída.
+ * @return true Se todos os dados foram escritos.
+ */
+bool TerminarBufferSaida(BufferSaida *b) {
+    bool ok = DescarregarBuffer(b);
+    free(b->dados);
+    b->dados = NULL;
+    b->capacidade = 0;
+    return ok;
+}
+
+/**
+ * @brief Garante que cabem mais n bytes no buffer (n nunca excede a capacidade).
+ */
+static inline void Reservar(BufferSaida *b, size_t n) {
+    if (b->capacidade - b->usados < n) DescarregarBuffer(b);
+}
+
+/**
+ * @brief Acrescenta bytes ao buffer. Blocos maiores do que o buffer são escritos diretamente.
+ * 
+ * @param b Buffer de saída.
+ * @param dados Bytes a escrever.
+ * @param n Número de bytes.
+ */
+void EscreverBytes(BufferSaida *b, const void *dados, size_t n) {
+    if (b->erro) return;
+    if (n > b->capacidade / 2) {
+        DescarregarBuffer(b);
+        EscreverDescritor(b, (const char *)dados, n);
+        return;
+    }
+    Reservar(b, n);
+    memcpy(b->dados + b->usados, dados, n);
+    b->usados += n;
+}
+
+/**
+ * @brief Acrescenta um caractere ao buffer.
+ */
+static inline void EscreverCaractere(BufferSaida *b, char c) {
+    if (b->erro) return;
+    Reservar(b, 1);
+    b->dados[b->usados++] = c;
+}
+
+/// Pares de algarismos "00" a "99", para converter dois algarismos de cada vez.
+static const char PARES_ALGARISMOS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+ * @brief Acrescenta um inteiro em decimal ao buffer, sem passar por printf.
+ * 
+ * @param b Buffer de saída.
+ * @param valor Valor a escrever.
+ */
+void EscreverInteiro(BufferSaida *b, long long valor) {
+    char texto[24];
+    char *p = texto + sizeof(texto);
+    unsigned long long v = (valor < 0) ? 0ULL - (unsigned long long)valor : (unsigned long long)valor;
+
+    while (v >= 100) {
+        unsigned d = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = PARES_ALGARISMOS[d + 1];
+        *--p = PARES_ALGARISMOS[d];
+    }
+    if (v >= 10) {
+        *--p = PARES_ALGARISMOS[v * 2 + 1];
+        *--p = PARES_ALGARISMOS[v * 2];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    if (valor < 0) *--p = '-';
+
+    size_t n = (size_t)(texto + sizeof(texto) - p);
+    if (b->erro) return;
+    Reservar(b, n);
+    memcpy(b->dados + b->usados, p, n);
+    b->usados += n;
+}
+
+/**
+ * @brief Acrescenta um int64 em little-endian ao buffer.
+ */
+static inline void EscreverInt64(BufferSaida *b, int64_t valor) {
+    if (b->erro) return;
+    Reservar(b, 8);
+    uint64_t v = (uint64_t)valor;
+    unsigned char *p = (unsigned char *)b->dados + b->usados;
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i));
+    b->usados += 8;
+}
+
+#pragma endregion
+
+#pragma region Formatos de texto e binário
+
+/**
+ * @brief Escreve o cabeçalho CSV com os nomes das colunas (os outros formatos não o têm).
+ */
+static void EscreverNomesColunas(BufferSaida *b, FormatoExportacao formato, const char *const *nomes, int n) {
+    if (formato != FORMATO_CSV) return;
+    for (int i = 0; i < n; i++) {
+        if (i > 0) EscreverCaractere(b, ',');
+        EscreverBytes(b, nomes[i], strlen(nomes[i]));
+    }
+    EscreverCaractere(b, '\n');
+}
+
+/**
+ * @brief Escreve o separador antes do campo i de uma linha de texto e, em NDJSON, o nome do campo.
+ */
+static void ComecarCampo(BufferSaida *b, FormatoExportacao formato, const char *nome, int i) {
+    if (formato == FORMATO_CSV) {
+        if (i > 0) EscreverCaractere(b, ',');
+        return;
+    }
+    EscreverCaractere(b, i == 0 ? '{' : ',');
+    EscreverCaractere(b, '"');
+    EscreverBytes(b, nome, strlen(nome));
+    EscreverBytes(b, "\":", 2);
+}
+
+/**
+ * @brief Termina uma linha de texto.
+ */
+static void TerminarLinha(BufferSaida *b, FormatoExportacao formato) {
+    if (formato == FORMATO_NDJSON) EscreverCaractere(b, '}');
+    EscreverCaractere(b, '\n');
+}
+
+/**
+ * @brief Escreve uma frequência como texto, com aspas em NDJSON e quando o CSV o exige.
+ */
+static void EscreverFrequencia(BufferSaida *b, FormatoExportacao formato, char frequencia) {
+    if (formato == FORMATO_CSV) {
+        if (frequencia == ',' || frequencia == '"' || frequencia == '\n' || frequencia == '\r') {
+            EscreverCaractere(b, '"');
+            if (frequencia == '"') EscreverCaractere(b, '"');
+            EscreverCaractere(b, frequencia);
+            EscreverCaractere(b, '"');
+        } else {
+            EscreverCaractere(b, frequencia);
+        }
+        return;
+    }
+
+    EscreverCaractere(b, '"');
+    if (frequencia == '"' || frequencia == '\\') {
+        EscreverCaractere(b, '\\');
+        EscreverCaractere(b, frequencia);
+    } else if ((unsigned char)frequencia < 0x20) {
+        static const char hex[] = "0123456789abcdef";
+        EscreverBytes(b, "\\u00", 4);
+        EscreverCaractere(b, hex[(unsigned char)frequencia >> 4]);
+        EscreverCaractere(b, hex[(unsigned char)frequencia & 15]);
+    } else {
+        EscreverCaractere(b, frequencia);
+    }
+    EscreverCaractere(b, '"');
+}
+
+/**
+ * @brief Escreve um par de coordenadas como campos i e i+1 de uma linha de texto.
+ */
+static void EscreverCoordenadas(BufferSaida *b, FormatoExportacao formato, const char *const *nomes, int i, Coordenada x, Coordenada y) {
+    ComecarCampo(b, formato, nomes[i], i);
+    EscreverInteiro(b, x);
+    ComecarCampo(b, formato, nomes[i + 1], i + 1);
+    EscreverInteiro(b, y);
+}
+
+/**
+ * @brief Escreve o cabeçalho do formato binário.
+ */
+static void EscreverCabecalhoBinario(BufferSaida *b, TipoRegisto registo, int numColunas, uint64_t numLinhas) {
+    unsigned char cabecalho[sizeof(CabecalhoBinario)];
+    memcpy(cabecalho, MAGIA_BINARIO, 4);
+    cabecalho[4] = (unsigned char)registo;
+    cabecalho[5] = (unsigned char)numColunas;
+    cabecalho[6] = BYTES_COORDENADA;
+    cabecalho[7] = 0;
+    for (int i = 0; i < 8; i++) cabecalho[8 + i] = (unsigned char)(numLinhas >> (8 * i));
+    EscreverBytes(b, cabecalho, sizeof(cabecalho));
+}
+
+#pragma endregion
+
+#pragma region Exportação
+
+/**
+ * @brief Exporta todas as antenas (frequencia, x, y), tipo a tipo.
+ * 
+ * @param b Buffer de saída.
+ * @param listaTipos Lista de tipos de antenas.
+ * @param formato Formato de exportação.
+ * @return true Se não houve erros de escrita (o buffer não é descarregado no fim).
+ */
+bool ExportarAntenas(BufferSaida *b, TipoAntena *listaTipos, FormatoExportacao formato) {
+    static const char *const nomes[] = { "frequencia", "x", "y" };
+
+    if (formato == FORMATO_BINARIO) {
+        uint64_t n = 0;
+        for (TipoAntena *t = listaTipos; t; t = t->proximo)
+            for (Antena *a = t->listaAntenas; a; a = a->proximo) n++;
+
+        EscreverCabecalhoBinario(b, REGISTO_ANTENAS, 3, n);
+        for (TipoAntena *t = listaTipos; t; t = t->proximo)
+            for (Antena *a = t->listaAntenas; a; a = a->proximo) EscreverCaractere(b, a->frequencia);
+        for (TipoAntena *t = listaTipos; t; t = t->proximo)
+            for (Antena *a = t->listaAntenas; a; a = a->proximo) EscreverInt64(b, a->x);
+        for (TipoAntena *t = listaTipos; t; t = t->proximo)
+            for (Antena *a = t->listaAntenas; a; a = a->proximo) EscreverInt64(b, a->y);
+        return !b->erro;
+    }
+
+    EscreverNomesColunas(b, formato, nomes, 3);
+    for (TipoAntena *t = listaTipos; t; t = t->proximo) {
+        for (Antena *a = t->listaAntenas; a; a = a->proximo) {
+            ComecarCampo(b, formato, nomes[0], 0);
+            EscreverFrequencia(b, formato, a->frequencia);
+            EscreverCoordenadas(b, formato, nomes, 1, a->x, a->y);
+            TerminarLinha(b, formato);
+        }
+    }
+    return !b->erro;
+}
+
+/**
+ * @brief Exporta as posições com efeito nefasto (x, y).
+ * 
+ * @param b Buffer de saída.
+ * @param lista Lista de efeitos nefastos.
+ * @param formato Formato de exportação.
+ * @return true Se não houve erros de escrita.
+ */
+bool ExportarEfeitos(BufferSaida *b, const EfeitoNefasto *lista, FormatoExportacao formato) {
+    static const char *const nomes[] = { "x", "y" };
+
+    if (formato == FORMATO_BINARIO) {
+        uint64_t n = 0;
+        for (const EfeitoNefasto *e = lista; e; e = e->proximo) n++;
+
+        EscreverCabecalhoBinario(b, REGISTO_EFEITOS, 2, n);
+        for (const EfeitoNefasto *e = lista; e; e = e->proximo) EscreverInt64(b, e->x);
+        for (const EfeitoNefasto *e = lista; e; e = e->proximo) EscreverInt64(b, e->y);
+        return !b->erro;
+    }
+
+    EscreverNomesColunas(b, formato, nomes, 2);
+    for (const EfeitoNefasto *e = lista; e; e = e->proximo) {
+        EscreverCoordenadas(b, formato, nomes, 0, e->x, e->y);
+        TerminarLinha(b, formato);
+    }
+    return !b->erro;
+}
+
+/**
+ * @brief Exporta as ligações de cada antena aos seus adjacentes (x, y, x2, y2).
+ * 
+ * @param b Buffer de saída.
+ * @param listaTipos Lista de tipos de antenas, já interligadas.
+ * @param formato Formato de exportação.
+ * @return true Se não houve erros de escrita.
+ */
+bool ExportarAdjacencias(BufferSaida *b, TipoAntena *listaTipos, FormatoExportacao formato) {
+    static const char *const nomes[] = { "x", "y", "x2", "y2" };
+
+    if (formato == FORMATO_BINARIO) {
+        uint64_t n = 0;
+        for (TipoAntena *t = listaTipos; t; t = t->proximo)
+            for (Antena *a = t->listaAntenas; a; a = a->proximo)
+                for (Adjacente *adj = a->adjacentes; adj; adj = adj->proximo) n++;
+
+        EscreverCabecalhoBinario(b, REGISTO_ADJACENCIAS, 4, n);
+        for (int coluna = 0; coluna < 4; coluna++) {
+            for (TipoAntena *t = listaTipos; t; t = t->proximo) {
+                for (Antena *a = t->listaAntenas; a; a = a->proximo) {
+                    for (Adjacente *adj = a->adjacentes; adj; adj = adj->proximo) {
+                        Coordenada valores[4] = { a->x, a->y, adj->x, adj->y };
+                        EscreverInt64(b, valores[coluna]);
+                    }
+                }
+            }
+        }
+        return !b->erro;
+    }
+
+    EscreverNomesColunas(b, formato, nomes, 4);
+    for (TipoAntena *t = listaTipos; t; t = t->proximo) {
+        for (Antena *a = t->listaAntenas; a; a = a->proximo) {
+            for (Adjacente *adj = a->adjacentes; adj; adj = adj->proximo) {
+                EscreverCoordenadas(b, formato, nomes, 0, a->x, a->y);
+                EscreverCoordenadas(b, formato, nomes, 2, adj->x, adj->y);
+                TerminarLinha(b, formato);
+            }
+        }
+    }
+    return !b->erro;
+}
+
+/**
+ * @brief Exporta o resultado de uma busca (x, y), pela ordem de visita.
+ * 
+ * @param b Buffer de saída.
+ * @param lista Resultado de uma busca em profundidade ou em largura.
+ * @param formato Formato de exportação.
+ * @return true Se não houve erros de escrita.
+ */
+bool ExportarPercurso(BufferSaida *b, const ResultadoDFS *lista, FormatoExportacao formato) {
+    static const char *const nomes[] = { "x", "y" };
+
+    if (formato == FORMATO_BINARIO) {
+        uint64_t n = 0;
+        for (const ResultadoDFS *r = lista; r; r = r->proximo) n++;
+
+        EscreverCabecalhoBinario(b, REGISTO_PERCURSO, 2, n);
+        for (const ResultadoDFS *r = lista; r; r = r->proximo) EscreverInt64(b, r->x);
+        for (const ResultadoDFS *r = lista; r; r = r->proximo) EscreverInt64(b, r->y);
+        return !b->erro;
+    }
+
+    EscreverNomesColunas(b, formato, nomes, 2);
+    for (const ResultadoDFS *r = lista; r; r = r->proximo) {
+        EscreverCoordenadas(b, formato, nomes, 0, r->x, r->y);
+        TerminarLinha(b, formato);
+    }
+    return !b->erro;
+}
+
+#pragma endregion
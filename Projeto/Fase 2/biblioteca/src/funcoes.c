@@ -6,12 +6,12 @@
 
 #include "struct.h"
 #include "funcoes.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
-#define MAX_LINHA 20
-
 /**
  * @brief Cria um novo nodo adjacente.
  * 
@@ -19,7 +19,7 @@
  * @param y Coordenada Y da antena adjacente.
  * @return Adjacente* Ponteiro para o nodo criado, ou NULL em caso de erro.
  */
-Adjacente *CriarAdjacente(int x, int y) {
+Adjacente *CriarAdjacente(Coordenada x, Coordenada y) {
     Adjacente *novo = (Adjacente *)malloc(sizeof(Adjacente));
     if (!novo)
         return NULL;
@@ -51,7 +51,7 @@ TipoAntena *ProcurarTipo(TipoAntena *lista, char tipo);
  * @param y Coordenada Y da antena.
  * @return Antena* Ponteiro para a antena criada, ou NULL em caso de erro.
  */
-Antena *CriarAntena(char frequencia, int x, int y)
+Antena *CriarAntena(char frequencia, Coordenada x, Coordenada y)
 {
     Antena *aux = (Antena *)malloc(sizeof(Antena));
     if (!aux)
@@ -141,7 +141,7 @@ TipoAntena *InserirAntenaEmTipo(TipoAntena *listaTipos, char tipo, Antena *novaA
  * @return true Se a operação foi bem-sucedida.
  * @return false Se ocorreu erro (ponteiro NULL ou malloc falhou).
  */
-bool AdicionarAdjacenteAntena(Antena *antena, int x, int y)
+bool AdicionarAdjacenteAntena(Antena *antena, Coordenada x, Coordenada y)
 {
     if (!antena)
         return false;
@@ -198,7 +198,7 @@ TipoAntena *AdicionarTipoAntena(TipoAntena *lista, char tipo) {
  * @param antenaAtual Ponteiro para a antena visitada.
  * @return ResultadoDFS* Ponteiro para a lista atualizada.
  */
-ResultadoDFS *AdicionarResultado(ResultadoDFS *lista, int x, int y, Antena *antenaAtual) {
+ResultadoDFS *AdicionarResultado(ResultadoDFS *lista, Coordenada x, Coordenada y, Antena *antenaAtual) {
     ResultadoDFS *novo = (ResultadoDFS *)malloc(sizeof(ResultadoDFS));
     if (!novo) return lista;
 
@@ -278,7 +278,7 @@ TipoAntena *ProcurarTipo(TipoAntena *lista, char tipo) {
  * @param y Coordenada Y da antena procurada.
  * @return Antena* Ponteiro para a antena encontrada, ou NULL se não existir.
  */
-Antena *ProcurarAntenaPorCoordenadas(TipoAntena *listaTipos, int x, int y) {
+Antena *ProcurarAntenaPorCoordenadas(TipoAntena *listaTipos, Coordenada x, Coordenada y) {
     while (listaTipos) {
         Antena *a = listaTipos->listaAntenas;
         while (a) {
@@ -295,36 +295,87 @@ Antena *ProcurarAntenaPorCoordenadas(TipoAntena *listaTipos, int x, int y) {
 
 #pragma region Buscas
 
+/**
+ * @brief Verifica se uma posição está dentro da matriz.
+ * 
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param max_x Tamanho máximo eixo X.
+ * @param max_y Tamanho máximo eixo Y.
+ * @return true Se 0 <= x < max_x e 0 <= y < max_y, ou se max_x ou max_y for <= 0 (matriz sem limites).
+ */
+static inline bool DentroLimites(Coordenada x, Coordenada y, Coordenada max_x, Coordenada max_y) {
+    return max_x <= 0 || max_y <= 0 || (x >= 0 && x < max_x && y >= 0 && y < max_y);
+}
+
+/**
+ * @brief Indexa todas as antenas da rede pelas suas coordenadas.
+ * 
+ * As buscas constroem este índice uma vez e procuram nele cada vizinho, em vez de percorrerem
+ * todas as listas por cada ligação.
+ * 
+ * @param listaTipos Lista de tipos de antenas.
+ * @param indice Tabela a inicializar; cada valor é o ponteiro para a antena.
+ * @return true Se a memória foi reservada.
+ */
+static bool IndexarAntenas(TipoAntena *listaTipos, TabelaCoordenadas *indice) {
+    size_t numAntenas = 0;
+    for (TipoAntena *t = listaTipos; t; t = t->proximo)
+        for (Antena *a = t->listaAntenas; a; a = a->proximo) numAntenas++;
+
+    if (!IniciarTabela(indice, numAntenas)) return false;
+
+    for (TipoAntena *t = listaTipos; t; t = t->proximo) {
+        for (Antena *a = t->listaAntenas; a; a = a->proximo) {
+            // Em posições repetidas fica a primeira antena, como em ProcurarAntenaPorCoordenadas
+            if (ProcurarTabela(indice, a->x, a->y, NULL)) continue;
+            if (!InserirTabela(indice, a->x, a->y, (uint64_t)(uintptr_t)a)) {
+                LiberarTabela(indice);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Procura uma antena no índice construído por IndexarAntenas.
+ */
+static Antena *AntenaIndexada(const TabelaCoordenadas *indice, Coordenada x, Coordenada y) {
+    uint64_t valor;
+    return ProcurarTabela(indice, x, y, &valor) ? (Antena *)(uintptr_t)valor : NULL;
+}
+
 /**
  * @brief Função recursiva auxiliar para DFS.
  * 
  * @param antena Antena atual.
- * @param visitado Matriz de visitados.
+ * @param visitado Conjunto das posições visitadas.
  * @param max_x Tamanho máximo eixo X.
  * @param max_y Tamanho máximo eixo Y.
  * @param resultado Lista com resultado da DFS.
- * @param listaTipos Lista de tipos de antenas para procurar adjacentes.
+ * @param indice Índice das antenas por coordenadas, para procurar adjacentes.
  * @return ResultadoDFS* Lista atualizada com resultados.
  */
-ResultadoDFS *DFSRecursiva(Antena *antena, bool visitado[MAX_LINHA][MAX_LINHA], int max_x, int max_y, ResultadoDFS *resultado, TipoAntena *listaTipos) {
+ResultadoDFS *DFSRecursiva(Antena *antena, ConjuntoCoordenadas *visitado, Coordenada max_x, Coordenada max_y, ResultadoDFS *resultado, const TabelaCoordenadas *indice) {
     if (!antena) return resultado;
 
-    int x = antena->x;
-    int y = antena->y;
+    Coordenada x = antena->x;
+    Coordenada y = antena->y;
 
-    if (x < 0 || x >= max_x || y < 0 || y >= max_y)
+    if (!DentroLimites(x, y, max_x, max_y))
         return resultado;
 
-    if (visitado[x][y])
+    bool novo;
+    if (!AdicionarConjunto(visitado, x, y, &novo) || !novo)
         return resultado;
 
-    visitado[x][y] = true;
     resultado = AdicionarResultado(resultado, x, y, antena);
 
     Adjacente *adj = antena->adjacentes;
     while (adj) {
-        Antena *proximo = ProcurarAntenaPorCoordenadas(listaTipos, adj->x, adj->y);
-        resultado = DFSRecursiva(proximo, visitado, max_x, max_y, resultado, listaTipos);
+        Antena *proximo = AntenaIndexada(indice, adj->x, adj->y);
+        resultado = DFSRecursiva(proximo, visitado, max_x, max_y, resultado, indice);
         adj = adj->proximo;
     }
 
@@ -334,72 +385,528 @@ ResultadoDFS *DFSRecursiva(Antena *antena, bool visitado[MAX_LINHA][MAX_LINHA],
 /**
  * @brief Realiza busca em profundidade (DFS) a partir de uma antena inicial.
  * 
+ * As posições visitadas ficam num conjunto esparso, por isso a memória depende das antenas
+ * visitadas e não do tamanho da matriz.
+ * 
  * @param listaTipos Lista de tipos de antenas.
  * @param x_inicial Coordenada X inicial.
  * @param y_inicial Coordenada Y inicial.
- * @param max_x Tamanho máximo eixo X.
- * @param max_y Tamanho máximo eixo Y.
+ * @param max_x Tamanho máximo eixo X (<= 0 para não limitar).
+ * @param max_y Tamanho máximo eixo Y (<= 0 para não limitar).
  * @return ResultadoDFS* Lista com resultado da DFS.
  */
-ResultadoDFS *BuscaEmProfundidade(TipoAntena *listaTipos, int x_inicial, int y_inicial, int max_x, int max_y) {
-    bool visitado[MAX_LINHA][MAX_LINHA] = { false };
-
-    Antena *inicio = ProcurarAntenaPorCoordenadas(listaTipos, x_inicial, y_inicial);
-    if (!inicio) return NULL;
+ResultadoDFS *BuscaEmProfundidade(TipoAntena *listaTipos, Coordenada x_inicial, Coordenada y_inicial, Coordenada max_x, Coordenada max_y) {
+    TabelaCoordenadas indice;
+    if (!IndexarAntenas(listaTipos, &indice)) return NULL;
+
+    Antena *inicio = AntenaIndexada(&indice, x_inicial, y_inicial);
+    ConjuntoCoordenadas visitado;
+    if (!inicio || !IniciarConjunto(&visitado, 0)) {
+        LiberarTabela(&indice);
+        return NULL;
+    }
 
     ResultadoDFS *resultado = NULL;
-    resultado = DFSRecursiva(inicio, visitado, max_x, max_y, resultado, listaTipos);
+    resultado = DFSRecursiva(inicio, &visitado, max_x, max_y, resultado, &indice);
+    LiberarConjunto(&visitado);
+    LiberarTabela(&indice);
     return resultado;
 }
 
 /**
  * @brief Realiza busca em largura (BFS) a partir de uma antena inicial.
  * 
+ * A fila tem uma posição por antena da rede e as posições visitadas ficam num conjunto esparso.
+ * Os vizinhos são procurados num índice das antenas por coordenadas, construído uma vez por busca.
+ * 
  * @param listaTipos Lista de tipos de antenas.
  * @param x_inicial Coordenada X inicial.
  * @param y_inicial Coordenada Y inicial.
- * @param max_x Tamanho máximo eixo X.
- * @param max_y Tamanho máximo eixo Y.
- * @return ResultadoDFS* Lista com resultado da BFS.
+ * @param max_x Tamanho máximo eixo X (<= 0 para não limitar).
+ * @param max_y Tamanho máximo eixo Y (<= 0 para não limitar).
+ * @return ResultadoDFS* Lista com resultado da BFS, ou NULL se a antena não existe ou faltou memória.
  */
-ResultadoDFS *BuscaEmLargura(TipoAntena *listaTipos, int x_inicial, int y_inicial, int max_x, int max_y) {
-    bool visitado[MAX_LINHA][MAX_LINHA] = { false };
-
+ResultadoDFS *BuscaEmLargura(TipoAntena *listaTipos, Coordenada x_inicial, Coordenada y_inicial, Coordenada max_x, Coordenada max_y) {
     ResultadoDFS *resultado = NULL;
 
-    Antena *inicio = ProcurarAntenaPorCoordenadas(listaTipos, x_inicial, y_inicial);
-    if (!inicio) return NULL;
+    TabelaCoordenadas indice;
+    if (!IndexarAntenas(listaTipos, &indice)) return NULL;
 
-    Antena **fila = (Antena **)malloc(sizeof(Antena *) * (max_x * max_y));
-    if (!fila) return NULL;
+    Antena *inicio = AntenaIndexada(&indice, x_inicial, y_inicial);
+    if (!inicio || !DentroLimites(inicio->x, inicio->y, max_x, max_y)) {
+        LiberarTabela(&indice);
+        return NULL;
+    }
 
-    int inicioFila = 0, fimFila = 0;
+    Antena **fila = (Antena **)malloc(sizeof(Antena *) * indice.tamanho);
+    ConjuntoCoordenadas visitado;
+    if (!fila || !IniciarConjunto(&visitado, 0) || !AdicionarConjunto(&visitado, inicio->x, inicio->y, NULL)) {
+        if (fila) LiberarConjunto(&visitado);
+        free(fila);
+        LiberarTabela(&indice);
+        return NULL;
+    }
+
+    size_t inicioFila = 0, fimFila = 0;
     fila[fimFila++] = inicio;
-    visitado[inicio->x][inicio->y] = true;
+    bool erro = false;
 
-    while (inicioFila < fimFila) {
+    while (!erro && inicioFila < fimFila) {
         Antena *atual = fila[inicioFila++];
         resultado = AdicionarResultado(resultado, atual->x, atual->y, atual);
 
         Adjacente *adj = atual->adjacentes;
         while (adj) {
-            if (!visitado[adj->x][adj->y]) {
-                Antena *vizinho = ProcurarAntenaPorCoordenadas(listaTipos, adj->x, adj->y);
+            if (DentroLimites(adj->x, adj->y, max_x, max_y) && !ContemConjunto(&visitado, adj->x, adj->y)) {
+                Antena *vizinho = AntenaIndexada(&indice, adj->x, adj->y);
                 if (vizinho) {
+                    if (!AdicionarConjunto(&visitado, adj->x, adj->y, NULL)) {
+                        erro = true;
+                        break;
+                    }
                     fila[fimFila++] = vizinho;
-                    visitado[adj->x][adj->y] = true;
                 }
             }
             adj = adj->proximo;
         }
     }
 
+    LiberarConjunto(&visitado);
     free(fila);
+    LiberarTabela(&indice);
+    if (erro) {
+        LiberarResultados(resultado);
+        return NULL;
+    }
     return resultado;
 }
 
 #pragma endregion
 
+#pragma region Carregamento e edição
+
+/**
+ * @brief Carrega as antenas de um ficheiro com a matriz e agrupa-as por tipo.
+ * 
+ * Cada letra do ficheiro é uma antena na posição (linha, coluna). As antenas de cada tipo
+ * ficam pela ordem de leitura do ficheiro.
+ * 
+ * @param nomeFicheiro Caminho do ficheiro.
+ * @param maxLin Recebe o número de linhas da matriz (pode ser NULL).
+ * @param maxCol Recebe o número de colunas da matriz (pode ser NULL).
+ * @return TipoAntena* Lista de tipos com as antenas, ou NULL em caso de erro ou ficheiro sem antenas.
+ */
+TipoAntena *CarregarAntenasFicheiro(const char *nomeFicheiro, Coordenada *maxLin, Coordenada *maxCol) {
+    bool res;
+    TipoAntena *listaTipos = CarregarRegiaoFicheiro(NULL, nomeFicheiro, 0, 0, maxLin, maxCol, &res);
+    if (!res) {
+        LiberarTiposAntenas(listaTipos);
+        return NULL;
+    }
+    return listaTipos;
+}
+
+/**
+ * @brief Junta à rede as antenas de um ficheiro com a matriz, deslocadas para uma origem.
+ * 
+ * Permite juntar várias regiões num único sistema de coordenadas: a letra na linha l e coluna c
+ * do ficheiro é uma antena em (origemX + l, origemY + c). As antenas novas de cada tipo ficam pela
+ * ordem de leitura, depois das que já existiam. Se uma posição já estiver ocupada ou sair de
+ * ±COORDENADA_MAX, nenhuma antena da região é acrescentada.
+ * 
+ * @param listaTipos Lista de tipos de antenas (pode ser NULL).
+ * @param nomeFicheiro Caminho do ficheiro.
+ * @param origemX Coordenada X da primeira linha do ficheiro.
+ * @param origemY Coordenada Y da primeira coluna do ficheiro.
+ * @param maxLin Recebe o número de linhas da região (pode ser NULL).
+ * @param maxCol Recebe o número de colunas da região (pode ser NULL).
+ * @param res Recebe true se a região foi carregada.
+ * @return TipoAntena* Lista de tipos atualizada.
+ */
+TipoAntena *CarregarRegiaoFicheiro(TipoAntena *listaTipos, const char *nomeFicheiro, Coordenada origemX, Coordenada origemY,
+                                   Coordenada *maxLin, Coordenada *maxCol, bool *res) {
+    *res = false;
+    if (!COORDENADA_VALIDA(origemX) || !COORDENADA_VALIDA(origemY)) return listaTipos;
+
+    FILE *f = fopen(nomeFicheiro, "r");
+    if (!f) return listaTipos;
+
+    // Só é preciso procurar sobreposições se a rede já tiver antenas (um ficheiro não repete posições)
+    ConjuntoCoordenadas ocupadas = { NULL, NULL, NULL, 0, 0 };
+    bool verificar = listaTipos != NULL;
+    bool erro = verificar && !IniciarConjunto(&ocupadas, 0);
+    for (TipoAntena *t = listaTipos; !erro && t; t = t->proximo)
+        for (Antena *a = t->listaAntenas; !erro && a; a = a->proximo)
+            erro = !AdicionarConjunto(&ocupadas, a->x, a->y, NULL);
+
+    Antena *novas[128] = { NULL };      // Antenas lidas de cada tipo, só juntadas à rede no fim
+    Antena *caudas[128] = { NULL };     // Última antena de cada tipo, para inserir em O(1)
+    char ordem[128];                    // Tipos pela ordem em que aparecem no ficheiro
+    int numTipos = 0;
+
+    int c;
+    Coordenada x = 0, y = 0, colunas = 0;
+
+    while (!erro && (c = fgetc(f)) != EOF) {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+            Coordenada ax = origemX + x, ay = origemY + y;
+            bool livre = true;
+            if (!COORDENADA_VALIDA(ax) || !COORDENADA_VALIDA(ay) ||
+                (verificar && (!AdicionarConjunto(&ocupadas, ax, ay, &livre) || !livre))) {
+                erro = true;
+                break;
+            }
+
+            Antena *nova = CriarAntena((char)c, ax, ay);
+            if (!nova) {
+                erro = true;
+                break;
+            }
+
+            if (caudas[c]) {
+                caudas[c]->proximo = nova;
+            } else {
+                novas[c] = nova;
+                ordem[numTipos++] = (char)c;
+            }
+            caudas[c] = nova;
+        }
+
+        if (c == '\n') {
+            x++;
+            y = 0;
+        } else if (c != '\r') {
+            y++;
+            if (y > colunas) colunas = y;
+        }
+    }
+    fclose(f);
+    LiberarConjunto(&ocupadas);
+
+    // Cria primeiro os tipos em falta, para a região entrar inteira ou não entrar
+    TipoAntena *tipos[128] = { NULL };
+    for (int i = 0; !erro && i < numTipos; i++) {
+        listaTipos = AdicionarTipoAntena(listaTipos, ordem[i]);
+        tipos[(unsigned char)ordem[i]] = ProcurarTipo(listaTipos, ordem[i]);
+        erro = !tipos[(unsigned char)ordem[i]];
+    }
+
+    if (erro) {
+        for (int i = 0; i < numTipos; i++) LiberarAntenas(novas[(unsigned char)ordem[i]]);
+        return listaTipos;
+    }
+
+    for (int i = 0; i < numTipos; i++) {
+        unsigned char t = (unsigned char)ordem[i];
+        tipos[t]->listaAntenas = InserirAntena(tipos[t]->listaAntenas, novas[t]);
+    }
+
+    if (maxLin) *maxLin = (y > 0) ? x + 1 : x;
+    if (maxCol) *maxCol = colunas;
+    *res = true;
+    return listaTipos;
+}
+
+/**
+ * @brief Remove de uma lista de adjacentes todas as ligações para uma posição.
+ * 
+ * @param lista Lista de adjacentes.
+ * @param x Coordenada X a remover.
+ * @param y Coordenada Y a remover.
+ * @return Adjacente* Lista atualizada.
+ */
+static Adjacente *RemoverAdjacentesPosicao(Adjacente *lista, Coordenada x, Coordenada y) {
+    Adjacente **ligacao = &lista;
+    while (*ligacao) {
+        if ((*ligacao)->x == x && (*ligacao)->y == y) {
+            Adjacente *temp = *ligacao;
+            *ligacao = temp->proximo;
+            free(temp);
+        } else {
+            ligacao = &(*ligacao)->proximo;
+        }
+    }
+    return lista;
+}
+
+/**
+ * @brief Insere uma nova antena na rede e liga-a às antenas do mesmo tipo.
+ * 
+ * @param listaTipos Lista de tipos de antenas.
+ * @param frequencia Frequência da nova antena.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param res Recebe true se a antena foi inserida, false se a posição já estava ocupada, está fora de
+ *            ±COORDENADA_MAX ou faltou memória.
+ * @return TipoAntena* Lista de tipos atualizada.
+ */
+TipoAntena *InserirAntenaRede(TipoAntena *listaTipos, char frequencia, Coordenada x, Coordenada y, bool *res) {
+    *res = false;
+    if (!COORDENADA_VALIDA(x) || !COORDENADA_VALIDA(y) || ProcurarAntenaPorCoordenadas(listaTipos, x, y))
+        return listaTipos;
+
+    listaTipos = AdicionarTipoAntena(listaTipos, frequencia);
+    TipoAntena *tipo = ProcurarTipo(listaTipos, frequencia);
+    Antena *nova = CriarAntena(frequencia, x, y);
+    if (!tipo || !nova) {
+        free(nova);
+        return listaTipos;
+    }
+
+    for (Antena *a = tipo->listaAntenas; a; a = a->proximo) {
+        AdicionarAdjacenteAntena(a, x, y);
+        AdicionarAdjacenteAntena(nova, a->x, a->y);
+    }
+
+    tipo->listaAntenas = InserirAntena(tipo->listaAntenas, nova);
+    *res = true;
+    return listaTipos;
+}
+
+/**
+ * @brief Remove uma antena da rede, bem como as ligações das outras antenas para ela.
+ * 
+ * @param listaTipos Lista de tipos de antenas.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param res Recebe true se a antena foi removida, false se não existia.
+ * @return TipoAntena* Lista de tipos atualizada.
+ */
+TipoAntena *RemoverAntenaRede(TipoAntena *listaTipos, Coordenada x, Coordenada y, bool *res) {
+    *res = false;
+
+    for (TipoAntena *tipo = listaTipos; tipo; tipo = tipo->proximo) {
+        Antena **ligacao = &tipo->listaAntenas;
+        while (*ligacao && ((*ligacao)->x != x || (*ligacao)->y != y))
+            ligacao = &(*ligacao)->proximo;
+
+        if (*ligacao) {
+            Antena *alvo = *ligacao;
+            *ligacao = alvo->proximo;
+            LiberarAdjacentes(alvo->adjacentes);
+            free(alvo);
+
+            // Só as antenas do mesmo tipo podem ter ligações para a antena removida
+            for (Antena *a = tipo->listaAntenas; a; a = a->proximo)
+                a->adjacentes = RemoverAdjacentesPosicao(a->adjacentes, x, y);
+
+            *res = true;
+            return listaTipos;
+        }
+    }
+    return listaTipos;
+}
+
+/**
+ * @brief Verifica se existe um caminho entre duas antenas, através de uma BFS a partir da origem.
+ * 
+ * @param listaTipos Lista de tipos de antenas.
+ * @param xOrigem Coordenada X da origem.
+ * @param yOrigem Coordenada Y da origem.
+ * @param xDestino Coordenada X do destino.
+ * @param yDestino Coordenada Y do destino.
+ * @param max_x Tamanho máximo eixo X.
+ * @param max_y Tamanho máximo eixo Y.
+ * @return true Se o destino é alcançável a partir da origem.
+ */
+bool ExisteCaminho(TipoAntena *listaTipos, Coordenada xOrigem, Coordenada yOrigem, Coordenada xDestino, Coordenada yDestino,
+                   Coordenada max_x, Coordenada max_y) {
+    ResultadoDFS *resultado = BuscaEmLargura(listaTipos, xOrigem, yOrigem, max_x, max_y);
+    bool encontrado = false;
+
+    for (ResultadoDFS *r = resultado; r && !encontrado; r = r->proximo)
+        encontrado = (r->x == xDestino && r->y == yDestino);
+
+    LiberarResultados(resultado);
+    return encontrado;
+}
+
+#pragma endregion
+
+#pragma region Efeitos nefastos
+
+/**
+ * @brief Prepara um acumulador de efeitos nefastos.
+ * 
+ * Escolhe o mapa de bits se a matriz tiver limites e o mapa não ocupar mais do que o conjunto
+ * esparso ocuparia com um efeito por cada ponto simétrico possível (cerca de 24 bytes por posição).
+ * 
+ * @param a Acumulador a inicializar.
+ * @param maxLin Número de linhas da matriz (<= 0 para não limitar).
+ * @param maxCol Número de colunas da matriz (<= 0 para não limitar).
+ * @param numPares Número de pares de antenas que vão ser acumulados.
+ * @return true Se a memória foi reservada.
+ */
+bool IniciarAcumuladorEfeitos(AcumuladorEfeitos *a, Coordenada maxLin, Coordenada maxCol, size_t numPares) {
+    memset(a, 0, sizeof(*a));
+    a->maxLin = maxLin;
+    a->maxCol = maxCol;
+
+    if (maxLin > 0 && maxCol > 0 && (uint64_t)maxLin <= UINT64_MAX / (uint64_t)maxCol) {
+        uint64_t celulas = (uint64_t)maxLin * (uint64_t)maxCol;
+        if (celulas <= ((uint64_t)1 << 16) || celulas / 8 <= (uint64_t)numPares * 2 * 24) {
+            a->mapa = (uint64_t *)calloc((size_t)((celulas + 63) / 64), sizeof(uint64_t));
+            return a->mapa != NULL;
+        }
+    }
+    return IniciarConjunto(&a->conjunto, numPares < 1024 ? numPares * 2 : 2048);
+}
+
+/**
+ * @brief Acumula os dois pontos simétricos de um par de antenas (2*a1 - a2 e 2*a2 - a1) que estão dentro da matriz.
+ * 
+ * @param a Acumulador.
+ * @param x1 Coordenada X da primeira antena.
+ * @param y1 Coordenada Y da primeira antena.
+ * @param x2 Coordenada X da segunda antena.
+ * @param y2 Coordenada Y da segunda antena.
+ * @return true Se a operação foi bem-sucedida; false se faltou memória.
+ */
+bool AcumularEfeitosPar(AcumuladorEfeitos *a, Coordenada x1, Coordenada y1, Coordenada x2, Coordenada y2) {
+    Coordenada pontos[2][2] = {
+        { 2 * x1 - x2, 2 * y1 - y2 },
+        { 2 * x2 - x1, 2 * y2 - y1 }
+    };
+
+    for (int i = 0; i < 2; i++) {
+        Coordenada x = pontos[i][0], y = pontos[i][1];
+        if (a->maxLin > 0 && a->maxCol > 0 && (x < 0 || x >= a->maxLin || y < 0 || y >= a->maxCol)) continue;
+
+        if (a->mapa) {
+            uint64_t pos = (uint64_t)x * (uint64_t)a->maxCol + (uint64_t)y;
+            a->mapa[pos >> 6] |= (uint64_t)1 << (pos & 63);
+        } else if (!AdicionarConjunto(&a->conjunto, x, y, NULL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Compara duas posições por (x, y).
+ */
+static int CompararPosicoes(const void *a, const void *b) {
+    const Coordenada *pa = (const Coordenada *)a, *pb = (const Coordenada *)b;
+    if (pa[0] != pb[0]) return pa[0] < pb[0] ? -1 : 1;
+    return (pa[1] > pb[1]) - (pa[1] < pb[1]);
+}
+
+/**
+ * @brief Constrói a lista ordenada por (x, y) das posições acumuladas.
+ * 
+ * @param a Acumulador.
+ * @return EfeitoNefasto* Lista ordenada, ou NULL se não houver efeitos ou faltar memória.
+ */
+EfeitoNefasto *ListaEfeitosAcumulados(const AcumuladorEfeitos *a) {
+    EfeitoNefasto *lista = NULL, *cauda = NULL;
+
+    if (a->mapa) {
+        // Percorre o mapa por ordem para construir a lista já ordenada
+        uint64_t palavras = ((uint64_t)a->maxLin * (uint64_t)a->maxCol + 63) / 64;
+        for (uint64_t w = 0; w < palavras; w++) {
+            for (uint64_t bits = a->mapa[w]; bits; bits &= bits - 1) {
+                uint64_t pos = w * 64 + (uint64_t)__builtin_ctzll(bits);
+
+                EfeitoNefasto *novo = (EfeitoNefasto *)malloc(sizeof(EfeitoNefasto));
+                if (!novo) {
+                    LiberarEfeitos(lista);
+                    return NULL;
+                }
+                novo->x = (Coordenada)(pos / (uint64_t)a->maxCol);
+                novo->y = (Coordenada)(pos % (uint64_t)a->maxCol);
+                novo->proximo = NULL;
+
+                if (cauda) cauda->proximo = novo;
+                else lista = novo;
+                cauda = novo;
+            }
+        }
+        return lista;
+    }
+
+    // Conjunto esparso: copia as posições e ordena-as
+    size_t n = a->conjunto.tamanho, k = 0;
+    if (n == 0) return NULL;
+    Coordenada *posicoes = (Coordenada *)malloc(n * 2 * sizeof(Coordenada));
+    if (!posicoes) return NULL;
+    for (size_t i = 0; i < a->conjunto.capacidade; i++) {
+        if (!a->conjunto.ocupado[i]) continue;
+        posicoes[2 * k] = a->conjunto.x[i];
+        posicoes[2 * k + 1] = a->conjunto.y[i];
+        k++;
+    }
+    qsort(posicoes, n, 2 * sizeof(Coordenada), CompararPosicoes);
+
+    for (size_t i = 0; i < n; i++) {
+        EfeitoNefasto *novo = (EfeitoNefasto *)malloc(sizeof(EfeitoNefasto));
+        if (!novo) {
+            free(posicoes);
+            LiberarEfeitos(lista);
+            return NULL;
+        }
+        novo->x = posicoes[2 * i];
+        novo->y = posicoes[2 * i + 1];
+        novo->proximo = NULL;
+
+        if (cauda) cauda->proximo = novo;
+        else lista = novo;
+        cauda = novo;
+    }
+    free(posicoes);
+    return lista;
+}
+
+/**
+ * @brief Liberta a memória de um acumulador de efeitos.
+ * 
+ * @param a Acumulador.
+ */
+void LiberarAcumuladorEfeitos(AcumuladorEfeitos *a) {
+    free(a->mapa);
+    a->mapa = NULL;
+    LiberarConjunto(&a->conjunto);
+}
+
+/**
+ * @brief Calcula as posições distintas com efeito nefasto.
+ * 
+ * Cada par de antenas do mesmo tipo produz um efeito em cada um dos pontos simétricos
+ * (2*a1 - a2 e 2*a2 - a1). Se a matriz tiver limites, só contam os pontos dentro dela;
+ * sem limites contam todos, incluindo os de coordenadas negativas.
+ * 
+ * @param listaTipos Lista de tipos de antenas.
+ * @param maxLin Número de linhas da matriz (<= 0 para não limitar).
+ * @param maxCol Número de colunas da matriz (<= 0 para não limitar).
+ * @return EfeitoNefasto* Lista ordenada por (x, y), ou NULL se não houver efeitos ou faltar memória.
+ */
+EfeitoNefasto *CalcularEfeitosNefastos(TipoAntena *listaTipos, Coordenada maxLin, Coordenada maxCol) {
+    size_t numPares = 0;
+    for (TipoAntena *tipo = listaTipos; tipo; tipo = tipo->proximo) {
+        size_t k = 0;
+        for (Antena *a = tipo->listaAntenas; a; a = a->proximo) k++;
+        numPares += k * (k - 1) / 2;
+    }
+
+    AcumuladorEfeitos efeitos;
+    if (!IniciarAcumuladorEfeitos(&efeitos, maxLin, maxCol, numPares)) return NULL;
+
+    bool ok = true;
+    for (TipoAntena *tipo = listaTipos; ok && tipo; tipo = tipo->proximo) {
+        for (Antena *a1 = tipo->listaAntenas; ok && a1; a1 = a1->proximo) {
+            for (Antena *a2 = a1->proximo; ok && a2; a2 = a2->proximo) {
+                if (a1->x == a2->x && a1->y == a2->y) continue;
+                ok = AcumularEfeitosPar(&efeitos, a1->x, a1->y, a2->x, a2->y);
+            }
+        }
+    }
+
+    EfeitoNefasto *lista = ok ? ListaEfeitosAcumulados(&efeitos) : NULL;
+    LiberarAcumuladorEfeitos(&efeitos);
+    return lista;
+}
+
+#pragma endregion
+
 #pragma region Liberar memória
 
 /**
@@ -464,4 +971,19 @@ bool LiberarResultados(ResultadoDFS *lista) {
     return true;
 }
 
+/**
+ * @brief Libera toda a lista ligada de efeitos nefastos.
+ * 
+ * @param lista Lista de efeitos.
+ * @return true Se a operação foi bem-sucedida.
+ */
+bool LiberarEfeitos(EfeitoNefasto *lista) {
+    while (lista) {
+        EfeitoNefasto *temp = lista;
+        lista = lista->proximo;
+        free(temp);
+    }
+    return true;
+}
+
 #pragma endregion
@@ -0,0 +1,1940 @@
+/**
+ * @file grafo.c
+ * @author David Costa
+ * @brief Construção do grafo plano (CSR) e busca em largura paralela sobre ele.
+ */
+
+#define _POSIX_C_SOURCE 200809L // Com -std=c11: pthread_barrier_t da BFS por níveis e da ordenação radix; mmap e ftruncate da matriz de saltos
+#include "grafo.h"
+#include "funcoes.h"
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma region Grafo plano
+
+/**
+ * @brief Constrói o grafo plano a partir das listas de tipos e das listas de adjacentes das antenas.
+ * 
+ * As coordenadas de cada adjacente são resolvidas uma única vez; adjacentes repetidos e
+ * adjacentes sem antena correspondente são ignorados.
+ * 
+ * @param listaTipos Lista de tipos de antenas, já interligadas.
+ * @return GrafoPlano* Grafo criado, ou NULL em caso de erro.
+ */
+GrafoPlano *CriarGrafoPlano(TipoAntena *listaTipos) {
+    GrafoPlano *g = (GrafoPlano *)calloc(1, sizeof(GrafoPlano));
+    if (!g) return NULL;
+
+    int n = 0;
+    for (TipoAntena *t = listaTipos; t; t = t->proximo)
+        for (Antena *a = t->listaAntenas; a; a = a->proximo) n++;
+
+    g->numVertices = n;
+    g->inicioAdj = (size_t *)calloc((size_t)n + 1, sizeof(size_t));
+    g->x = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    g->y = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    g->frequencia = (char *)malloc((size_t)n + 1);
+    g->antenas = (Antena **)malloc(((size_t)n + 1) * sizeof(Antena *));
+    int *ultimaOrigem = (int *)malloc(((size_t)n + 1) * sizeof(int));
+
+    if (!g->inicioAdj || !g->x || !g->y || !g->frequencia || !g->antenas || !ultimaOrigem ||
+        !IniciarTabela(&g->indice, (size_t)n)) {
+        free(ultimaOrigem);
+        LiberarGrafoPlano(g);
+        return NULL;
+    }
+
+    int v = 0;
+    for (TipoAntena *t = listaTipos; t; t = t->proximo) {
+        for (Antena *a = t->listaAntenas; a; a = a->proximo, v++) {
+            g->x[v] = a->x;
+            g->y[v] = a->y;
+            g->frequencia[v] = a->frequencia;
+            g->antenas[v] = a;
+            if (!InserirTabela(&g->indice, a->x, a->y, (uint64_t)v)) {
+                free(ultimaOrigem);
+                LiberarGrafoPlano(g);
+                return NULL;
+            }
+        }
+    }
+
+    // Duas passagens pelos adjacentes: a primeira conta, a segunda preenche.
+    // ultimaOrigem[w] guarda o último vértice que já recebeu w como adjacente, para ignorar repetidos.
+    for (int passagem = 0; passagem < 2; passagem++) {
+        for (int i = 0; i < n; i++) ultimaOrigem[i] = -1;
+
+        size_t *posicao = passagem == 0 ? NULL : g->inicioAdj;
+        for (v = 0; v < n; v++) {
+            size_t k = posicao ? posicao[v] : 0;
+            for (Adjacente *adj = g->antenas[v]->adjacentes; adj; adj = adj->proximo) {
+                uint64_t w;
+                if (!ProcurarTabela(&g->indice, adj->x, adj->y, &w)) continue;
+                if ((int)w == v || ultimaOrigem[w] == v) continue;
+                ultimaOrigem[w] = v;
+
+                if (passagem == 0) g->inicioAdj[v + 1]++;
+                else g->adjacentes[k++] = (int)w;
+            }
+        }
+
+        if (passagem == 0) {
+            for (v = 0; v < n; v++) g->inicioAdj[v + 1] += g->inicioAdj[v];
+            g->numArestas = g->inicioAdj[n];
+            g->adjacentes = (int *)malloc((g->numArestas + 1) * sizeof(int));
+            if (!g->adjacentes) {
+                free(ultimaOrigem);
+                LiberarGrafoPlano(g);
+                return NULL;
+            }
+        }
+    }
+
+    free(ultimaOrigem);
+    return g;
+}
+
+/**
+ * @brief Procura o índice do vértice com as coordenadas dadas.
+ * 
+ * @param g Grafo plano.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return int Índice do vértice, ou -1 se não existir.
+ */
+int ProcurarVertice(const GrafoPlano *g, Coordenada x, Coordenada y) {
+    uint64_t v;
+    if (!g || !ProcurarTabela(&g->indice, x, y, &v)) return -1;
+    return (int)v;
+}
+
+/**
+ * @brief Liberta o grafo plano (as antenas originais não são alteradas).
+ * 
+ * @param g Grafo plano.
+ */
+void LiberarGrafoPlano(GrafoPlano *g) {
+    if (!g) return;
+    free(g->inicioAdj);
+    free(g->adjacentes);
+    free(g->x);
+    free(g->y);
+    free(g->frequencia);
+    free(g->antenas);
+    LiberarTabela(&g->indice);
+    free(g);
+}
+
+#pragma endregion
+
+#pragma region BFS paralela
+
+/// Passa para bottom-up quando as arestas da fronteira excedem 1/ALFA das arestas por explorar.
+#define ALFA_BFS 14
+/// Volta a top-down quando a fronteira tem menos de 1/BETA dos vértices.
+#define BETA_BFS 24
+
+/**
+ * @brief Arranque dos fios que trabalham por barreiras (BFS e ordenação radix).
+ *
+ * As barreiras só são criadas depois de se saber quantos fios arrancaram de facto; até lá os fios esperam aqui.
+ */
+typedef struct ArranqueFios {
+    pthread_mutex_t trinco;
+    pthread_cond_t pronto;
+    bool barreirasProntas;
+} ArranqueFios;
+
+/**
+ * @brief Arranca os fios 1 a numThreads - 1 (o fio 0 é quem chama) e cria as barreiras para os que arrancaram.
+ *
+ * @param a Estado de arranque, partilhado com os fios.
+ * @param ids Recebe os identificadores dos fios criados.
+ * @param corpo Função de cada fio.
+ * @param fios Argumentos dos fios, com tamanhoFio bytes cada (o fio i recebe o i-ésimo).
+ * @param tamanhoFio Tamanho de cada argumento.
+ * @param numThreads Fios pedidos; recebe os que ficaram a trabalhar, antes de os fios poderem avançar.
+ * @param barreiras Barreiras a criar.
+ * @param numBarreiras Número de barreiras.
+ */
+static void ArrancarFios(ArranqueFios *a, pthread_t *ids, void *(*corpo)(void *), void *fios, size_t tamanhoFio,
+                         int *numThreads, pthread_barrier_t *const *barreiras, int numBarreiras) {
+    pthread_mutex_init(&a->trinco, NULL);
+    pthread_cond_init(&a->pronto, NULL);
+    a->barreirasProntas = false;
+
+    int criados = 1;
+    while (criados < *numThreads &&
+           pthread_create(&ids[criados], NULL, corpo, (char *)fios + (size_t)criados * tamanhoFio) == 0)
+        criados++;
+
+    *numThreads = criados;
+    for (int b = 0; b < numBarreiras; b++) pthread_barrier_init(barreiras[b], NULL, (unsigned)criados);
+
+    pthread_mutex_lock(&a->trinco);
+    a->barreirasProntas = true;
+    pthread_cond_broadcast(&a->pronto);
+    pthread_mutex_unlock(&a->trinco);
+}
+
+/**
+ * @brief Chamada por cada fio arrancado antes de usar as barreiras.
+ *
+ * @param a Estado de arranque.
+ */
+static void EsperarArranque(ArranqueFios *a) {
+    pthread_mutex_lock(&a->trinco);
+    while (!a->barreirasProntas) pthread_cond_wait(&a->pronto, &a->trinco);
+    pthread_mutex_unlock(&a->trinco);
+}
+
+/**
+ * @brief Espera pelos fios arrancados e destrói as barreiras e o estado de arranque.
+ *
+ * @param a Estado de arranque.
+ * @param ids Identificadores dos fios.
+ * @param criados Número de fios, incluindo o fio 0.
+ * @param barreiras Barreiras a destruir.
+ * @param numBarreiras Número de barreiras.
+ */
+static void TerminarFios(ArranqueFios *a, pthread_t *ids, int criados, pthread_barrier_t *const *barreiras, int numBarreiras) {
+    for (int i = 1; i < criados; i++) pthread_join(ids[i], NULL);
+    for (int b = 0; b < numBarreiras; b++) pthread_barrier_destroy(barreiras[b]);
+    pthread_mutex_destroy(&a->trinco);
+    pthread_cond_destroy(&a->pronto);
+}
+
+/**
+ * @brief Estado partilhado pelos fios de execução de uma BFS.
+ */
+typedef struct EstadoBFS {
+    const GrafoPlano *g;
+    int *nivel, *pai;
+    int numThreads;
+
+    int *fronteira;             ///< Vértices do nível atual
+    size_t tamanhoFronteira;
+    uint64_t *mapaFronteira;    ///< Os mesmos vértices em mapa de bits (só no modo bottom-up)
+    int *proxima;               ///< Vértices do nível seguinte
+    size_t tamanhoProxima;      ///< Atualizado atomicamente pelos fios
+    size_t arestasProxima;      ///< Soma dos graus da próxima fronteira (atualizada atomicamente)
+
+    int nivelAtual;
+    bool bottomUp;
+    bool terminado;
+    bool erro;
+    pthread_barrier_t inicioNivel, fimNivel;
+    ArranqueFios arranque;
+} EstadoBFS;
+
+/**
+ * @brief Argumentos de cada fio, com o seu buffer local da próxima fronteira.
+ */
+typedef struct FioBFS {
+    EstadoBFS *e;
+    int id;
+    int *local;
+    size_t tamanhoLocal, capacidadeLocal;
+} FioBFS;
+
+static bool AcrescentarLocal(FioBFS *f, int v) {
+    if (f->tamanhoLocal == f->capacidadeLocal) {
+        size_t nova = f->capacidadeLocal ? 2 * f->capacidadeLocal : 1024;
+        int *local = (int *)realloc(f->local, nova * sizeof(int));
+        if (!local) return false;
+        f->local = local;
+        f->capacidadeLocal = nova;
+    }
+    f->local[f->tamanhoLocal++] = v;
+    return true;
+}
+
+/**
+ * @brief Passo top-down: cada vértice da fronteira tenta reclamar os vizinhos ainda por visitar.
+ */
+static void PassoTopDown(FioBFS *f) {
+    EstadoBFS *e = f->e;
+    const GrafoPlano *g = e->g;
+    size_t inicio = e->tamanhoFronteira * f->id / e->numThreads;
+    size_t fim = e->tamanhoFronteira * (f->id + 1) / e->numThreads;
+
+    for (size_t i = inicio; i < fim; i++) {
+        int u = e->fronteira[i];
+        for (size_t k = g->inicioAdj[u]; k < g->inicioAdj[u + 1]; k++) {
+            int v = g->adjacentes[k];
+            int livre = -1;
+            if (__atomic_load_n(&e->pai[v], __ATOMIC_RELAXED) != -1) continue;
+            if (!__atomic_compare_exchange_n(&e->pai[v], &livre, u, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) continue;
+
+            e->nivel[v] = e->nivelAtual + 1;
+            if (!AcrescentarLocal(f, v)) __atomic_store_n(&e->erro, true, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Passo bottom-up: cada vértice por visitar procura um vizinho na fronteira.
+ * 
+ * Os vértices são repartidos pelos fios, por isso cada um só escreve nos seus.
+ */
+static void PassoBottomUp(FioBFS *f) {
+    EstadoBFS *e = f->e;
+    const GrafoPlano *g = e->g;
+    int inicio = (int)((size_t)g->numVertices * f->id / e->numThreads);
+    int fim = (int)((size_t)g->numVertices * (f->id + 1) / e->numThreads);
+
+    for (int v = inicio; v < fim; v++) {
+        if (e->pai[v] != -1) continue;
+
+        for (size_t k = g->inicioAdj[v]; k < g->inicioAdj[v + 1]; k++) {
+            int u = g->adjacentes[k];
+            if (e->mapaFronteira[u >> 6] & ((uint64_t)1 << (u & 63))) {
+                e->pai[v] = u;
+                e->nivel[v] = e->nivelAtual + 1;
+                if (!AcrescentarLocal(f, v)) __atomic_store_n(&e->erro, true, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Corpo de cada fio: executa os níveis até a BFS terminar.
+ * 
+ * O fio 0 é o fio que chamou a BFS e, entre níveis, prepara o nível seguinte.
+ */
+static void *TrabalhadorBFS(void *arg) {
+    FioBFS *f = (FioBFS *)arg;
+    EstadoBFS *e = f->e;
+    const GrafoPlano *g = e->g;
+
+    if (f->id != 0) EsperarArranque(&e->arranque);
+
+    for (;;) {
+        pthread_barrier_wait(&e->inicioNivel);
+        if (e->terminado) break;
+
+        f->tamanhoLocal = 0;
+        if (e->bottomUp) PassoBottomUp(f);
+        else PassoTopDown(f);
+
+        // Reserva um intervalo da próxima fronteira e copia para lá o buffer local
+        size_t arestas = 0;
+        for (size_t i = 0; i < f->tamanhoLocal; i++) {
+            int v = f->local[i];
+            arestas += g->inicioAdj[v + 1] - g->inicioAdj[v];
+        }
+        // Um fio que ainda não encontrou vértices não tem buffer local (f->local é NULL)
+        if (f->tamanhoLocal) {
+            size_t base = __atomic_fetch_add(&e->tamanhoProxima, f->tamanhoLocal, __ATOMIC_RELAXED);
+            memcpy(e->proxima + base, f->local, f->tamanhoLocal * sizeof(int));
+            __atomic_fetch_add(&e->arestasProxima, arestas, __ATOMIC_RELAXED);
+        }
+
+        pthread_barrier_wait(&e->fimNivel);
+        if (f->id == 0) break; // O fio 0 volta ao coordenador
+    }
+    return NULL;
+}
+
+/**
+ * @brief BFS paralela por níveis, com escolha em cada nível entre passos top-down e bottom-up.
+ * 
+ * Enquanto a fronteira é pequena, os seus vértices exploram os vizinhos (top-down). Quando a
+ * fronteira cresce (como acontece logo no primeiro nível de um grupo de antenas do mesmo tipo,
+ * que estão todas interligadas), passa a ser mais barato cada vértice por visitar procurar um
+ * pai na fronteira (bottom-up), parando no primeiro que encontrar.
+ * 
+ * @param g Grafo plano.
+ * @param origem Índice do vértice inicial.
+ * @param numThreads Número de fios de execução (1 para sequencial).
+ * @param nivel Recebe o nível de cada vértice (-1 se não for alcançável); numVertices posições.
+ * @param pai Recebe o pai de cada vértice na árvore da BFS (-1 se não for alcançável; a origem é pai de si própria).
+ * @return true Se a busca foi concluída.
+ */
+bool BuscaEmLarguraParalela(const GrafoPlano *g, int origem, int numThreads, int *nivel, int *pai) {
+    if (!g || !nivel || !pai || origem < 0 || origem >= g->numVertices) return false;
+    if (numThreads < 1) numThreads = 1;
+
+    int n = g->numVertices;
+    for (int v = 0; v < n; v++) {
+        nivel[v] = -1;
+        pai[v] = -1;
+    }
+
+    EstadoBFS e;
+    memset(&e, 0, sizeof(e));
+    e.g = g;
+    e.nivel = nivel;
+    e.pai = pai;
+    e.fronteira = (int *)malloc((size_t)n * sizeof(int));
+    e.proxima = (int *)malloc((size_t)n * sizeof(int));
+    e.mapaFronteira = (uint64_t *)calloc(((size_t)n + 63) / 64, sizeof(uint64_t));
+
+    FioBFS *fios = (FioBFS *)calloc((size_t)numThreads, sizeof(FioBFS));
+    pthread_t *ids = (pthread_t *)malloc((size_t)numThreads * sizeof(pthread_t));
+    if (!e.fronteira || !e.proxima || !e.mapaFronteira || !fios || !ids) {
+        free(e.fronteira);
+        free(e.proxima);
+        free(e.mapaFronteira);
+        free(fios);
+        free(ids);
+        return false;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        fios[i].e = &e;
+        fios[i].id = i;
+    }
+    pthread_barrier_t *const barreiras[] = { &e.inicioNivel, &e.fimNivel };
+    e.numThreads = numThreads;
+    ArrancarFios(&e.arranque, ids, TrabalhadorBFS, fios, sizeof(FioBFS), &e.numThreads, barreiras, 2);
+
+    pai[origem] = origem;
+    nivel[origem] = 0;
+    e.fronteira[0] = origem;
+    e.tamanhoFronteira = 1;
+
+    size_t arestasFronteira = g->inicioAdj[origem + 1] - g->inicioAdj[origem];
+    size_t arestasPorExplorar = g->numArestas;
+
+    while (e.tamanhoFronteira > 0 && !e.erro) {
+        // Heurística de Beamer para escolher a direção do passo
+        if (!e.bottomUp && arestasFronteira > arestasPorExplorar / ALFA_BFS) e.bottomUp = true;
+        else if (e.bottomUp && e.tamanhoFronteira < (size_t)n / BETA_BFS) e.bottomUp = false;
+
+        if (e.bottomUp) {
+            memset(e.mapaFronteira, 0, (((size_t)n + 63) / 64) * sizeof(uint64_t));
+            for (size_t i = 0; i < e.tamanhoFronteira; i++) {
+                int u = e.fronteira[i];
+                e.mapaFronteira[u >> 6] |= (uint64_t)1 << (u & 63);
+            }
+        }
+
+        e.tamanhoProxima = 0;
+        e.arestasProxima = 0;
+        TrabalhadorBFS(&fios[0]);
+
+        arestasPorExplorar = arestasPorExplorar > arestasFronteira ? arestasPorExplorar - arestasFronteira : 0;
+        arestasFronteira = e.arestasProxima;
+
+        int *troca = e.fronteira;
+        e.fronteira = e.proxima;
+        e.proxima = troca;
+        e.tamanhoFronteira = e.tamanhoProxima;
+        e.nivelAtual++;
+    }
+    e.terminado = true;
+
+    // Liberta os fios da barreira de início para verem que a busca terminou
+    pthread_barrier_wait(&e.inicioNivel);
+    TerminarFios(&e.arranque, ids, e.numThreads, barreiras, 2);
+    for (int i = 0; i < numThreads; i++) free(fios[i].local);
+    free(fios);
+    free(ids);
+    free(e.fronteira);
+    free(e.proxima);
+    free(e.mapaFronteira);
+    return !e.erro;
+}
+
+#pragma endregion
+
+#pragma region Grafo implícito
+
+/**
+ * @brief Cria o grafo implícito a partir das listas de tipos, sem precisar das listas de adjacentes.
+ * 
+ * @param listaTipos Lista de tipos de antenas.
+ * @return GrafoImplicito* Grafo criado, ou NULL em caso de erro.
+ */
+GrafoImplicito *CriarGrafoImplicito(TipoAntena *listaTipos) {
+    GrafoImplicito *g = (GrafoImplicito *)calloc(1, sizeof(GrafoImplicito));
+    if (!g) return NULL;
+
+    int n = 0, tipos = 0;
+    for (TipoAntena *t = listaTipos; t; t = t->proximo, tipos++)
+        for (Antena *a = t->listaAntenas; a; a = a->proximo) n++;
+
+    g->numVertices = n;
+    g->numTipos = tipos;
+    g->inicioTipo = (int *)malloc(((size_t)tipos + 1) * sizeof(int));
+    g->tipoVertice = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    g->x = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    g->y = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    g->frequencia = (char *)malloc((size_t)n + 1);
+    g->antenas = (Antena **)malloc(((size_t)n + 1) * sizeof(Antena *));
+    if (!g->inicioTipo || !g->tipoVertice || !g->x || !g->y || !g->frequencia || !g->antenas ||
+        !IniciarTabela(&g->indice, (size_t)n)) {
+        LiberarGrafoImplicito(g);
+        return NULL;
+    }
+
+    int v = 0, k = 0;
+    for (TipoAntena *t = listaTipos; t; t = t->proximo, k++) {
+        g->inicioTipo[k] = v;
+        for (Antena *a = t->listaAntenas; a; a = a->proximo, v++) {
+            g->tipoVertice[v] = k;
+            g->x[v] = a->x;
+            g->y[v] = a->y;
+            g->frequencia[v] = a->frequencia;
+            g->antenas[v] = a;
+            if (!InserirTabela(&g->indice, a->x, a->y, (uint64_t)v)) {
+                LiberarGrafoImplicito(g);
+                return NULL;
+            }
+        }
+    }
+    g->inicioTipo[tipos] = v;
+    return g;
+}
+
+/**
+ * @brief Procura o índice do vértice com as coordenadas dadas.
+ * 
+ * @param g Grafo implícito.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return int Índice do vértice, ou -1 se não existir.
+ */
+int ProcurarVerticeImplicito(const GrafoImplicito *g, Coordenada x, Coordenada y) {
+    uint64_t v;
+    if (!g || !ProcurarTabela(&g->indice, x, y, &v)) return -1;
+    return (int)v;
+}
+
+/**
+ * @brief Componente conexa de um vértice, em O(1): é o grupo do seu tipo.
+ * 
+ * @param g Grafo implícito.
+ * @param v Índice do vértice.
+ * @return int Identificador da componente, ou -1 se o vértice não existir.
+ */
+int ComponenteImplicita(const GrafoImplicito *g, int v) {
+    if (!g || v < 0 || v >= g->numVertices) return -1;
+    return g->tipoVertice[v];
+}
+
+/**
+ * @brief Número de componentes conexas: um por cada tipo com antenas.
+ * 
+ * @param g Grafo implícito.
+ * @return int Número de componentes.
+ */
+int ContarComponentesImplicitas(const GrafoImplicito *g) {
+    int componentes = 0;
+    for (int t = 0; g && t < g->numTipos; t++) {
+        if (g->inicioTipo[t + 1] > g->inicioTipo[t]) componentes++;
+    }
+    return componentes;
+}
+
+/**
+ * @brief Verifica em O(1) se existe caminho entre dois vértices.
+ * 
+ * @param g Grafo implícito.
+ * @param origem Índice do vértice de origem.
+ * @param destino Índice do vértice de destino.
+ * @return true Se ambos pertencem ao mesmo grupo.
+ */
+bool ExisteCaminhoImplicito(const GrafoImplicito *g, int origem, int destino) {
+    int c = ComponenteImplicita(g, origem);
+    return c >= 0 && c == ComponenteImplicita(g, destino);
+}
+
+/**
+ * @brief Ordem de visita a partir de um vértice, em O(k) para um grupo de k antenas.
+ * 
+ * Num grupo em que todos estão interligados, a BFS visita a origem e depois os restantes
+ * pela ordem dos adjacentes; a DFS, ao descer sempre para o primeiro vizinho por visitar,
+ * produz a mesma sequência. A origem fica no nível 0 e os restantes no nível 1.
+ * 
+ * @param g Grafo implícito.
+ * @param origem Índice do vértice inicial.
+ * @param ordem Recebe os índices dos vértices visitados (espaço para o tamanho do grupo).
+ * @return int Número de vértices visitados, ou 0 se a origem não existir.
+ */
+int OrdemVisitaImplicita(const GrafoImplicito *g, int origem, int *ordem) {
+    int t = ComponenteImplicita(g, origem);
+    if (t < 0) return 0;
+
+    int n = 0;
+    ordem[n++] = origem;
+    for (int v = g->inicioTipo[t]; v < g->inicioTipo[t + 1]; v++) {
+        if (v != origem) ordem[n++] = v;
+    }
+    return n;
+}
+
+/**
+ * @brief Converte a ordem de visita implícita numa lista de resultados, como a das buscas sobre listas.
+ */
+static ResultadoDFS *ResultadosImplicitos(const GrafoImplicito *g, Coordenada x, Coordenada y) {
+    int origem = ProcurarVerticeImplicito(g, x, y);
+    if (origem < 0) return NULL;
+
+    int t = g->tipoVertice[origem];
+    int *ordem = (int *)malloc((size_t)(g->inicioTipo[t + 1] - g->inicioTipo[t]) * sizeof(int));
+    if (!ordem) return NULL;
+
+    int n = OrdemVisitaImplicita(g, origem, ordem);
+    ResultadoDFS *lista = NULL, *cauda = NULL;
+    for (int i = 0; i < n; i++) {
+        ResultadoDFS *novo = (ResultadoDFS *)malloc(sizeof(ResultadoDFS));
+        if (!novo) {
+            LiberarResultados(lista);
+            lista = NULL;
+            break;
+        }
+        novo->x = g->x[ordem[i]];
+        novo->y = g->y[ordem[i]];
+        novo->antena = g->antenas[ordem[i]];
+        novo->proximo = NULL;
+
+        if (cauda) cauda->proximo = novo;
+        else lista = novo;
+        cauda = novo;
+    }
+
+    free(ordem);
+    return lista;
+}
+
+/**
+ * @brief DFS sobre o grafo implícito, sem listas de adjacentes nem limite de tamanho da matriz.
+ * 
+ * @param g Grafo implícito.
+ * @param x Coordenada X inicial.
+ * @param y Coordenada Y inicial.
+ * @return ResultadoDFS* Lista com a ordem de visita, ou NULL se a antena não existir.
+ */
+ResultadoDFS *BuscaEmProfundidadeImplicita(const GrafoImplicito *g, Coordenada x, Coordenada y) {
+    return ResultadosImplicitos(g, x, y);
+}
+
+/**
+ * @brief BFS sobre o grafo implícito, sem listas de adjacentes nem limite de tamanho da matriz.
+ * 
+ * @param g Grafo implícito.
+ * @param x Coordenada X inicial.
+ * @param y Coordenada Y inicial.
+ * @return ResultadoDFS* Lista com a ordem de visita, ou NULL se a antena não existir.
+ */
+ResultadoDFS *BuscaEmLarguraImplicita(const GrafoImplicito *g, Coordenada x, Coordenada y) {
+    return ResultadosImplicitos(g, x, y);
+}
+
+/**
+ * @brief Calcula as posições distintas com efeito nefasto, como CalcularEfeitosNefastos, a partir dos grupos do grafo.
+ * 
+ * Os pares de cada tipo são percorridos sobre os vetores de coordenadas em vez das listas de antenas.
+ * 
+ * @param g Grafo implícito.
+ * @param maxLin Número de linhas da matriz (<= 0 para não limitar).
+ * @param maxCol Número de colunas da matriz (<= 0 para não limitar).
+ * @return EfeitoNefasto* Lista ordenada por (x, y), ou NULL se não houver efeitos ou faltar memória.
+ */
+EfeitoNefasto *CalcularEfeitosImplicitos(const GrafoImplicito *g, Coordenada maxLin, Coordenada maxCol) {
+    size_t numPares = 0;
+    for (int t = 0; t < g->numTipos; t++) {
+        size_t k = (size_t)(g->inicioTipo[t + 1] - g->inicioTipo[t]);
+        numPares += k * (k - 1) / 2;
+    }
+
+    AcumuladorEfeitos efeitos;
+    if (!IniciarAcumuladorEfeitos(&efeitos, maxLin, maxCol, numPares)) return NULL;
+
+    bool ok = true;
+    for (int t = 0; ok && t < g->numTipos; t++) {
+        for (int i = g->inicioTipo[t]; ok && i < g->inicioTipo[t + 1]; i++) {
+            for (int j = i + 1; ok && j < g->inicioTipo[t + 1]; j++) {
+                if (g->x[i] == g->x[j] && g->y[i] == g->y[j]) continue;
+                ok = AcumularEfeitosPar(&efeitos, g->x[i], g->y[i], g->x[j], g->y[j]);
+            }
+        }
+    }
+
+    EfeitoNefasto *lista = ok ? ListaEfeitosAcumulados(&efeitos) : NULL;
+    LiberarAcumuladorEfeitos(&efeitos);
+    return lista;
+}
+
+/**
+ * @brief Liberta o grafo implícito (as antenas originais não são alteradas).
+ * 
+ * @param g Grafo implícito.
+ */
+void LiberarGrafoImplicito(GrafoImplicito *g) {
+    if (!g) return;
+    free(g->inicioTipo);
+    free(g->tipoVertice);
+    free(g->x);
+    free(g->y);
+    free(g->frequencia);
+    free(g->antenas);
+    LiberarTabela(&g->indice);
+    free(g);
+}
+
+#pragma endregion
+
+#pragma region Árvore de cobertura mínima
+
+/**
+ * @brief Ligação por ordenar: chave (quadrado da distância, ver ChaveDistancia) e extremos.
+ *
+ * A reordenação espacial usa a mesma estrutura, com o código de Morton na chave e o vértice na origem.
+ */
+typedef struct ArestaOrdenar {
+    uint64_t chave;
+    int origem, destino;
+} ArestaOrdenar;
+
+/// Bits de cada dígito da ordenação radix.
+#define BITS_DIGITO 8
+/// Número de valores de cada dígito.
+#define NUM_DIGITOS (1 << BITS_DIGITO)
+/// Ligações por fio abaixo das quais não compensa usar mais fios na ordenação.
+#define ARESTAS_POR_FIO 16384
+
+/**
+ * @brief Estado partilhado pelos fios da ordenação radix.
+ */
+typedef struct EstadoRadix {
+    ArestaOrdenar *origem, *destino;
+    size_t n;
+    int numThreads, numPassagens;
+    size_t *contagens;          ///< NUM_DIGITOS por fio: contagens e depois posições de escrita
+    pthread_barrier_t barreira;
+    ArranqueFios arranque;
+} EstadoRadix;
+
+/**
+ * @brief Argumentos de cada fio da ordenação.
+ */
+typedef struct FioRadix {
+    EstadoRadix *e;
+    int id;
+} FioRadix;
+
+/**
+ * @brief Corpo de cada fio: em cada passagem conta os dígitos da sua parte, espera pelas posições
+ * calculadas pelo fio 0 e distribui os seus elementos.
+ *
+ * Dentro de cada dígito, os elementos do fio i ficam antes dos do fio i+1, por isso a ordenação é estável.
+ */
+static void *TrabalhadorRadix(void *arg) {
+    FioRadix *f = (FioRadix *)arg;
+    EstadoRadix *e = f->e;
+
+    if (f->id != 0) EsperarArranque(&e->arranque);
+
+    size_t inicio = e->n * f->id / e->numThreads;
+    size_t fim = e->n * (f->id + 1) / e->numThreads;
+    size_t *minhas = e->contagens + (size_t)f->id * NUM_DIGITOS;
+    ArestaOrdenar *de = e->origem, *para = e->destino;
+
+    for (int p = 0; p < e->numPassagens; p++) {
+        int deslocamento = p * BITS_DIGITO;
+        memset(minhas, 0, NUM_DIGITOS * sizeof(size_t));
+        for (size_t i = inicio; i < fim; i++) minhas[(de[i].chave >> deslocamento) & (NUM_DIGITOS - 1)]++;
+        pthread_barrier_wait(&e->barreira);
+
+        if (f->id == 0) {
+            size_t soma = 0;
+            for (int d = 0; d < NUM_DIGITOS; d++)
+                for (int t = 0; t < e->numThreads; t++) {
+                    size_t c = e->contagens[(size_t)t * NUM_DIGITOS + d];
+                    e->contagens[(size_t)t * NUM_DIGITOS + d] = soma;
+                    soma += c;
+                }
+        }
+        pthread_barrier_wait(&e->barreira);
+
+        for (size_t i = inicio; i < fim; i++) para[minhas[(de[i].chave >> deslocamento) & (NUM_DIGITOS - 1)]++] = de[i];
+        pthread_barrier_wait(&e->barreira);
+
+        ArestaOrdenar *troca = de;
+        de = para;
+        para = troca;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Ordena as ligações pela chave com radix LSD paralela, fazendo só as passagens de que a maior chave precisa.
+ *
+ * @param a Ligações a ordenar.
+ * @param auxiliar Vetor com o mesmo tamanho, usado entre passagens.
+ * @param n Número de ligações.
+ * @param numThreads Número máximo de fios de execução.
+ * @return ArestaOrdenar* O vetor (a ou auxiliar) que ficou ordenado, ou NULL em caso de erro.
+ */
+static ArestaOrdenar *OrdenarArestasRadix(ArestaOrdenar *a, ArestaOrdenar *auxiliar, size_t n, int numThreads) {
+    uint64_t maior = 0;
+    for (size_t i = 0; i < n; i++)
+        if (a[i].chave > maior) maior = a[i].chave;
+
+    int passagens = 0;
+    while (passagens * BITS_DIGITO < 64 && (maior >> (passagens * BITS_DIGITO)) != 0) passagens++;
+    if (passagens == 0) return a;
+
+    if ((size_t)numThreads > n / ARESTAS_POR_FIO + 1) numThreads = (int)(n / ARESTAS_POR_FIO + 1);
+
+    EstadoRadix e;
+    memset(&e, 0, sizeof(e));
+    e.origem = a;
+    e.destino = auxiliar;
+    e.n = n;
+    e.numPassagens = passagens;
+    e.contagens = (size_t *)malloc((size_t)numThreads * NUM_DIGITOS * sizeof(size_t));
+    FioRadix *fios = (FioRadix *)calloc((size_t)numThreads, sizeof(FioRadix));
+    pthread_t *ids = (pthread_t *)malloc((size_t)numThreads * sizeof(pthread_t));
+    if (!e.contagens || !fios || !ids) {
+        free(e.contagens);
+        free(fios);
+        free(ids);
+        return NULL;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        fios[i].e = &e;
+        fios[i].id = i;
+    }
+    pthread_barrier_t *const barreiras[] = { &e.barreira };
+    e.numThreads = numThreads;
+    ArrancarFios(&e.arranque, ids, TrabalhadorRadix, fios, sizeof(FioRadix), &e.numThreads, barreiras, 1);
+
+    TrabalhadorRadix(&fios[0]);
+    TerminarFios(&e.arranque, ids, e.numThreads, barreiras, 1);
+    free(e.contagens);
+    free(fios);
+    free(ids);
+    return (passagens % 2 == 0) ? a : auxiliar;
+}
+
+/**
+ * @brief Raiz do conjunto de v, encurtando o caminho pelo meio (cada nó passa a apontar para o avô).
+ */
+static int RaizConjunto(int *pai, int v) {
+    while (pai[v] != v) {
+        pai[v] = pai[pai[v]];
+        v = pai[v];
+    }
+    return v;
+}
+
+/**
+ * @brief Quadrado da distância entre dois vértices.
+ *
+ * Com coordenadas até ±COORDENADA_MAX as diferenças cabem em 64 bits, mas o quadrado não: é calculado
+ * em double, exato enquanto for menor do que 2^53.
+ */
+static inline double Distancia2(Coordenada x1, Coordenada y1, Coordenada x2, Coordenada y2) {
+    double dx = (double)(x1 - x2), dy = (double)(y1 - y2);
+    return dx * dx + dy * dy;
+}
+
+/// Diferenças de coordenadas abaixo deste valor dão um quadrado da distância exato em 63 bits.
+#define DIFERENCA_EXATA ((Coordenada)1 << 31)
+
+/**
+ * @brief Chave de ordenação de uma ligação.
+ *
+ * Se exata, é o quadrado inteiro da distância (as diferenças têm de estar abaixo de DIFERENCA_EXATA);
+ * senão é a representação binária do quadrado em double, que para valores positivos tem a mesma ordem.
+ */
+static inline uint64_t ChaveDistancia(const GrafoPlano *g, int u, int v, bool exata) {
+    if (exata) {
+        Coordenada dx = g->x[u] - g->x[v], dy = g->y[u] - g->y[v];
+        return (uint64_t)(dx * dx) + (uint64_t)(dy * dy);
+    }
+    double d2 = Distancia2(g->x[u], g->y[u], g->x[v], g->y[v]);
+    uint64_t chave;
+    memcpy(&chave, &d2, sizeof(chave));
+    return chave;
+}
+
+/**
+ * @brief Acrescenta uma ligação à árvore e soma a sua distância ao custo.
+ */
+static void AcrescentarLigacao(ArvoreCobertura *arvore, int origem, int destino, double distancia2) {
+    ArestaArvore *a = &arvore->arestas[arvore->numArestas++];
+    a->origem = origem;
+    a->destino = destino;
+    a->distancia2 = distancia2;
+    arvore->custo += sqrt(distancia2);
+}
+
+/**
+ * @brief Árvore de cobertura mínima pelo algoritmo de Kruskal, sobre as ligações do grafo plano.
+ *
+ * Cada ligação é considerada uma vez (origem < destino). As ligações são ordenadas pela distância com
+ * radix paralela e juntadas com union-find (compressão de caminhos e união por tamanho). Se o grafo
+ * tiver as antenas de cada tipo interligadas, o resultado é a árvore mínima de cada frequência.
+ *
+ * @param g Grafo plano.
+ * @param numThreads Número de fios de execução da ordenação (1 para sequencial).
+ * @param arvore Recebe a árvore (ou floresta) mínima; liberta-se com LiberarArvoreCobertura.
+ * @return true Se a árvore foi calculada.
+ */
+bool ArvoreMinimaKruskal(const GrafoPlano *g, int numThreads, ArvoreCobertura *arvore) {
+    if (!g || !arvore) return false;
+    if (numThreads < 1) numThreads = 1;
+    memset(arvore, 0, sizeof(*arvore));
+
+    int n = g->numVertices;
+    size_t m = g->numArestas / 2 + 1;
+    ArestaOrdenar *ligacoes = (ArestaOrdenar *)malloc(m * sizeof(ArestaOrdenar));
+    ArestaOrdenar *auxiliar = (ArestaOrdenar *)malloc(m * sizeof(ArestaOrdenar));
+    int *pai = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    int *tamanho = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    arvore->arestas = (ArestaArvore *)malloc(((size_t)n + 1) * sizeof(ArestaArvore));
+    bool ok = ligacoes && auxiliar && pai && tamanho && arvore->arestas;
+
+    // As chaves são inteiras (e a radix faz menos passagens) se todas as diferenças de coordenadas o permitirem
+    Coordenada minX = n > 0 ? g->x[0] : 0, maxX = minX, minY = n > 0 ? g->y[0] : 0, maxY = minY;
+    for (int u = 1; u < n; u++) {
+        if (g->x[u] < minX) minX = g->x[u];
+        if (g->x[u] > maxX) maxX = g->x[u];
+        if (g->y[u] < minY) minY = g->y[u];
+        if (g->y[u] > maxY) maxY = g->y[u];
+    }
+    bool exata = maxX - minX < DIFERENCA_EXATA && maxY - minY < DIFERENCA_EXATA;
+
+    size_t numLigacoes = 0;
+    for (int u = 0; ok && u < n; u++) {
+        pai[u] = u;
+        tamanho[u] = 1;
+        for (size_t k = g->inicioAdj[u]; k < g->inicioAdj[u + 1]; k++) {
+            int v = g->adjacentes[k];
+            if (v <= u) continue;
+            // Num grafo construído com adjacências só num sentido, o arco v->u pode não existir
+            if (numLigacoes == m) {
+                m *= 2;
+                ArestaOrdenar *mais = (ArestaOrdenar *)realloc(ligacoes, m * sizeof(ArestaOrdenar));
+                ArestaOrdenar *maisAux = mais ? (ArestaOrdenar *)realloc(auxiliar, m * sizeof(ArestaOrdenar)) : NULL;
+                if (mais) ligacoes = mais;
+                if (maisAux) auxiliar = maisAux;
+                if (!mais || !maisAux) {
+                    ok = false;
+                    break;
+                }
+            }
+            ligacoes[numLigacoes].chave = ChaveDistancia(g, u, v, exata);
+            ligacoes[numLigacoes].origem = u;
+            ligacoes[numLigacoes].destino = v;
+            numLigacoes++;
+        }
+    }
+
+    ArestaOrdenar *ordenadas = ok ? OrdenarArestasRadix(ligacoes, auxiliar, numLigacoes, numThreads) : NULL;
+    ok = ok && ordenadas;
+
+    for (size_t i = 0; ok && i < numLigacoes && arvore->numArestas < n - 1; i++) {
+        int ru = RaizConjunto(pai, ordenadas[i].origem);
+        int rv = RaizConjunto(pai, ordenadas[i].destino);
+        if (ru == rv) continue;
+
+        if (tamanho[ru] < tamanho[rv]) {
+            int troca = ru;
+            ru = rv;
+            rv = troca;
+        }
+        pai[rv] = ru;
+        tamanho[ru] += tamanho[rv];
+        double distancia2;
+        if (exata) {
+            distancia2 = (double)ordenadas[i].chave;
+        } else {
+            memcpy(&distancia2, &ordenadas[i].chave, sizeof(distancia2));
+        }
+        AcrescentarLigacao(arvore, ordenadas[i].origem, ordenadas[i].destino, distancia2);
+    }
+
+    free(ligacoes);
+    free(auxiliar);
+    free(pai);
+    free(tamanho);
+    if (!ok) LiberarArvoreCobertura(arvore);
+    return ok;
+}
+
+/**
+ * @brief Prim sobre o grafo completo dos vértices [inicio, fim), em O(k²) sem guardar ligações.
+ *
+ * melhor[v] é a menor distância de v à árvore e ligacao[v] o vértice da árvore que a dá.
+ */
+static void PrimIntervalo(const GrafoImplicito *g, int inicio, int fim, double *melhor, int *ligacao, ArvoreCobertura *arvore) {
+    if (fim - inicio < 2) return;
+
+    for (int v = inicio; v < fim; v++) {
+        melhor[v] = HUGE_VAL;
+        ligacao[v] = -1;
+    }
+
+    int atual = inicio;
+    melhor[atual] = -1;  // -1 marca os vértices já na árvore
+    for (int passo = 1; passo < fim - inicio; passo++) {
+        int escolhido = -1;
+        double menor = HUGE_VAL;
+        for (int v = inicio; v < fim; v++) {
+            if (melhor[v] < 0) continue;
+            double d = Distancia2(g->x[atual], g->y[atual], g->x[v], g->y[v]);
+            if (d < melhor[v]) {
+                melhor[v] = d;
+                ligacao[v] = atual;
+            }
+            if (melhor[v] < menor) {
+                menor = melhor[v];
+                escolhido = v;
+            }
+        }
+
+        AcrescentarLigacao(arvore, ligacao[escolhido], escolhido, menor);
+        melhor[escolhido] = -1;
+        atual = escolhido;
+    }
+}
+
+/**
+ * @brief Árvore de cobertura mínima pelo algoritmo de Prim, sobre o grafo completo implícito.
+ *
+ * Não precisa de listas de ligações: as distâncias são calculadas à medida que são precisas,
+ * com memória O(n) e tempo O(n²) em cada grupo.
+ *
+ * @param g Grafo implícito.
+ * @param porTipo Se true, calcula a árvore mínima das antenas de cada tipo (uma floresta);
+ *                se false, a árvore mínima global que liga todas as antenas.
+ * @param arvore Recebe a árvore mínima; liberta-se com LiberarArvoreCobertura.
+ * @return true Se a árvore foi calculada.
+ */
+bool ArvoreMinimaPrim(const GrafoImplicito *g, bool porTipo, ArvoreCobertura *arvore) {
+    if (!g || !arvore) return false;
+    memset(arvore, 0, sizeof(*arvore));
+
+    int n = g->numVertices;
+    double *melhor = (double *)malloc(((size_t)n + 1) * sizeof(double));
+    int *ligacao = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    arvore->arestas = (ArestaArvore *)malloc(((size_t)n + 1) * sizeof(ArestaArvore));
+    if (!melhor || !ligacao || !arvore->arestas) {
+        free(melhor);
+        free(ligacao);
+        LiberarArvoreCobertura(arvore);
+        return false;
+    }
+
+    if (porTipo) {
+        for (int t = 0; t < g->numTipos; t++) PrimIntervalo(g, g->inicioTipo[t], g->inicioTipo[t + 1], melhor, ligacao, arvore);
+    } else {
+        PrimIntervalo(g, 0, n, melhor, ligacao, arvore);
+    }
+
+    free(melhor);
+    free(ligacao);
+    return true;
+}
+
+/**
+ * @brief Liberta as ligações de uma árvore de cobertura e deixa-a vazia.
+ *
+ * @param arvore Árvore de cobertura.
+ */
+void LiberarArvoreCobertura(ArvoreCobertura *arvore) {
+    if (!arvore) return;
+    free(arvore->arestas);
+    arvore->arestas = NULL;
+    arvore->numArestas = 0;
+    arvore->custo = 0;
+}
+
+#pragma endregion
+
+#pragma region Resiliência
+
+/**
+ * @brief Pontos de articulação, pontes e componentes biconexas pelo algoritmo de Tarjan, em O(V+E).
+ *
+ * A busca em profundidade é iterativa (com pilha explícita e a posição de cada vértice na sua lista
+ * de adjacentes), para grafos grandes não esgotarem a pilha de chamadas. O grafo é tratado como não
+ * dirigido: espera-se que cada ligação exista nos dois sentidos, como em InterligarAntenasMesmoTipo.
+ *
+ * @param g Grafo plano.
+ * @param r Recebe o resultado; liberta-se com LiberarResultadoResiliencia.
+ * @return true Se a análise foi concluída.
+ */
+bool AnalisarResiliencia(const GrafoPlano *g, ResultadoResiliencia *r) {
+    if (!g || !r) return false;
+    memset(r, 0, sizeof(*r));
+
+    int n = g->numVertices;
+    size_t m = g->numArestas;
+    int *descoberta = (int *)malloc(((size_t)n + 1) * sizeof(int));   // Ordem de descoberta (-1 por visitar)
+    int *baixo = (int *)malloc(((size_t)n + 1) * sizeof(int));        // Menor descoberta alcançável pela subárvore
+    int *pai = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    size_t *seguinte = (size_t *)malloc(((size_t)n + 1) * sizeof(size_t)); // Próximo adjacente a explorar
+    int *pilha = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    bool *articulacao = (bool *)calloc((size_t)n + 1, sizeof(bool));
+    LigacaoGrafo *pilhaLigacoes = (LigacaoGrafo *)malloc((m + 1) * sizeof(LigacaoGrafo));
+
+    // Cada ligação não dirigida é empilhada uma vez, por isso m chega para as componentes e para as pontes
+    r->pontes = (LigacaoGrafo *)malloc((m + 1) * sizeof(LigacaoGrafo));
+    r->ligacoesComponente = (LigacaoGrafo *)malloc((m + 1) * sizeof(LigacaoGrafo));
+    r->inicioComponente = (int *)malloc((m + 2) * sizeof(int));
+    r->articulacoes = (int *)malloc(((size_t)n + 1) * sizeof(int));
+
+    bool ok = descoberta && baixo && pai && seguinte && pilha && articulacao && pilhaLigacoes &&
+              r->pontes && r->ligacoesComponente && r->inicioComponente && r->articulacoes;
+
+    for (int v = 0; ok && v < n; v++) descoberta[v] = -1;
+
+    int tempo = 0;
+    size_t topoLigacoes = 0, numLigacoes = 0;
+    for (int raiz = 0; ok && raiz < n; raiz++) {
+        if (descoberta[raiz] != -1) continue;
+
+        int topo = 0, filhosRaiz = 0;
+        pilha[topo++] = raiz;
+        descoberta[raiz] = baixo[raiz] = tempo++;
+        pai[raiz] = -1;
+        seguinte[raiz] = g->inicioAdj[raiz];
+
+        while (topo > 0) {
+            int v = pilha[topo - 1];
+            if (seguinte[v] < g->inicioAdj[v + 1]) {
+                int w = g->adjacentes[seguinte[v]++];
+                if (descoberta[w] == -1) {
+                    // Ligação da árvore: desce para w
+                    pai[w] = v;
+                    descoberta[w] = baixo[w] = tempo++;
+                    seguinte[w] = g->inicioAdj[w];
+                    pilhaLigacoes[topoLigacoes++] = (LigacaoGrafo){ v, w };
+                    pilha[topo++] = w;
+                    if (v == raiz) filhosRaiz++;
+                } else if (w != pai[v] && descoberta[w] < descoberta[v]) {
+                    // Ligação para trás, até um antepassado
+                    if (descoberta[w] < baixo[v]) baixo[v] = descoberta[w];
+                    pilhaLigacoes[topoLigacoes++] = (LigacaoGrafo){ v, w };
+                }
+                continue;
+            }
+
+            // Todos os adjacentes de v explorados: volta ao pai
+            topo--;
+            int p = pai[v];
+            if (p < 0) continue;
+            if (baixo[v] < baixo[p]) baixo[p] = baixo[v];
+
+            if (baixo[v] > descoberta[p]) r->pontes[r->numPontes++] = (LigacaoGrafo){ p, v };
+            if (baixo[v] >= descoberta[p]) {
+                // A subárvore de v só chega a p: as ligações empilhadas desde (p, v) formam uma componente
+                if (p != raiz) articulacao[p] = true;
+                r->inicioComponente[r->numComponentes++] = (int)numLigacoes;
+                LigacaoGrafo l;
+                do {
+                    l = pilhaLigacoes[--topoLigacoes];
+                    r->ligacoesComponente[numLigacoes++] = l;
+                } while (l.origem != p || l.destino != v);
+            }
+        }
+        if (filhosRaiz > 1) articulacao[raiz] = true;
+    }
+
+    if (ok) {
+        r->inicioComponente[r->numComponentes] = (int)numLigacoes;
+        for (int v = 0; v < n; v++)
+            if (articulacao[v]) r->articulacoes[r->numArticulacoes++] = v;
+    }
+
+    free(descoberta);
+    free(baixo);
+    free(pai);
+    free(seguinte);
+    free(pilha);
+    free(articulacao);
+    free(pilhaLigacoes);
+    if (!ok) LiberarResultadoResiliencia(r);
+    return ok;
+}
+
+/**
+ * @brief Liberta o resultado da análise de resiliência e deixa-o vazio.
+ *
+ * @param r Resultado da análise.
+ */
+void LiberarResultadoResiliencia(ResultadoResiliencia *r) {
+    if (!r) return;
+    free(r->articulacoes);
+    free(r->pontes);
+    free(r->inicioComponente);
+    free(r->ligacoesComponente);
+    memset(r, 0, sizeof(*r));
+}
+
+#pragma endregion
+
+#pragma region Centralidade de intermediação
+
+/**
+ * @brief Entrada do heap da Dijkstra (com entradas desatualizadas, ignoradas ao sair).
+ */
+typedef struct EntradaHeap {
+    double distancia;
+    int vertice;
+} EntradaHeap;
+
+/**
+ * @brief Buffers de um fio, reservados uma vez e reutilizados em todas as origens.
+ */
+typedef struct RascunhoCaminhos {
+    double *distancia;
+    double *caminhos;           ///< Número de caminhos mínimos desde a origem
+    double *dependencia;
+    int *ordem;                 ///< Vértices por ordem de distância não decrescente
+    EntradaHeap *heap;          ///< Só na versão ponderada
+    double *acumulado;          ///< Centralidade parcial do fio
+} RascunhoCaminhos;
+
+/**
+ * @brief Estado partilhado pelos fios: cada um reserva a próxima origem com um contador atómico.
+ */
+typedef struct EstadoCentralidade {
+    const GrafoPlano *g;
+    bool ponderado;
+    const int *origens;
+    int numOrigens;
+    int seguinte;
+    bool erro;
+} EstadoCentralidade;
+
+typedef struct FioCentralidade {
+    EstadoCentralidade *e;
+    RascunhoCaminhos r;
+} FioCentralidade;
+
+static inline double PesoLigacao(const GrafoPlano *g, int u, int v) {
+    return sqrt(Distancia2(g->x[u], g->y[u], g->x[v], g->y[v]));
+}
+
+/**
+ * @brief Compara distâncias ponderadas com tolerância relativa: somas das mesmas distâncias por outra ordem
+ * podem diferir no último bit, e os caminhos empatados têm de contar como empatados.
+ */
+static inline bool MesmaDistancia(double a, double b) {
+    return fabs(a - b) <= 1e-9 * (a > b ? a : b);
+}
+
+static void SubirHeap(EntradaHeap *h, size_t i) {
+    EntradaHeap e = h[i];
+    while (i > 0 && h[(i - 1) / 2].distancia > e.distancia) {
+        h[i] = h[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h[i] = e;
+}
+
+static EntradaHeap RetirarHeap(EntradaHeap *h, size_t *tamanho) {
+    EntradaHeap topo = h[0], e = h[--*tamanho];
+    size_t i = 0;
+    for (;;) {
+        size_t filho = 2 * i + 1;
+        if (filho >= *tamanho) break;
+        if (filho + 1 < *tamanho && h[filho + 1].distancia < h[filho].distancia) filho++;
+        if (h[filho].distancia >= e.distancia) break;
+        h[i] = h[filho];
+        i = filho;
+    }
+    if (*tamanho > 0) h[i] = e;
+    return topo;
+}
+
+/**
+ * @brief Caminhos mínimos desde s (BFS ou Dijkstra); devolve quantos vértices ficaram em r->ordem.
+ */
+static int CaminhosMinimos(const GrafoPlano *g, bool ponderado, int s, RascunhoCaminhos *r) {
+    int n = g->numVertices, visitados = 0;
+    for (int v = 0; v < n; v++) {
+        r->distancia[v] = -1;
+        r->caminhos[v] = 0;
+    }
+    r->distancia[s] = 0;
+    r->caminhos[s] = 1;
+
+    if (!ponderado) {
+        // A própria ordem serve de fila: os vértices entram por ordem de distância
+        r->ordem[visitados++] = s;
+        for (int i = 0; i < visitados; i++) {
+            int v = r->ordem[i];
+            for (size_t k = g->inicioAdj[v]; k < g->inicioAdj[v + 1]; k++) {
+                int w = g->adjacentes[k];
+                if (r->distancia[w] < 0) {
+                    r->distancia[w] = r->distancia[v] + 1;
+                    r->ordem[visitados++] = w;
+                }
+                if (r->distancia[w] == r->distancia[v] + 1) r->caminhos[w] += r->caminhos[v];
+            }
+        }
+        return visitados;
+    }
+
+    size_t tamanho = 0;
+    r->heap[tamanho++] = (EntradaHeap){ 0, s };
+    while (tamanho > 0) {
+        EntradaHeap topo = RetirarHeap(r->heap, &tamanho);
+        int v = topo.vertice;
+        // Só se entra no heap quando a distância melhora, por isso só a última entrada de v está atualizada
+        if (topo.distancia > r->distancia[v]) continue;
+        r->ordem[visitados++] = v;
+
+        for (size_t k = g->inicioAdj[v]; k < g->inicioAdj[v + 1]; k++) {
+            int w = g->adjacentes[k];
+            double alternativa = r->distancia[v] + PesoLigacao(g, v, w);
+            if (r->distancia[w] < 0 || (alternativa < r->distancia[w] && !MesmaDistancia(alternativa, r->distancia[w]))) {
+                r->distancia[w] = alternativa;
+                r->caminhos[w] = r->caminhos[v];
+                r->heap[tamanho++] = (EntradaHeap){ alternativa, w };
+                SubirHeap(r->heap, tamanho - 1);
+            } else if (MesmaDistancia(alternativa, r->distancia[w])) {
+                r->caminhos[w] += r->caminhos[v];
+            }
+        }
+    }
+    return visitados;
+}
+
+/**
+ * @brief Acumula as dependências pela ordem inversa da distância (fase de retrocesso de Brandes).
+ *
+ * Os predecessores de w não são guardados: são os adjacentes v com distancia[v] + peso(v, w) igual a
+ * distancia[w], com a mesma comparação usada na ida.
+ */
+static void AcumularDependencias(const GrafoPlano *g, bool ponderado, int visitados, RascunhoCaminhos *r) {
+    for (int i = 0; i < visitados; i++) r->dependencia[r->ordem[i]] = 0;
+
+    for (int i = visitados - 1; i > 0; i--) {
+        int w = r->ordem[i];
+        double fator = (1 + r->dependencia[w]) / r->caminhos[w];
+        for (size_t k = g->inicioAdj[w]; k < g->inicioAdj[w + 1]; k++) {
+            int v = g->adjacentes[k];
+            if (r->distancia[v] < 0) continue;
+            bool predecessor = ponderado ? MesmaDistancia(r->distancia[v] + PesoLigacao(g, v, w), r->distancia[w])
+                                         : r->distancia[v] + 1 == r->distancia[w];
+            if (predecessor) r->dependencia[v] += r->caminhos[v] * fator;
+        }
+        r->acumulado[w] += r->dependencia[w];
+    }
+}
+
+static void *TrabalhadorCentralidade(void *arg) {
+    FioCentralidade *f = (FioCentralidade *)arg;
+    EstadoCentralidade *e = f->e;
+    for (;;) {
+        int i = __atomic_fetch_add(&e->seguinte, 1, __ATOMIC_RELAXED);
+        if (i >= e->numOrigens) break;
+        int visitados = CaminhosMinimos(e->g, e->ponderado, e->origens[i], &f->r);
+        AcumularDependencias(e->g, e->ponderado, visitados, &f->r);
+    }
+    return NULL;
+}
+
+static void LiberarRascunho(RascunhoCaminhos *r) {
+    free(r->distancia);
+    free(r->caminhos);
+    free(r->dependencia);
+    free(r->ordem);
+    free(r->heap);
+    free(r->acumulado);
+}
+
+/**
+ * @brief Centralidade de intermediação (Brandes) de cada vértice, exata ou por amostragem de origens.
+ *
+ * As origens são repartidas dinamicamente pelos fios; cada fio acumula num vetor próprio e os vetores
+ * são somados no fim. Como o grafo é tratado como não dirigido, cada par é contado uma vez.
+ *
+ * @param g Grafo plano (ligações nos dois sentidos).
+ * @param ponderado Se true, o comprimento de cada ligação é a distância euclidiana entre as antenas (Dijkstra);
+ *                  se false, todas as ligações valem 1 (BFS).
+ * @param numThreads Número de fios de execução (1 para sequencial).
+ * @param amostras Número de origens sorteadas (0, ou pelo menos numVertices, para o cálculo exato); o resultado
+ *                 é escalado por numVertices/amostras para estimar o valor exato.
+ * @param semente Semente do sorteio das origens.
+ * @param centralidade Recebe a centralidade de cada vértice; numVertices posições.
+ * @return true Se o cálculo foi concluído.
+ */
+bool CentralidadeIntermediacao(const GrafoPlano *g, bool ponderado, int numThreads, int amostras,
+                               uint64_t semente, double *centralidade) {
+    if (!g || !centralidade || amostras < 0) return false;
+    if (numThreads < 1) numThreads = 1;
+    int n = g->numVertices;
+    for (int v = 0; v < n; v++) centralidade[v] = 0;
+    if (n == 0) return true;
+
+    // Origens: todas, ou as primeiras `amostras` de uma permutação aleatória (Fisher-Yates parcial)
+    int numOrigens = (amostras == 0 || amostras >= n) ? n : amostras;
+    int *origens = (int *)malloc((size_t)n * sizeof(int));
+    FioCentralidade *fios = (FioCentralidade *)calloc((size_t)numThreads, sizeof(FioCentralidade));
+    pthread_t *ids = (pthread_t *)malloc((size_t)numThreads * sizeof(pthread_t));
+    if (!origens || !fios || !ids) {
+        free(origens);
+        free(fios);
+        free(ids);
+        return false;
+    }
+    for (int v = 0; v < n; v++) origens[v] = v;
+    uint64_t estado = semente | 1;
+    for (int i = 0; numOrigens < n && i < numOrigens; i++) {
+        estado ^= estado >> 12;
+        estado ^= estado << 25;
+        estado ^= estado >> 27;
+        int j = i + (int)((estado * 0x2545F4914F6CDD1DULL) % (uint64_t)(n - i));
+        int troca = origens[i];
+        origens[i] = origens[j];
+        origens[j] = troca;
+    }
+
+    EstadoCentralidade e = { g, ponderado, origens, numOrigens, 0, false };
+    int preparados = 0;
+    for (; preparados < numThreads; preparados++) {
+        RascunhoCaminhos *r = &fios[preparados].r;
+        fios[preparados].e = &e;
+        r->distancia = (double *)malloc((size_t)n * sizeof(double));
+        r->caminhos = (double *)malloc((size_t)n * sizeof(double));
+        r->dependencia = (double *)malloc((size_t)n * sizeof(double));
+        r->ordem = (int *)malloc((size_t)n * sizeof(int));
+        r->acumulado = (double *)calloc((size_t)n, sizeof(double));
+        r->heap = ponderado ? (EntradaHeap *)malloc((g->numArestas + 1) * sizeof(EntradaHeap)) : NULL;
+        if (!r->distancia || !r->caminhos || !r->dependencia || !r->ordem || !r->acumulado || (ponderado && !r->heap)) {
+            LiberarRascunho(r);
+            break;
+        }
+    }
+    if (preparados == 0) e.erro = true;
+
+    // Com menos memória do que o pedido, usam-se só os fios que conseguiram os seus buffers
+    int criados = 1;
+    for (int i = 1; !e.erro && i < preparados; i++) {
+        if (pthread_create(&ids[i], NULL, TrabalhadorCentralidade, &fios[i]) != 0) break;
+        criados++;
+    }
+    if (!e.erro) TrabalhadorCentralidade(&fios[0]);
+    for (int i = 1; i < criados; i++) pthread_join(ids[i], NULL);
+
+    double escala = 0.5 * (double)n / (double)numOrigens;
+    for (int i = 0; i < preparados; i++) {
+        for (int v = 0; !e.erro && v < n; v++) centralidade[v] += fios[i].r.acumulado[v] * escala;
+        LiberarRascunho(&fios[i].r);
+    }
+
+    free(origens);
+    free(fios);
+    free(ids);
+    return !e.erro;
+}
+
+#pragma endregion
+
+#pragma region Distâncias em saltos
+
+/// Palavras de 64 bits por vértice em cada passagem: 256 origens de uma vez.
+#define PALAVRAS_ORIGENS 4
+#define ORIGENS_POR_PASSAGEM (64 * PALAVRAS_ORIGENS)
+
+/**
+ * @brief Estado partilhado: cada fio reserva o próximo grupo de origens com um contador atómico.
+ */
+typedef struct EstadoSaltos {
+    const GrafoPlano *g;
+    MatrizSaltos *m;
+    unsigned maximo;            ///< Maior distância guardada (o valor seguinte é "inalcançável")
+    int seguinte;
+} EstadoSaltos;
+
+/**
+ * @brief Guarda a distância da origem s ao vértice v na matriz.
+ */
+static inline void GuardarSalto(MatrizSaltos *m, int s, int v, unsigned d) {
+    size_t i = (size_t)s * (size_t)m->numVertices + (size_t)v;
+    if (m->bytesPorDistancia == 1) ((uint8_t *)m->distancias)[i] = (uint8_t)d;
+    else ((uint16_t *)m->distancias)[i] = (uint16_t)d;
+}
+
+/**
+ * @brief BFS simultânea de até 256 origens: o bit b das palavras de cada vértice corresponde à origem base+b.
+ *
+ * Em cada nível, um vértice entra na fronteira de uma origem se algum vizinho estiver na fronteira dessa
+ * origem e ele ainda não tiver sido visitado por ela: com operações de 64 bits avançam 64 BFS de uma vez.
+ */
+static void SaltosGrupo(EstadoSaltos *e, int base, uint64_t *visitado, uint64_t *fronteira, uint64_t *proxima) {
+    const GrafoPlano *g = e->g;
+    int n = g->numVertices;
+    int origens = n - base < ORIGENS_POR_PASSAGEM ? n - base : ORIGENS_POR_PASSAGEM;
+
+    // Bits das origens válidas deste grupo: um vértice com todos estes bits já não precisa de ser visto
+    uint64_t completo[PALAVRAS_ORIGENS];
+    for (int p = 0; p < PALAVRAS_ORIGENS; p++) {
+        int resto = origens - 64 * p;
+        completo[p] = resto >= 64 ? UINT64_MAX : (resto > 0 ? ((uint64_t)1 << resto) - 1 : 0);
+    }
+
+    memset(visitado, 0, (size_t)n * PALAVRAS_ORIGENS * sizeof(uint64_t));
+    memset(fronteira, 0, (size_t)n * PALAVRAS_ORIGENS * sizeof(uint64_t));
+    for (int b = 0; b < origens; b++) {
+        int s = base + b;
+        visitado[(size_t)s * PALAVRAS_ORIGENS + b / 64] |= (uint64_t)1 << (b % 64);
+        fronteira[(size_t)s * PALAVRAS_ORIGENS + b / 64] |= (uint64_t)1 << (b % 64);
+        GuardarSalto(e->m, s, s, 0);
+    }
+
+    for (unsigned nivel = 1;; nivel++) {
+        bool avancou = false;
+        for (int v = 0; v < n; v++) {
+            uint64_t *vis = visitado + (size_t)v * PALAVRAS_ORIGENS;
+            uint64_t *prox = proxima + (size_t)v * PALAVRAS_ORIGENS;
+            uint64_t falta = 0;
+            for (int p = 0; p < PALAVRAS_ORIGENS; p++) {
+                prox[p] = 0;
+                falta |= completo[p] & ~vis[p];
+            }
+            if (!falta) continue;
+
+            for (size_t k = g->inicioAdj[v]; k < g->inicioAdj[v + 1]; k++) {
+                const uint64_t *fu = fronteira + (size_t)g->adjacentes[k] * PALAVRAS_ORIGENS;
+                for (int p = 0; p < PALAVRAS_ORIGENS; p++) prox[p] |= fu[p];
+            }
+
+            for (int p = 0; p < PALAVRAS_ORIGENS; p++) {
+                prox[p] &= ~vis[p];
+                vis[p] |= prox[p];
+                for (uint64_t bits = prox[p]; bits; bits &= bits - 1) {
+                    int s = base + 64 * p + __builtin_ctzll(bits);
+                    GuardarSalto(e->m, s, v, nivel < e->maximo ? nivel : e->maximo);
+                }
+                if (prox[p]) avancou = true;
+            }
+        }
+        if (!avancou) break;
+
+        uint64_t *troca = fronteira;
+        fronteira = proxima;
+        proxima = troca;
+    }
+}
+
+static void *TrabalhadorSaltos(void *arg) {
+    EstadoSaltos *e = (EstadoSaltos *)arg;
+    size_t palavras = (size_t)e->g->numVertices * PALAVRAS_ORIGENS;
+    uint64_t *visitado = (uint64_t *)malloc(palavras * sizeof(uint64_t));
+    uint64_t *fronteira = (uint64_t *)malloc(palavras * sizeof(uint64_t));
+    uint64_t *proxima = (uint64_t *)malloc(palavras * sizeof(uint64_t));
+
+    if (visitado && fronteira && proxima) {
+        for (;;) {
+            int base = __atomic_fetch_add(&e->seguinte, ORIGENS_POR_PASSAGEM, __ATOMIC_RELAXED);
+            if (base >= e->g->numVertices) break;
+            SaltosGrupo(e, base, visitado, fronteira, proxima);
+        }
+    }
+    // Sem memória, o fio não reserva nenhum grupo: os grupos ficam para os outros fios
+
+    free(visitado);
+    free(fronteira);
+    free(proxima);
+    return NULL;
+}
+
+/**
+ * @brief Distâncias em saltos entre todos os pares de vértices, por BFS paralela em bits.
+ *
+ * Cada passagem faz 256 BFS em simultâneo; os grupos de origens são repartidos pelos fios e cada fio
+ * escreve só as linhas das suas origens. Com nomeFicheiro, a matriz é criada nesse ficheiro e mapeada
+ * em memória (por linhas, sem cabeçalho), para caber mesmo quando excede a memória disponível.
+ * Se o cálculo falhar, o ficheiro criado é apagado.
+ *
+ * @param g Grafo plano (ligações nos dois sentidos).
+ * @param bytesPorDistancia 1 (distâncias até 254) ou 2 (até 65534).
+ * @param nomeFicheiro Ficheiro onde guardar a matriz, ou NULL para a manter só em memória.
+ * @param numThreads Número de fios de execução (1 para sequencial).
+ * @param m Recebe a matriz; liberta-se com LiberarMatrizSaltos.
+ * @return true Se a matriz foi calculada.
+ */
+bool CalcularMatrizSaltos(const GrafoPlano *g, int bytesPorDistancia, const char *nomeFicheiro, int numThreads, MatrizSaltos *m) {
+    if (!g || !m || (bytesPorDistancia != 1 && bytesPorDistancia != 2)) return false;
+    if (numThreads < 1) numThreads = 1;
+    memset(m, 0, sizeof(*m));
+    m->numVertices = g->numVertices;
+    m->bytesPorDistancia = bytesPorDistancia;
+    m->tamanho = (size_t)g->numVertices * (size_t)g->numVertices * (size_t)bytesPorDistancia;
+
+    if (nomeFicheiro) {
+        int fd = open(nomeFicheiro, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        void *p = MAP_FAILED;
+        if (m->tamanho > 0 && ftruncate(fd, (off_t)m->tamanho) == 0)
+            p = mmap(NULL, m->tamanho, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m->tamanho > 0 && p == MAP_FAILED) {
+            unlink(nomeFicheiro); // Não deixa para trás um ficheiro vazio ou truncado a meio
+            return false;
+        }
+        m->distancias = m->tamanho > 0 ? p : NULL;
+        m->mapeada = m->tamanho > 0;
+    } else {
+        m->distancias = malloc(m->tamanho + 1);
+        if (!m->distancias) return false;
+    }
+    // Todos os bytes a 0xFF: o maior valor, que marca os pares não alcançáveis
+    if (m->tamanho > 0) memset(m->distancias, 0xFF, m->tamanho);
+
+    EstadoSaltos e = { g, m, bytesPorDistancia == 1 ? UINT8_MAX - 1u : UINT16_MAX - 1u, 0 };
+    pthread_t *ids = (pthread_t *)malloc((size_t)numThreads * sizeof(pthread_t));
+    int criados = 0;
+    for (int i = 1; ids && i < numThreads; i++) {
+        if (pthread_create(&ids[criados], NULL, TrabalhadorSaltos, &e) != 0) break;
+        criados++;
+    }
+    TrabalhadorSaltos(&e);
+    for (int i = 0; i < criados; i++) pthread_join(ids[i], NULL);
+    free(ids);
+
+    // Um fio sem memória não impede os outros de acabar; só há erro se ficaram origens por calcular
+    if (e.seguinte < g->numVertices) {
+        LiberarMatrizSaltos(m);
+        if (nomeFicheiro) unlink(nomeFicheiro);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Distância em saltos de origem a destino.
+ *
+ * @param m Matriz de distâncias.
+ * @param origem Índice do vértice de origem.
+ * @param destino Índice do vértice de destino.
+ * @return unsigned Número de saltos, ou o maior valor representável (255 ou 65535) se não for alcançável.
+ */
+unsigned DistanciaSaltos(const MatrizSaltos *m, int origem, int destino) {
+    if (!m || !m->distancias || origem < 0 || destino < 0 || origem >= m->numVertices || destino >= m->numVertices)
+        return m && m->bytesPorDistancia == 1 ? UINT8_MAX : UINT16_MAX;
+    size_t i = (size_t)origem * (size_t)m->numVertices + (size_t)destino;
+    return m->bytesPorDistancia == 1 ? ((const uint8_t *)m->distancias)[i] : ((const uint16_t *)m->distancias)[i];
+}
+
+/**
+ * @brief Liberta (ou desmapeia) a matriz e deixa-a vazia; o ficheiro, se existir, mantém-se.
+ *
+ * @param m Matriz de distâncias.
+ */
+void LiberarMatrizSaltos(MatrizSaltos *m) {
+    if (!m) return;
+    if (m->mapeada) munmap(m->distancias, m->tamanho);
+    else free(m->distancias);
+    memset(m, 0, sizeof(*m));
+}
+
+#pragma endregion
+
+#pragma region Reordenação espacial
+
+/**
+ * @brief Espalha os 32 bits de v pelas posições pares de um inteiro de 64 bits.
+ */
+static inline uint64_t EspalharBits(uint32_t v) {
+    uint64_t b = v;
+    b = (b | (b << 16)) & 0x0000ffff0000ffffULL;
+    b = (b | (b << 8)) & 0x00ff00ff00ff00ffULL;
+    b = (b | (b << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    b = (b | (b << 2)) & 0x3333333333333333ULL;
+    b = (b | (b << 1)) & 0x5555555555555555ULL;
+    return b;
+}
+
+/**
+ * @brief Ordem dos vértices pela curva de Morton (Z-order): ordem[novo] é o índice antigo do vértice.
+ *
+ * As coordenadas são tomadas em relação ao canto do retângulo envolvente; se a maior extensão precisar
+ * de mais de 32 bits, só contam os 32 mais significativos (vértices com o mesmo código mantêm a ordem).
+ * A ordenação é a mesma radix paralela da árvore mínima, com o vértice no lugar da origem da ligação.
+ */
+static int *OrdemMorton(const Coordenada *x, const Coordenada *y, int n, int numThreads) {
+    int *ordem = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    ArestaOrdenar *chaves = (ArestaOrdenar *)malloc(((size_t)n + 1) * sizeof(ArestaOrdenar));
+    ArestaOrdenar *auxiliar = (ArestaOrdenar *)malloc(((size_t)n + 1) * sizeof(ArestaOrdenar));
+    if (!ordem || !chaves || !auxiliar) {
+        free(ordem);
+        free(chaves);
+        free(auxiliar);
+        return NULL;
+    }
+
+    Coordenada minX = n > 0 ? x[0] : 0, maxX = minX, minY = n > 0 ? y[0] : 0, maxY = minY;
+    for (int v = 1; v < n; v++) {
+        if (x[v] < minX) minX = x[v];
+        if (x[v] > maxX) maxX = x[v];
+        if (y[v] < minY) minY = y[v];
+        if (y[v] > maxY) maxY = y[v];
+    }
+    uint64_t extensao = (uint64_t)(maxX - minX) | (uint64_t)(maxY - minY);
+    int bits = extensao ? 64 - __builtin_clzll(extensao) : 0;
+    int deslocamento = bits > 32 ? bits - 32 : 0;
+
+    for (int v = 0; v < n; v++) {
+        uint32_t rx = (uint32_t)((uint64_t)(x[v] - minX) >> deslocamento);
+        uint32_t ry = (uint32_t)((uint64_t)(y[v] - minY) >> deslocamento);
+        chaves[v].chave = (EspalharBits(rx) << 1) | EspalharBits(ry);
+        chaves[v].origem = v;
+        chaves[v].destino = 0;
+    }
+
+    ArestaOrdenar *ordenadas = OrdenarArestasRadix(chaves, auxiliar, (size_t)n, numThreads < 1 ? 1 : numThreads);
+    if (ordenadas) {
+        for (int v = 0; v < n; v++) ordem[v] = ordenadas[v].origem;
+    }
+
+    free(chaves);
+    free(auxiliar);
+    if (!ordenadas) {
+        free(ordem);
+        return NULL;
+    }
+    return ordem;
+}
+
+/**
+ * @brief Reordena os vértices do grafo plano pela curva de Morton, para que antenas próximas no mapa
+ * fiquem próximas na memória.
+ *
+ * Os vetores de coordenadas, frequências e antenas são permutados, as listas de adjacentes são
+ * reconstruídas com os novos índices e o índice de coordenadas é atualizado no lugar. Os índices de
+ * vértices obtidos antes da reordenação deixam de ser válidos.
+ *
+ * Só o grafo muda: as listas de tipos e de adjacentes de onde foi criado mantêm a sua ordem, e as
+ * funções que trabalham sobre elas não ganham nada com a reordenação.
+ *
+ * @param g Grafo plano.
+ * @param numThreads Número de fios de execução da ordenação (1 para sequencial).
+ * @return true Se o grafo foi reordenado; false se faltou memória (o grafo fica como estava).
+ */
+bool ReordenarMortonPlano(GrafoPlano *g, int numThreads) {
+    if (!g) return false;
+    int n = g->numVertices;
+
+    int *ordem = OrdemMorton(g->x, g->y, n, numThreads);
+    int *novoIndice = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    size_t *inicioAdj = (size_t *)malloc(((size_t)n + 1) * sizeof(size_t));
+    int *adjacentes = (int *)malloc((g->numArestas + 1) * sizeof(int));
+    Coordenada *x = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    Coordenada *y = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    char *frequencia = (char *)malloc((size_t)n + 1);
+    Antena **antenas = (Antena **)malloc(((size_t)n + 1) * sizeof(Antena *));
+    if (!ordem || !novoIndice || !inicioAdj || !adjacentes || !x || !y || !frequencia || !antenas) {
+        free(ordem);
+        free(novoIndice);
+        free(inicioAdj);
+        free(adjacentes);
+        free(x);
+        free(y);
+        free(frequencia);
+        free(antenas);
+        return false;
+    }
+
+    for (int v = 0; v < n; v++) novoIndice[ordem[v]] = v;
+
+    // Os adjacentes de cada vértice mantêm a sua ordem, já com os novos índices
+    inicioAdj[0] = 0;
+    for (int v = 0; v < n; v++) {
+        int antigo = ordem[v];
+        size_t k = inicioAdj[v];
+        for (size_t a = g->inicioAdj[antigo]; a < g->inicioAdj[antigo + 1]; a++) adjacentes[k++] = novoIndice[g->adjacentes[a]];
+        inicioAdj[v + 1] = k;
+
+        x[v] = g->x[antigo];
+        y[v] = g->y[antigo];
+        frequencia[v] = g->frequencia[antigo];
+        antenas[v] = g->antenas[antigo];
+    }
+
+    // As posições no índice não mudam, só os vértices a que apontam
+    for (size_t i = 0; i < g->indice.capacidade; i++) {
+        if (g->indice.ocupado[i]) g->indice.valores[i] = (uint64_t)novoIndice[g->indice.valores[i]];
+    }
+
+    free(g->inicioAdj);
+    free(g->adjacentes);
+    free(g->x);
+    free(g->y);
+    free(g->frequencia);
+    free(g->antenas);
+    g->inicioAdj = inicioAdj;
+    g->adjacentes = adjacentes;
+    g->x = x;
+    g->y = y;
+    g->frequencia = frequencia;
+    g->antenas = antenas;
+
+    free(ordem);
+    free(novoIndice);
+    return true;
+}
+
+/**
+ * @brief Reordena os vértices de cada tipo do grafo implícito pela curva de Morton.
+ *
+ * Os tipos continuam a ocupar os mesmos intervalos; dentro de cada um, os vértices passam a estar pela
+ * ordem da curva. Consegue-se com uma única ordenação global seguida de uma distribuição estável por tipo.
+ * Tal como em ReordenarMortonPlano, as listas de tipos de onde o grafo foi criado não são alteradas.
+ *
+ * @param g Grafo implícito.
+ * @param numThreads Número de fios de execução da ordenação (1 para sequencial).
+ * @return true Se o grafo foi reordenado; false se faltou memória (o grafo fica como estava).
+ */
+bool ReordenarMortonImplicito(GrafoImplicito *g, int numThreads) {
+    if (!g) return false;
+    int n = g->numVertices;
+
+    int *global = OrdemMorton(g->x, g->y, n, numThreads);
+    int *ordem = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    int *posicao = (int *)malloc(((size_t)g->numTipos + 1) * sizeof(int));
+    int *novoIndice = (int *)malloc(((size_t)n + 1) * sizeof(int));
+    if (!global || !ordem || !posicao || !novoIndice) {
+        free(global);
+        free(ordem);
+        free(posicao);
+        free(novoIndice);
+        return false;
+    }
+
+    for (int t = 0; t < g->numTipos; t++) posicao[t] = g->inicioTipo[t];
+    for (int i = 0; i < n; i++) ordem[posicao[g->tipoVertice[global[i]]]++] = global[i];
+    free(global);
+    free(posicao);
+
+    Coordenada *x = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    Coordenada *y = (Coordenada *)malloc(((size_t)n + 1) * sizeof(Coordenada));
+    char *frequencia = (char *)malloc((size_t)n + 1);
+    Antena **antenas = (Antena **)malloc(((size_t)n + 1) * sizeof(Antena *));
+    if (!x || !y || !frequencia || !antenas) {
+        free(ordem);
+        free(novoIndice);
+        free(x);
+        free(y);
+        free(frequencia);
+        free(antenas);
+        return false;
+    }
+
+    for (int v = 0; v < n; v++) {
+        x[v] = g->x[ordem[v]];
+        y[v] = g->y[ordem[v]];
+        frequencia[v] = g->frequencia[ordem[v]];
+        antenas[v] = g->antenas[ordem[v]];
+    }
+    free(g->x);
+    free(g->y);
+    free(g->frequencia);
+    free(g->antenas);
+    g->x = x;
+    g->y = y;
+    g->frequencia = frequencia;
+    g->antenas = antenas;
+
+    for (int i = 0; i < n; i++) novoIndice[ordem[i]] = i;
+    for (size_t i = 0; i < g->indice.capacidade; i++) {
+        if (g->indice.ocupado[i]) g->indice.valores[i] = (uint64_t)novoIndice[g->indice.valores[i]];
+    }
+
+    free(ordem);
+    free(novoIndice);
+    return true;
+}
+
+/**
+ * @brief Segundos decorridos desde `inicio`.
+ */
+static double SegundosDesde(const struct timespec *inicio) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (double)(agora.tv_sec - inicio->tv_sec) + (double)(agora.tv_nsec - inicio->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Faz uma BFS paralela a partir de cada uma das antenas indicadas e devolve o tempo total.
+ *
+ * @return double Segundos gastos, ou um valor negativo se uma das BFS falhou.
+ */
+static double TempoBuscas(const GrafoPlano *g, const Coordenada *x, const Coordenada *y, int buscas,
+                          int numThreads, int *nivel, int *pai) {
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (int i = 0; i < buscas; i++) {
+        if (!BuscaEmLarguraParalela(g, ProcurarVertice(g, x[i], y[i]), numThreads, nivel, pai)) return -1.0;
+    }
+    return SegundosDesde(&inicio);
+}
+
+/**
+ * @brief Mede o efeito da reordenação de Morton nas BFS sobre o grafo plano.
+ *
+ * Cria o grafo a partir das listas e faz `buscas` BFS a partir de antenas espalhadas pela numeração
+ * original. Depois reordena o grafo e repete as BFS a partir das mesmas antenas, que são procuradas
+ * pelas coordenadas porque os índices mudam.
+ *
+ * @param listaTipos Lista de tipos de antenas, já interligadas (não é alterada).
+ * @param buscas Número de BFS em cada grafo.
+ * @param numThreads Número de fios de execução das BFS e da reordenação.
+ * @param t Recebe os tempos medidos.
+ * @return true Se as medições foram feitas; false se a rede está vazia ou faltou memória.
+ */
+bool MedirReordenacaoMorton(TipoAntena *listaTipos, int buscas, int numThreads, TemposReordenacao *t) {
+    GrafoPlano *g = CriarGrafoPlano(listaTipos);
+    if (!g || g->numVertices == 0 || buscas < 1) {
+        LiberarGrafoPlano(g);
+        return false;
+    }
+
+    int n = g->numVertices;
+    Coordenada *x = (Coordenada *)malloc((size_t)buscas * sizeof(Coordenada));
+    Coordenada *y = (Coordenada *)malloc((size_t)buscas * sizeof(Coordenada));
+    int *nivel = (int *)malloc((size_t)n * sizeof(int));
+    int *pai = (int *)malloc((size_t)n * sizeof(int));
+    bool ok = x && y && nivel && pai;
+
+    if (ok) {
+        for (int i = 0; i < buscas; i++) {
+            int v = (int)((int64_t)i * n / buscas);
+            x[i] = g->x[v];
+            y[i] = g->y[v];
+        }
+
+        t->buscas = buscas;
+        t->original = TempoBuscas(g, x, y, buscas, numThreads, nivel, pai);
+
+        struct timespec inicio;
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        ok = t->original >= 0 && ReordenarMortonPlano(g, numThreads);
+        t->reordenacao = SegundosDesde(&inicio);
+
+        if (ok) {
+            t->reordenado = TempoBuscas(g, x, y, buscas, numThreads, nivel, pai);
+            ok = t->reordenado >= 0;
+        }
+    }
+
+    free(x);
+    free(y);
+    free(nivel);
+    free(pai);
+    LiberarGrafoPlano(g);
+    return ok;
+}
+
+#pragma endregion
@@ -0,0 +1,280 @@
+/**
+ * @file tabela.c
+ * @author David Costa
+ * @brief Implementação da tabela e do conjunto de dispersão indexados por coordenadas.
+ */
+
+#include "tabela.h"
+#include <stdlib.h>
+
+/**
+ * @brief Mistura os bits das duas coordenadas para distribuir bem as posições vizinhas.
+ * 
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param capacidade Capacidade da tabela (potência de 2).
+ * @return size_t Posição ideal da coordenada na tabela.
+ */
+size_t Dispersar(Coordenada x, Coordenada y, size_t capacidade) {
+    uint64_t chave = (uint64_t)x * 0x9e3779b97f4a7c15ULL ^ (uint64_t)y;
+    chave ^= chave >> 33;
+    chave *= 0xff51afd7ed558ccdULL;
+    chave ^= chave >> 33;
+    return (size_t)chave & (capacidade - 1);
+}
+
+/**
+ * @brief Menor potência de 2 (pelo menos 16) que guarda n elementos abaixo de 70% de ocupação.
+ */
+static size_t CapacidadePara(size_t n) {
+    size_t capacidade = 16;
+    while (capacidade * 7 / 10 < n) capacidade *= 2;
+    return capacidade;
+}
+
+#pragma region Tabela
+
+/**
+ * @brief Inicializa uma tabela vazia.
+ * 
+ * @param t Tabela a inicializar.
+ * @param capacidadeInicial Número de elementos esperado (pode ser 0).
+ * @return true Se a memória foi reservada.
+ */
+bool IniciarTabela(TabelaCoordenadas *t, size_t capacidadeInicial) {
+    size_t capacidade = CapacidadePara(capacidadeInicial);
+
+    t->x = (Coordenada *)malloc(capacidade * sizeof(Coordenada));
+    t->y = (Coordenada *)malloc(capacidade * sizeof(Coordenada));
+    t->valores = (uint64_t *)malloc(capacidade * sizeof(uint64_t));
+    t->ocupado = (bool *)calloc(capacidade, sizeof(bool));
+    t->capacidade = capacidade;
+    t->tamanho = 0;
+
+    if (!t->x || !t->y || !t->valores || !t->ocupado) {
+        LiberarTabela(t);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Duplica a capacidade da tabela, voltando a inserir todos os elementos.
+ */
+static bool Crescer(TabelaCoordenadas *t) {
+    TabelaCoordenadas nova;
+    if (!IniciarTabela(&nova, t->capacidade)) return false;
+
+    for (size_t i = 0; i < t->capacidade; i++) {
+        if (t->ocupado[i]) InserirTabela(&nova, t->x[i], t->y[i], t->valores[i]);
+    }
+    LiberarTabela(t);
+    *t = nova;
+    return true;
+}
+
+/**
+ * @brief Insere ou atualiza o valor associado a uma posição.
+ * 
+ * @param t Tabela.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param valor Valor.
+ * @return true Se a operação foi bem-sucedida.
+ * @return false Se faltou memória para crescer.
+ */
+bool InserirTabela(TabelaCoordenadas *t, Coordenada x, Coordenada y, uint64_t valor) {
+    if ((t->tamanho + 1) * 10 > t->capacidade * 7 && !Crescer(t)) return false;
+
+    size_t i = Dispersar(x, y, t->capacidade);
+    while (t->ocupado[i] && (t->x[i] != x || t->y[i] != y)) i = (i + 1) & (t->capacidade - 1);
+
+    if (!t->ocupado[i]) {
+        t->ocupado[i] = true;
+        t->x[i] = x;
+        t->y[i] = y;
+        t->tamanho++;
+    }
+    t->valores[i] = valor;
+    return true;
+}
+
+/**
+ * @brief Procura o valor associado a uma posição.
+ * 
+ * @param t Tabela.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param valor Recebe o valor encontrado (pode ser NULL).
+ * @return true Se a posição existe.
+ */
+bool ProcurarTabela(const TabelaCoordenadas *t, Coordenada x, Coordenada y, uint64_t *valor) {
+    size_t i = Dispersar(x, y, t->capacidade);
+    while (t->ocupado[i]) {
+        if (t->x[i] == x && t->y[i] == y) {
+            if (valor) *valor = t->valores[i];
+            return true;
+        }
+        i = (i + 1) & (t->capacidade - 1);
+    }
+    return false;
+}
+
+/**
+ * @brief Remove uma posição, deslocando para trás os elementos da mesma sequência de sondagem.
+ * 
+ * @param t Tabela.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return true Se a posição existia.
+ */
+bool RemoverTabela(TabelaCoordenadas *t, Coordenada x, Coordenada y) {
+    size_t mascara = t->capacidade - 1;
+    size_t i = Dispersar(x, y, t->capacidade);
+    while (t->ocupado[i] && (t->x[i] != x || t->y[i] != y)) i = (i + 1) & mascara;
+    if (!t->ocupado[i]) return false;
+
+    size_t livre = i;
+    for (size_t j = (i + 1) & mascara; t->ocupado[j]; j = (j + 1) & mascara) {
+        size_t ideal = Dispersar(t->x[j], t->y[j], t->capacidade);
+        // O elemento em j só pode ocupar a posição livre se esta estiver entre ideal e j (circularmente)
+        if (((j - ideal) & mascara) >= ((j - livre) & mascara)) {
+            t->x[livre] = t->x[j];
+            t->y[livre] = t->y[j];
+            t->valores[livre] = t->valores[j];
+            livre = j;
+        }
+    }
+    t->ocupado[livre] = false;
+    t->tamanho--;
+    return true;
+}
+
+/**
+ * @brief Liberta a memória da tabela.
+ * 
+ * @param t Tabela.
+ */
+void LiberarTabela(TabelaCoordenadas *t) {
+    free(t->x);
+    free(t->y);
+    free(t->valores);
+    free(t->ocupado);
+    t->x = NULL;
+    t->y = NULL;
+    t->valores = NULL;
+    t->ocupado = NULL;
+    t->capacidade = 0;
+    t->tamanho = 0;
+}
+
+#pragma endregion
+
+#pragma region Conjunto
+
+/**
+ * @brief Inicializa um conjunto vazio.
+ * 
+ * @param c Conjunto a inicializar.
+ * @param capacidadeInicial Número de elementos esperado (pode ser 0).
+ * @return true Se a memória foi reservada.
+ */
+bool IniciarConjunto(ConjuntoCoordenadas *c, size_t capacidadeInicial) {
+    size_t capacidade = CapacidadePara(capacidadeInicial);
+
+    c->x = (Coordenada *)malloc(capacidade * sizeof(Coordenada));
+    c->y = (Coordenada *)malloc(capacidade * sizeof(Coordenada));
+    c->ocupado = (bool *)calloc(capacidade, sizeof(bool));
+    c->capacidade = capacidade;
+    c->tamanho = 0;
+
+    if (!c->x || !c->y || !c->ocupado) {
+        LiberarConjunto(c);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Duplica a capacidade do conjunto, voltando a inserir todos os elementos.
+ */
+static bool CrescerConjunto(ConjuntoCoordenadas *c) {
+    ConjuntoCoordenadas novo;
+    if (!IniciarConjunto(&novo, c->capacidade)) return false;
+
+    size_t mascara = novo.capacidade - 1;
+    for (size_t i = 0; i < c->capacidade; i++) {
+        if (!c->ocupado[i]) continue;
+        // As posições são todas distintas: basta procurar a primeira livre
+        size_t j = Dispersar(c->x[i], c->y[i], novo.capacidade);
+        while (novo.ocupado[j]) j = (j + 1) & mascara;
+        novo.ocupado[j] = true;
+        novo.x[j] = c->x[i];
+        novo.y[j] = c->y[i];
+    }
+    novo.tamanho = c->tamanho;
+    LiberarConjunto(c);
+    *c = novo;
+    return true;
+}
+
+/**
+ * @brief Acrescenta uma posição ao conjunto, se ainda não estiver lá.
+ * 
+ * @param c Conjunto.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param novo Recebe true se a posição foi acrescentada, false se já existia (pode ser NULL).
+ * @return true Se a operação foi bem-sucedida.
+ * @return false Se faltou memória para crescer.
+ */
+bool AdicionarConjunto(ConjuntoCoordenadas *c, Coordenada x, Coordenada y, bool *novo) {
+    if ((c->tamanho + 1) * 10 > c->capacidade * 7 && !CrescerConjunto(c)) return false;
+
+    size_t i = Dispersar(x, y, c->capacidade);
+    while (c->ocupado[i] && (c->x[i] != x || c->y[i] != y)) i = (i + 1) & (c->capacidade - 1);
+
+    if (novo) *novo = !c->ocupado[i];
+    if (!c->ocupado[i]) {
+        c->ocupado[i] = true;
+        c->x[i] = x;
+        c->y[i] = y;
+        c->tamanho++;
+    }
+    return true;
+}
+
+/**
+ * @brief Verifica se uma posição pertence ao conjunto.
+ * 
+ * @param c Conjunto.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return true Se a posição existe.
+ */
+bool ContemConjunto(const ConjuntoCoordenadas *c, Coordenada x, Coordenada y) {
+    size_t i = Dispersar(x, y, c->capacidade);
+    while (c->ocupado[i]) {
+        if (c->x[i] == x && c->y[i] == y) return true;
+        i = (i + 1) & (c->capacidade - 1);
+    }
+    return false;
+}
+
+/**
+ * @brief Liberta a memória do conjunto.
+ * 
+ * @param c Conjunto.
+ */
+void LiberarConjunto(ConjuntoCoordenadas *c) {
+    free(c->x);
+    free(c->y);
+    free(c->ocupado);
+    c->x = NULL;
+    c->y = NULL;
+    c->ocupado = NULL;
+    c->capacidade = 0;
+    c->tamanho = 0;
+}
+
+#pragma endregion
@@ -0,0 +1,705 @@
+/**
+ * @file versoes.c
+ * @author David Costa
+ * @brief Implementação da rede de antenas com versões imutáveis e libertação por épocas.
+ */
+
+#include "versoes.h"
+#include "funcoes.h"
+#include <stdlib.h>
+#include <string.h>
+
+#pragma region Épocas
+
+/**
+ * @brief Marca um objeto substituído no rascunho para ser libertado depois da publicação.
+ * 
+ * Se não houver memória para o registo, o objeto fica por libertar: é preferível perder memória
+ * a libertar algo que um leitor ainda pode estar a usar.
+ */
+static void Retirar(RedeVersionada *rede, void *objeto) {
+    ObjetoRetirado *r = (ObjetoRetirado *)malloc(sizeof(ObjetoRetirado));
+    if (!r) return;
+
+    r->ponteiro = objeto;
+    r->epoca = 0;
+    r->proximo = rede->retiradosRascunho;
+    rede->retiradosRascunho = r;
+}
+
+/**
+ * @brief Liberta os objetos retirados antes da época mais antiga ainda fixada por um leitor.
+ */
+static void Reclamar(RedeVersionada *rede) {
+    uint64_t minimo = UINT64_MAX;
+    for (int i = 0; i < MAX_LEITORES; i++) {
+        uint64_t e = atomic_load(&rede->leitores[i].epoca);
+        if (e != 0 && e < minimo) minimo = e;
+    }
+
+    ObjetoRetirado **ligacao = &rede->pendentes;
+    while (*ligacao) {
+        ObjetoRetirado *r = *ligacao;
+        if (r->epoca < minimo) {
+            *ligacao = r->proximo;
+            free(r->ponteiro);
+            free(r);
+        } else {
+            ligacao = &r->proximo;
+        }
+    }
+}
+
+/**
+ * @brief Regista um novo leitor da rede.
+ * 
+ * @param rede Rede versionada.
+ * @return LeitorRede* Registo do leitor, ou NULL se já existirem MAX_LEITORES leitores.
+ */
+LeitorRede *RegistarLeitor(RedeVersionada *rede) {
+    for (int i = 0; i < MAX_LEITORES; i++) {
+        bool livre = false;
+        if (atomic_compare_exchange_strong(&rede->leitores[i].ocupado, &livre, true)) {
+            rede->leitores[i].rede = rede;
+            atomic_store(&rede->leitores[i].epoca, 0);
+            return &rede->leitores[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Fixa a versão publicada. A versão devolvida não é alterada nem libertada até LibertarVersao.
+ * 
+ * @param leitor Registo do leitor.
+ * @return const VersaoRede* Versão fixada.
+ */
+const VersaoRede *FixarVersao(LeitorRede *leitor) {
+    RedeVersionada *rede = leitor->rede;
+
+    // A época é anunciada antes de ler a versão: um escritor que publique depois disto
+    // vê o anúncio e não liberta a versão que este leitor vai ler
+    atomic_store(&leitor->epoca, atomic_load(&rede->epoca));
+    return atomic_load(&rede->atual);
+}
+
+/**
+ * @brief Deixa de usar a versão fixada.
+ * 
+ * @param leitor Registo do leitor.
+ */
+void LibertarVersao(LeitorRede *leitor) {
+    atomic_store(&leitor->epoca, 0);
+}
+
+/**
+ * @brief Cancela o registo de um leitor.
+ * 
+ * @param leitor Registo do leitor.
+ */
+void RemoverLeitor(LeitorRede *leitor) {
+    atomic_store(&leitor->epoca, 0);
+    atomic_store(&leitor->ocupado, false);
+}
+
+#pragma endregion
+
+#pragma region Tabela de posições
+
+/**
+ * @brief Página e índice dentro da página de uma posição da tabela.
+ */
+#define PAGINA(t, i) ((t)->paginas[(i) / POSICOES_POR_PAGINA])
+#define INDICE(i) ((i) % POSICOES_POR_PAGINA)
+
+/**
+ * @brief Posição da tabela com a coordenada, ou a posição livre onde a sondagem termina.
+ */
+static size_t ProcurarPosicao(const TabelaVersao *t, Coordenada x, Coordenada y) {
+    size_t i = Dispersar(x, y, t->capacidade);
+    for (;;) {
+        const PaginaPosicoes *p = PAGINA(t, i);
+        if (!p->ocupado[INDICE(i)] || (p->x[INDICE(i)] == x && p->y[INDICE(i)] == y)) return i;
+        i = (i + 1) & (t->capacidade - 1);
+    }
+}
+
+/**
+ * @brief Procura o tipo e o índice de uma antena na tabela de uma versão.
+ */
+static bool ProcurarPosicaoVersao(const TabelaVersao *t, Coordenada x, Coordenada y, uint64_t *valor) {
+    size_t i = ProcurarPosicao(t, x, y);
+    const PaginaPosicoes *p = PAGINA(t, i);
+    if (!p->ocupado[INDICE(i)]) return false;
+
+    if (valor) *valor = p->valores[INDICE(i)];
+    return true;
+}
+
+/**
+ * @brief Cria uma tabela vazia da versão indicada, com capacidade para n posições abaixo de 70% de ocupação.
+ */
+static TabelaVersao *CriarTabelaVersao(uint64_t versao, size_t n) {
+    size_t capacidade = POSICOES_POR_PAGINA;
+    while (capacidade * 7 / 10 < n) capacidade *= 2;
+
+    size_t numPaginas = capacidade / POSICOES_POR_PAGINA;
+    TabelaVersao *t = (TabelaVersao *)malloc(sizeof(TabelaVersao) + numPaginas * sizeof(PaginaPosicoes *));
+    if (!t) return NULL;
+
+    t->versao = versao;
+    t->capacidade = capacidade;
+    t->tamanho = 0;
+    t->numPaginas = numPaginas;
+    for (size_t p = 0; p < numPaginas; p++) {
+        t->paginas[p] = (PaginaPosicoes *)calloc(1, sizeof(PaginaPosicoes));
+        if (!t->paginas[p]) {
+            while (p--) free(t->paginas[p]);
+            free(t);
+            return NULL;
+        }
+        t->paginas[p]->versao = versao;
+    }
+    return t;
+}
+
+/**
+ * @brief Descarta a tabela do rascunho depois de substituída: o que o rascunho criou é libertado,
+ * o que veio de versões publicadas é retirado.
+ */
+static void DescartarTabela(RedeVersionada *rede, TabelaVersao *t) {
+    uint64_t numero = rede->rascunho->numero;
+    for (size_t p = 0; p < t->numPaginas; p++) {
+        if (t->paginas[p]->versao == numero) free(t->paginas[p]);
+        else Retirar(rede, t->paginas[p]);
+    }
+    if (t->versao == numero) free(t);
+    else Retirar(rede, t);
+}
+
+/**
+ * @brief Devolve uma cópia privada do rascunho da tabela de posições, com espaço para `tamanho` posições.
+ *
+ * Só a tabela de páginas é copiada; as páginas continuam partilhadas até serem alteradas. Ao crescer,
+ * a tabela é reconstruída por inteiro, como a TabelaCoordenadas.
+ */
+static TabelaVersao *TabelaPrivada(RedeVersionada *rede, size_t tamanho) {
+    VersaoRede *r = rede->rascunho;
+    TabelaVersao *atual = r->posicoes;
+
+    if (tamanho * 10 > atual->capacidade * 7) {
+        TabelaVersao *nova = CriarTabelaVersao(r->numero, tamanho);
+        if (!nova) return NULL;
+
+        for (size_t i = 0; i < atual->capacidade; i++) {
+            const PaginaPosicoes *origem = PAGINA(atual, i);
+            if (!origem->ocupado[INDICE(i)]) continue;
+
+            size_t j = ProcurarPosicao(nova, origem->x[INDICE(i)], origem->y[INDICE(i)]);
+            PaginaPosicoes *destino = PAGINA(nova, j);
+            destino->ocupado[INDICE(j)] = true;
+            destino->x[INDICE(j)] = origem->x[INDICE(i)];
+            destino->y[INDICE(j)] = origem->y[INDICE(i)];
+            destino->valores[INDICE(j)] = origem->valores[INDICE(i)];
+        }
+        nova->tamanho = atual->tamanho;
+
+        DescartarTabela(rede, atual);
+        r->posicoes = nova;
+        return nova;
+    }
+
+    if (atual->versao == r->numero) return atual;
+
+    size_t bytes = sizeof(TabelaVersao) + atual->numPaginas * sizeof(PaginaPosicoes *);
+    TabelaVersao *copia = (TabelaVersao *)malloc(bytes);
+    if (!copia) return NULL;
+
+    memcpy(copia, atual, bytes);
+    copia->versao = r->numero;
+    Retirar(rede, atual);
+    r->posicoes = copia;
+    return copia;
+}
+
+/**
+ * @brief Devolve uma cópia privada da página que contém a posição i de uma tabela já privada.
+ */
+static PaginaPosicoes *PaginaPrivada(RedeVersionada *rede, TabelaVersao *t, size_t i) {
+    PaginaPosicoes *pagina = PAGINA(t, i);
+    if (pagina->versao == rede->rascunho->numero) return pagina;
+
+    PaginaPosicoes *copia = (PaginaPosicoes *)malloc(sizeof(PaginaPosicoes));
+    if (!copia) return NULL;
+
+    memcpy(copia, pagina, sizeof(PaginaPosicoes));
+    copia->versao = rede->rascunho->numero;
+    Retirar(rede, pagina);
+    PAGINA(t, i) = copia;
+    return copia;
+}
+
+/**
+ * @brief Insere uma posição nova na tabela do rascunho.
+ */
+static bool InserirPosicao(RedeVersionada *rede, Coordenada x, Coordenada y, uint64_t valor) {
+    TabelaVersao *t = TabelaPrivada(rede, rede->rascunho->posicoes->tamanho + 1);
+    if (!t) return false;
+
+    size_t i = ProcurarPosicao(t, x, y);
+    PaginaPosicoes *p = PaginaPrivada(rede, t, i);
+    if (!p) return false;
+
+    p->ocupado[INDICE(i)] = true;
+    p->x[INDICE(i)] = x;
+    p->y[INDICE(i)] = y;
+    p->valores[INDICE(i)] = valor;
+    t->tamanho++;
+    return true;
+}
+
+/**
+ * @brief Torna privadas as páginas que a remoção de (x, y) e a mudança de índice de (ux, uy) vão alterar,
+ * para que essas alterações já não possam falhar a meio.
+ */
+static bool PrepararRemocao(RedeVersionada *rede, Coordenada x, Coordenada y, Coordenada ux, Coordenada uy) {
+    TabelaVersao *t = TabelaPrivada(rede, 0);
+    if (!t || !PaginaPrivada(rede, t, ProcurarPosicao(t, ux, uy))) return false;
+
+    // A remoção pode deslocar qualquer elemento da sequência até à primeira posição livre
+    size_t mascara = t->capacidade - 1;
+    for (size_t i = ProcurarPosicao(t, x, y); PAGINA(t, i)->ocupado[INDICE(i)]; i = (i + 1) & mascara) {
+        if (!PaginaPrivada(rede, t, i)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Remove uma posição de uma tabela cujas páginas já foram preparadas com PrepararRemocao.
+ */
+static void RemoverPosicao(TabelaVersao *t, Coordenada x, Coordenada y) {
+    size_t mascara = t->capacidade - 1;
+    size_t livre = ProcurarPosicao(t, x, y);
+
+    for (size_t j = (livre + 1) & mascara; PAGINA(t, j)->ocupado[INDICE(j)]; j = (j + 1) & mascara) {
+        PaginaPosicoes *pj = PAGINA(t, j);
+        size_t ideal = Dispersar(pj->x[INDICE(j)], pj->y[INDICE(j)], t->capacidade);
+        // O elemento em j só pode ocupar a posição livre se esta estiver entre ideal e j (circularmente)
+        if (((j - ideal) & mascara) >= ((j - livre) & mascara)) {
+            PaginaPosicoes *pl = PAGINA(t, livre);
+            pl->x[INDICE(livre)] = pj->x[INDICE(j)];
+            pl->y[INDICE(livre)] = pj->y[INDICE(j)];
+            pl->valores[INDICE(livre)] = pj->valores[INDICE(j)];
+            livre = j;
+        }
+    }
+    PAGINA(t, livre)->ocupado[INDICE(livre)] = false;
+    t->tamanho--;
+}
+
+/**
+ * @brief Liberta uma tabela e todas as suas páginas.
+ */
+static void LiberarTabelaVersao(TabelaVersao *t) {
+    if (!t) return;
+    for (size_t p = 0; p < t->numPaginas; p++) free(t->paginas[p]);
+    free(t);
+}
+
+#pragma endregion
+
+#pragma region Escritores
+
+/**
+ * @brief Devolve uma cópia privada do rascunho das antenas de um tipo, com espaço para pelo menos
+ * `blocos` blocos. Se o tipo ainda não existe, é criado vazio.
+ */
+static TipoVersao *TipoPrivado(RedeVersionada *rede, unsigned char tipo, size_t blocos) {
+    VersaoRede *r = rede->rascunho;
+    TipoVersao *atual = r->tipos[tipo];
+
+    if (atual && atual->versao == r->numero && atual->capacidadeBlocos >= blocos)
+        return atual;
+
+    size_t capacidade = atual ? atual->capacidadeBlocos : 0;
+    if (capacidade < 4) capacidade = 4;
+    while (capacidade < blocos) capacidade *= 2;
+
+    TipoVersao *novo;
+    if (atual && atual->versao == r->numero) {
+        // Ainda não publicado: pode crescer no lugar
+        novo = (TipoVersao *)realloc(atual, sizeof(TipoVersao) + capacidade * sizeof(BlocoAntenas *));
+        if (!novo) return NULL;
+    } else {
+        novo = (TipoVersao *)malloc(sizeof(TipoVersao) + capacidade * sizeof(BlocoAntenas *));
+        if (!novo) return NULL;
+
+        novo->versao = r->numero;
+        novo->tipo = (char)tipo;
+        novo->quantidade = atual ? atual->quantidade : 0;
+        novo->numBlocos = atual ? atual->numBlocos : 0;
+        if (atual) {
+            memcpy(novo->blocos, atual->blocos, atual->numBlocos * sizeof(BlocoAntenas *));
+            Retirar(rede, atual);
+        }
+    }
+
+    novo->capacidadeBlocos = capacidade;
+    r->tipos[tipo] = novo;
+    return novo;
+}
+
+/**
+ * @brief Devolve uma cópia privada do bloco b de um tipo já privado.
+ */
+static BlocoAntenas *BlocoPrivado(RedeVersionada *rede, TipoVersao *tv, size_t b) {
+    BlocoAntenas *bloco = tv->blocos[b];
+    if (bloco->versao == rede->rascunho->numero) return bloco;
+
+    BlocoAntenas *copia = (BlocoAntenas *)malloc(sizeof(BlocoAntenas));
+    if (!copia) return NULL;
+
+    memcpy(copia, bloco, sizeof(BlocoAntenas));
+    copia->versao = rede->rascunho->numero;
+    Retirar(rede, bloco);
+    tv->blocos[b] = copia;
+    return copia;
+}
+
+/**
+ * @brief Começa a preparar uma nova versão a partir da versão publicada.
+ * 
+ * Bloqueia outros escritores até PublicarEdicao; os leitores continuam sem esperar.
+ * 
+ * @param rede Rede versionada.
+ * @return true Se o rascunho foi criado.
+ */
+bool IniciarEdicao(RedeVersionada *rede) {
+    pthread_mutex_lock(&rede->escrita);
+
+    VersaoRede *rascunho = (VersaoRede *)malloc(sizeof(VersaoRede));
+    if (!rascunho) {
+        pthread_mutex_unlock(&rede->escrita);
+        return false;
+    }
+
+    memcpy(rascunho, atomic_load(&rede->atual), sizeof(VersaoRede));
+    rascunho->numero++;
+    rede->rascunho = rascunho;
+    return true;
+}
+
+/**
+ * @brief Insere uma antena no rascunho.
+ * 
+ * @param rede Rede versionada com uma edição iniciada.
+ * @param frequencia Frequência da antena.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return true Se a antena foi inserida; false se a posição está ocupada, fora de ±COORDENADA_MAX ou faltou memória.
+ */
+bool InserirAntenaVersao(RedeVersionada *rede, char frequencia, Coordenada x, Coordenada y) {
+    if (!rede->rascunho || !COORDENADA_VALIDA(x) || !COORDENADA_VALIDA(y)) return false;
+
+    if (ProcurarPosicaoVersao(rede->rascunho->posicoes, x, y, NULL)) return false;
+
+    unsigned char t = (unsigned char)frequencia % NUM_TIPOS;
+    TipoVersao *atual = rede->rascunho->tipos[t];
+    size_t q = atual ? atual->quantidade : 0;
+
+    TipoVersao *tv = TipoPrivado(rede, t, q / ANTENAS_POR_BLOCO + 1);
+    if (!tv) return false;
+
+    BlocoAntenas *bloco;
+    if (q % ANTENAS_POR_BLOCO == 0) {
+        bloco = (BlocoAntenas *)malloc(sizeof(BlocoAntenas));
+        if (!bloco) return false;
+        bloco->versao = rede->rascunho->numero;
+        tv->blocos[tv->numBlocos++] = bloco;
+    } else {
+        bloco = BlocoPrivado(rede, tv, q / ANTENAS_POR_BLOCO);
+        if (!bloco) return false;
+    }
+
+    if (!InserirPosicao(rede, x, y, ((uint64_t)t << 32) | q)) {
+        if (q % ANTENAS_POR_BLOCO == 0) free(tv->blocos[--tv->numBlocos]);
+        return false;
+    }
+
+    bloco->x[q % ANTENAS_POR_BLOCO] = x;
+    bloco->y[q % ANTENAS_POR_BLOCO] = y;
+    tv->quantidade++;
+    rede->rascunho->totalAntenas++;
+    return true;
+}
+
+/**
+ * @brief Remove uma antena do rascunho. A última antena do tipo passa para o lugar da removida.
+ * 
+ * @param rede Rede versionada com uma edição iniciada.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @return true Se a antena foi removida; false se não existia ou faltou memória.
+ */
+bool RemoverAntenaVersao(RedeVersionada *rede, Coordenada x, Coordenada y) {
+    if (!rede->rascunho) return false;
+
+    uint64_t valor;
+    if (!ProcurarPosicaoVersao(rede->rascunho->posicoes, x, y, &valor)) return false;
+
+    unsigned char t = (unsigned char)(valor >> 32);
+    size_t i = (size_t)(uint32_t)valor;
+
+    TipoVersao *tv = TipoPrivado(rede, t, rede->rascunho->tipos[t]->numBlocos);
+    if (!tv) return false;
+
+    size_t ultimo = tv->quantidade - 1;
+    BlocoAntenas *destino = NULL;
+    Coordenada ux = x, uy = y;
+    if (i != ultimo) {
+        destino = BlocoPrivado(rede, tv, i / ANTENAS_POR_BLOCO);
+        if (!destino) return false;
+
+        BlocoAntenas *origem = tv->blocos[ultimo / ANTENAS_POR_BLOCO];
+        ux = origem->x[ultimo % ANTENAS_POR_BLOCO];
+        uy = origem->y[ultimo % ANTENAS_POR_BLOCO];
+    }
+
+    // Daqui em diante nada pode falhar
+    if (!PrepararRemocao(rede, x, y, ux, uy)) return false;
+
+    TabelaVersao *posicoes = rede->rascunho->posicoes;
+    if (destino) {
+        destino->x[i % ANTENAS_POR_BLOCO] = ux;
+        destino->y[i % ANTENAS_POR_BLOCO] = uy;
+
+        size_t j = ProcurarPosicao(posicoes, ux, uy);
+        PAGINA(posicoes, j)->valores[INDICE(j)] = ((uint64_t)t << 32) | i;
+    }
+
+    RemoverPosicao(posicoes, x, y);
+    tv->quantidade--;
+    rede->rascunho->totalAntenas--;
+
+    // O último bloco ficou vazio
+    if (tv->quantidade % ANTENAS_POR_BLOCO == 0) {
+        BlocoAntenas *vazio = tv->blocos[--tv->numBlocos];
+        if (vazio->versao == rede->rascunho->numero) free(vazio);
+        else Retirar(rede, vazio);
+    }
+
+    if (tv->quantidade == 0) {
+        free(tv); // Privado ao rascunho, nenhum leitor o viu
+        rede->rascunho->tipos[t] = NULL;
+    }
+    return true;
+}
+
+/**
+ * @brief Publica o rascunho como versão atual e liberta o que os leitores já não podem usar.
+ * 
+ * @param rede Rede versionada com uma edição iniciada.
+ */
+void PublicarEdicao(RedeVersionada *rede) {
+    if (!rede->rascunho) return;
+
+    VersaoRede *antiga = atomic_load(&rede->atual);
+    atomic_store(&rede->atual, rede->rascunho);
+    Retirar(rede, antiga);
+
+    // Os leitores que fixarem uma época posterior já veem a nova versão
+    uint64_t epoca = atomic_fetch_add(&rede->epoca, 1);
+    while (rede->retiradosRascunho) {
+        ObjetoRetirado *r = rede->retiradosRascunho;
+        rede->retiradosRascunho = r->proximo;
+        r->epoca = epoca;
+        r->proximo = rede->pendentes;
+        rede->pendentes = r;
+    }
+
+    rede->rascunho = NULL;
+    Reclamar(rede);
+    pthread_mutex_unlock(&rede->escrita);
+}
+
+#pragma endregion
+
+#pragma region Criação e libertação
+
+/**
+ * @brief Cria uma rede versionada com as antenas de uma lista de tipos (a lista não é alterada).
+ * 
+ * @param listaTipos Lista de tipos de antenas (pode ser NULL).
+ * @return RedeVersionada* Rede com a versão inicial publicada, ou NULL em caso de erro.
+ */
+RedeVersionada *CriarRedeVersionada(TipoAntena *listaTipos) {
+    // sizeof(RedeVersionada) já é múltiplo do alinhamento, como aligned_alloc exige
+    RedeVersionada *rede = (RedeVersionada *)aligned_alloc(_Alignof(RedeVersionada), sizeof(RedeVersionada));
+    if (!rede) return NULL;
+    memset(rede, 0, sizeof(RedeVersionada));
+
+    VersaoRede *vazia = (VersaoRede *)calloc(1, sizeof(VersaoRede));
+    if (vazia) vazia->posicoes = CriarTabelaVersao(0, 0);
+    if (!vazia || !vazia->posicoes || pthread_mutex_init(&rede->escrita, NULL) != 0) {
+        if (vazia) LiberarTabelaVersao(vazia->posicoes);
+        free(vazia);
+        free(rede);
+        return NULL;
+    }
+
+    atomic_init(&rede->atual, vazia);
+    atomic_init(&rede->epoca, 1);
+    for (int i = 0; i < MAX_LEITORES; i++) {
+        atomic_init(&rede->leitores[i].epoca, 0);
+        atomic_init(&rede->leitores[i].ocupado, false);
+    }
+
+    if (!IniciarEdicao(rede)) {
+        LiberarRedeVersionada(rede);
+        return NULL;
+    }
+    for (TipoAntena *tipo = listaTipos; tipo; tipo = tipo->proximo) {
+        for (Antena *a = tipo->listaAntenas; a; a = a->proximo)
+            InserirAntenaVersao(rede, a->frequencia, a->x, a->y);
+    }
+    PublicarEdicao(rede);
+    return rede;
+}
+
+/**
+ * @brief Liberta a rede versionada. Não pode haver leitores nem escritores ativos.
+ * 
+ * @param rede Rede versionada.
+ */
+void LiberarRedeVersionada(RedeVersionada *rede) {
+    if (!rede) return;
+
+    if (rede->rascunho) PublicarEdicao(rede);
+
+    while (rede->pendentes) {
+        ObjetoRetirado *r = rede->pendentes;
+        rede->pendentes = r->proximo;
+        free(r->ponteiro);
+        free(r);
+    }
+
+    VersaoRede *v = atomic_load(&rede->atual);
+    for (int t = 0; t < NUM_TIPOS; t++) {
+        if (!v->tipos[t]) continue;
+        for (size_t b = 0; b < v->tipos[t]->numBlocos; b++) free(v->tipos[t]->blocos[b]);
+        free(v->tipos[t]);
+    }
+    LiberarTabelaVersao(v->posicoes);
+    free(v);
+
+    pthread_mutex_destroy(&rede->escrita);
+    free(rede);
+}
+
+#pragma endregion
+
+#pragma region Consultas
+
+/**
+ * @brief Procura uma antena numa versão.
+ * 
+ * @param v Versão fixada.
+ * @param x Coordenada X.
+ * @param y Coordenada Y.
+ * @param frequencia Recebe a frequência da antena encontrada (pode ser NULL).
+ * @return true Se existe uma antena na posição.
+ */
+bool ProcurarAntenaVersao(const VersaoRede *v, Coordenada x, Coordenada y, char *frequencia) {
+    uint64_t valor;
+    if (!ProcurarPosicaoVersao(v->posicoes, x, y, &valor)) return false;
+
+    if (frequencia) *frequencia = v->tipos[(unsigned char)(valor >> 32)]->tipo;
+    return true;
+}
+
+/**
+ * @brief Calcula as posições distintas com efeito nefasto numa versão.
+ * 
+ * @param v Versão fixada.
+ * @param maxLin Número de linhas da matriz (<= 0 para não limitar).
+ * @param maxCol Número de colunas da matriz (<= 0 para não limitar).
+ * @return EfeitoNefasto* Lista ordenada por (x, y), ou NULL se não houver efeitos ou faltar memória.
+ */
+EfeitoNefasto *CalcularEfeitosVersao(const VersaoRede *v, Coordenada maxLin, Coordenada maxCol) {
+    size_t numPares = 0;
+    for (int t = 0; t < NUM_TIPOS; t++) {
+        if (v->tipos[t]) numPares += v->tipos[t]->quantidade * (v->tipos[t]->quantidade - 1) / 2;
+    }
+
+    AcumuladorEfeitos efeitos;
+    if (!IniciarAcumuladorEfeitos(&efeitos, maxLin, maxCol, numPares)) return NULL;
+
+    bool ok = true;
+    for (int t = 0; ok && t < NUM_TIPOS; t++) {
+        const TipoVersao *tv = v->tipos[t];
+        if (!tv) continue;
+
+        for (size_t i = 0; ok && i < tv->quantidade; i++) {
+            const BlocoAntenas *bi = tv->blocos[i / ANTENAS_POR_BLOCO];
+            Coordenada x1 = bi->x[i % ANTENAS_POR_BLOCO], y1 = bi->y[i % ANTENAS_POR_BLOCO];
+
+            for (size_t j = i + 1; ok && j < tv->quantidade; j++) {
+                const BlocoAntenas *bj = tv->blocos[j / ANTENAS_POR_BLOCO];
+                ok = AcumularEfeitosPar(&efeitos, x1, y1, bj->x[j % ANTENAS_POR_BLOCO], bj->y[j % ANTENAS_POR_BLOCO]);
+            }
+        }
+    }
+
+    EfeitoNefasto *lista = ok ? ListaEfeitosAcumulados(&efeitos) : NULL;
+    LiberarAcumuladorEfeitos(&efeitos);
+    return lista;
+}
+
+/**
+ * @brief BFS a partir de uma antena numa versão.
+ * 
+ * Como as antenas do mesmo tipo estão todas interligadas, a BFS visita a antena inicial e depois,
+ * no nível seguinte, as restantes antenas do tipo pela ordem em que estão guardadas.
+ * 
+ * @param v Versão fixada.
+ * @param x Coordenada X inicial.
+ * @param y Coordenada Y inicial.
+ * @return ResultadoDFS* Lista com a ordem de visita (o campo antena fica a NULL), ou NULL se a antena não existe.
+ */
+ResultadoDFS *BuscaEmLarguraVersao(const VersaoRede *v, Coordenada x, Coordenada y) {
+    uint64_t valor;
+    if (!ProcurarPosicaoVersao(v->posicoes, x, y, &valor)) return NULL;
+
+    const TipoVersao *tv = v->tipos[(unsigned char)(valor >> 32)];
+    size_t inicial = (size_t)(uint32_t)valor;
+    ResultadoDFS *lista = (ResultadoDFS *)malloc(sizeof(ResultadoDFS));
+    if (!lista) return NULL;
+
+    lista->x = x;
+    lista->y = y;
+    lista->antena = NULL;
+    lista->proximo = NULL;
+
+    ResultadoDFS *cauda = lista;
+    for (size_t i = 0; i < tv->quantidade; i++) {
+        if (i == inicial) continue;
+
+        const BlocoAntenas *b = tv->blocos[i / ANTENAS_POR_BLOCO];
+        Coordenada ax = b->x[i % ANTENAS_POR_BLOCO], ay = b->y[i % ANTENAS_POR_BLOCO];
+
+        ResultadoDFS *novo = (ResultadoDFS *)malloc(sizeof(ResultadoDFS));
+        if (!novo) {
+            LiberarResultados(lista);
+            return NULL;
+        }
+        novo->x = ax;
+        novo->y = ay;
+        novo->antena = NULL;
+        novo->proximo = NULL;
+        cauda->proximo = novo;
+        cauda = novo;
+    }
+    return lista;
+}
+
+#pragma endregion